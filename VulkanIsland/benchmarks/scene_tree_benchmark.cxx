@@ -0,0 +1,108 @@
+// Updates world matrices of whole synthetic scene trees on an increasing number of threads.
+// Usage: scene_tree_benchmark [frames number]
+
+#include <chrono>
+#include <thread>
+
+#include "scene_tree.hxx"
+
+namespace {
+struct tree_shape_t {
+    std::string name;
+
+    // Children number of each node in the consecutive layers.
+    std::vector<std::size_t> fanouts;
+};
+
+// Parent indices of the tree nodes, the nodes of a layer are attached to the previous layer ones in turns.
+std::vector<std::int32_t> CreateParents(std::vector<std::size_t> const &fanouts)
+{
+    std::vector<std::int32_t> parents;
+
+    std::int32_t layerBegin = -1, layerEnd = 0;
+
+    for (auto fanout : fanouts) {
+        auto const parentsNumber = layerBegin < 0 ? 1 : layerEnd - layerBegin;
+
+        for (std::int32_t i = 0; i < parentsNumber * static_cast<std::int32_t>(fanout); ++i)
+            parents.push_back(layerBegin < 0 ? -1 : layerBegin + i % parentsNumber);
+
+        layerBegin = layerEnd;
+        layerEnd = static_cast<std::int32_t>(std::size(parents));
+    }
+
+    return parents;
+}
+
+// Marking the root dirty updates the whole tree.
+float MeasureUpdate(SceneTree &tree, JobSystem *jobSystem, std::size_t framesNumber)
+{
+    tree.SetLocalMatrix(tree.root(), glm::mat4{1.f});
+    tree.Update(jobSystem);
+
+    float time = 0.f;
+
+    for (std::size_t frame = 0; frame < framesNumber; ++frame) {
+        tree.SetLocalMatrix(tree.root(), glm::translate(glm::mat4{1.f}, glm::vec3{static_cast<float>(frame), 0.f, 0.f}));
+
+        auto const start = std::chrono::high_resolution_clock::now();
+
+        tree.Update(jobSystem);
+
+        time += std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    return time / static_cast<float>(framesNumber);
+}
+}
+
+int main(int argc, char **argv)
+{
+    auto const framesNumber = argc > 1 ? static_cast<std::size_t>(std::stoul(argv[1])) : 10u;
+
+    auto const hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    std::vector<std::size_t> threadsNumbers;
+
+    for (std::size_t threadsNumber = 1; threadsNumber < hardwareThreads; threadsNumber *= 2)
+        threadsNumbers.push_back(threadsNumber);
+
+    threadsNumbers.push_back(hardwareThreads);
+
+    std::vector<tree_shape_t> shapes{
+        {"wide: 1000 x 1000 children"s, {1000, 1000}},
+        {"binary: 19 layers"s, std::vector<std::size_t>(19, 2)},
+        {"deep: 1024 chains of 1024 nodes"s, {1024}}
+    };
+
+    shapes.back().fanouts.resize(1024, 1);
+
+    for (auto &&shape : shapes) {
+        SceneTree tree;
+
+        auto const parents = CreateParents(shape.fanouts);
+        std::vector<glm::mat4> localMatrices(std::size(parents), glm::translate(glm::mat4{1.f}, glm::vec3{1.f, 0.f, 0.f}));
+
+        auto const start = std::chrono::high_resolution_clock::now();
+
+        if (!tree.BuildHierarchy(parents, { }, localMatrices))
+            return 1;
+
+        auto const buildTime = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - start).count();
+
+        std::cout << shape.name << ", "s << std::size(parents) + 1 << " nodes, "s << std::size(shape.fanouts) + 1 << " layers\n"s;
+        std::cout << "    build: "s << buildTime << " ms\n"s;
+
+        auto const serialTime = MeasureUpdate(tree, nullptr, framesNumber);
+
+        std::cout << "    serial: "s << serialTime << " ms\n"s;
+
+        for (auto threadsNumber : threadsNumbers) {
+            JobSystem jobSystem{threadsNumber};
+
+            auto const time = MeasureUpdate(tree, &jobSystem, framesNumber);
+
+            std::cout << "    "s << threadsNumber << " threads: "s << time << " ms, "s << serialTime / time << "x\n"s;
+        }
+    }
+}
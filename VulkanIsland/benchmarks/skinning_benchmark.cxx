@@ -0,0 +1,234 @@
+// Animates and skins a crowd of characters sharing one skeleton, mesh and animation, the skeletons are posed through a scene tree.
+// Usage: skinning_benchmark [characters number] [frames number]
+// The vector width of the skinning kernel follows the compiler target, e.g. '-mavx2 -mfma' enables the AVX2 one.
+
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <random>
+
+#include "animation.hxx"
+#include "job_system.hxx"
+#include "skinning.hxx"
+
+namespace {
+auto constexpr kJOINTS_NUMBER = 64u;
+auto constexpr kVERTICES_NUMBER = 2048u;
+auto constexpr kKEYS_NUMBER = 30u;
+
+auto constexpr kFRAME_TIME = 1.f / 60.f;
+
+struct character_t {
+    // Scene tree nodes of the skeleton nodes.
+    std::vector<NodeHandle> nodeHandles;
+
+    std::vector<glm::mat4> palette;
+
+    std::vector<float> skinnedPositions, skinnedNormals;
+};
+
+// Mesh node followed by the joints: every joint is attached to one of the previous ones.
+std::vector<scene_node_t> CreateSkeleton(std::mt19937 &generator)
+{
+    std::vector<scene_node_t> nodes(kJOINTS_NUMBER + 1);
+
+    nodes[0].name = "mesh"s;
+    nodes[0].skin = 0;
+
+    for (auto i = 1u; i <= kJOINTS_NUMBER; ++i) {
+        auto &&node = nodes[i];
+
+        node.name = "joint"s + std::to_string(i);
+        node.parent = i == 1 ? 0 : static_cast<std::int32_t>(std::uniform_int_distribution<std::uint32_t>{1, i - 1}(generator));
+        node.translation = glm::vec3{0.f, .1f, 0.f};
+        node.localMatrix = glm::translate(glm::mat4{1.f}, node.translation);
+        node.posed = true;
+    }
+
+    return nodes;
+}
+
+// Every joint is rotated by the linearly interpolated keys, the root joint is translated as well.
+scene_animation_t CreateAnimation(std::mt19937 &generator)
+{
+    std::uniform_real_distribution<float> distribution{-1.f, 1.f};
+
+    scene_animation_t animation;
+    animation.name = "walk"s;
+
+    std::vector<float> times(kKEYS_NUMBER);
+
+    for (auto i = 0u; i < kKEYS_NUMBER; ++i)
+        times[i] = static_cast<float>(i) / 10.f;
+
+    animation.duration = times.back();
+
+    for (auto joint = 1u; joint <= kJOINTS_NUMBER; ++joint) {
+        animation_sampler_t sampler;
+
+        sampler.times = times;
+        sampler.components = 4;
+
+        for (auto i = 0u; i < kKEYS_NUMBER; ++i) {
+            auto const rotation = glm::normalize(glm::quat{1.f, distribution(generator) * .2f, distribution(generator) * .2f, distribution(generator) * .2f});
+            sampler.values.insert(std::end(sampler.values), {rotation.x, rotation.y, rotation.z, rotation.w});
+        }
+
+        animation.channels.push_back(animation_channel_t{static_cast<std::uint32_t>(std::size(animation.samplers)), joint, eANIMATION_PATH::nROTATION});
+        animation.samplers.push_back(std::move(sampler));
+    }
+
+    animation_sampler_t sampler;
+
+    sampler.times = times;
+
+    for (auto i = 0u; i < kKEYS_NUMBER; ++i)
+        sampler.values.insert(std::end(sampler.values), {distribution(generator), 0.f, static_cast<float>(i) * .1f});
+
+    animation.channels.push_back(animation_channel_t{static_cast<std::uint32_t>(std::size(animation.samplers)), 1, eANIMATION_PATH::nTRANSLATION});
+    animation.samplers.push_back(std::move(sampler));
+
+    return animation;
+}
+
+template<class F>
+float Measure(F &&function)
+{
+    auto const start = std::chrono::high_resolution_clock::now();
+
+    function();
+
+    return std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - start).count();
+}
+}
+
+int main(int argc, char **argv)
+{
+    auto const charactersNumber = argc > 1 ? static_cast<std::size_t>(std::stoul(argv[1])) : 2000u;
+    auto const framesNumber = argc > 2 ? static_cast<std::size_t>(std::stoul(argv[2])) : 10u;
+
+    std::mt19937 generator{42};
+
+    auto const nodes = CreateSkeleton(generator);
+    auto const animation = CreateAnimation(generator);
+
+    scene_skin_t skin;
+
+    for (auto joint = 1u; joint <= kJOINTS_NUMBER; ++joint)
+        skin.joints.push_back(joint);
+
+    skin.inverseBindMatrices.assign(kJOINTS_NUMBER, glm::mat4{1.f});
+
+    std::vector<float> positions(kVERTICES_NUMBER * 3), normals(kVERTICES_NUMBER * 3), weights(kVERTICES_NUMBER * 4);
+    std::vector<std::uint16_t> joints(kVERTICES_NUMBER * 4);
+
+    {
+        std::uniform_real_distribution<float> distribution{0.f, 1.f};
+        std::uniform_int_distribution<std::uint16_t> jointDistribution{0, kJOINTS_NUMBER - 1};
+
+        std::generate(std::begin(positions), std::end(positions), [&] { return distribution(generator); });
+        std::generate(std::begin(normals), std::end(normals), [&] { return distribution(generator); });
+        std::generate(std::begin(joints), std::end(joints), [&] { return jointDistribution(generator); });
+
+        for (auto vertex = 0u; vertex < kVERTICES_NUMBER; ++vertex) {
+            auto const vertexWeights = std::next(std::begin(weights), vertex * 4);
+
+            std::generate_n(vertexWeights, 4, [&] { return distribution(generator); });
+
+            auto const sum = std::accumulate(vertexWeights, std::next(vertexWeights, 4), 0.f);
+            std::transform(vertexWeights, std::next(vertexWeights, 4), vertexWeights, [sum] (auto weight) { return weight / sum; });
+        }
+    }
+
+    std::vector<AnimationPlayer> players;
+    std::vector<character_t> characters(charactersNumber);
+
+    // The worker threads are spawned once and reused by every frame.
+    JobSystem singleThread{1}, allThreads;
+
+    // The skeletons of all the characters are subtrees of a single scene tree updated once per frame.
+    SceneTree tree;
+
+    {
+        std::vector<std::int32_t> parents;
+        std::vector<glm::mat4> localMatrices;
+
+        for (std::size_t i = 0; i < charactersNumber; ++i) {
+            auto const first = static_cast<std::int32_t>(i * std::size(nodes));
+
+            for (auto &&node : nodes) {
+                parents.push_back(node.parent < 0 ? -1 : first + node.parent);
+                localMatrices.push_back(node.posed ? glm::mat4{1.f} : node.localMatrix);
+            }
+        }
+
+        auto handles = tree.BuildHierarchy(parents, { }, localMatrices);
+
+        if (!handles) {
+            std::cerr << "failed to build the characters scene tree\n"s;
+            return 1;
+        }
+
+        for (std::size_t i = 0; i < charactersNumber; ++i) {
+            auto const first = std::next(std::cbegin(*handles), static_cast<std::ptrdiff_t>(i * std::size(nodes)));
+
+            characters[i].nodeHandles.assign(first, std::next(first, static_cast<std::ptrdiff_t>(std::size(nodes))));
+
+            for (std::size_t index = 0; index < std::size(nodes); ++index)
+                if (auto &&node = nodes[index]; node.posed)
+                    tree.SetLocalPose(characters[i].nodeHandles[index], node_pose_t{node.translation, node.rotation, node.scale});
+        }
+    }
+
+    std::vector<skinned_mesh_t> meshes;
+
+    for (auto &&character : characters) {
+        players.emplace_back(nodes, animation);
+
+        character.skinnedPositions.resize(std::size(positions));
+        character.skinnedNormals.resize(std::size(normals));
+
+        meshes.push_back(skinned_mesh_t{
+            kVERTICES_NUMBER, std::data(positions), std::data(normals), std::data(joints), std::data(weights),
+            nullptr, std::data(character.skinnedPositions), std::data(character.skinnedNormals)
+        });
+    }
+
+    float animationTime = 0.f, singleThreadedTime = 0.f, multiThreadedTime = 0.f;
+
+    for (std::size_t frame = 0; frame < framesNumber; ++frame) {
+        animationTime += Measure([&]
+        {
+            for (std::size_t i = 0; i < charactersNumber; ++i) {
+                // Characters are out of step to not share the cached keys pattern.
+                players[i].Sample(static_cast<float>(frame) * kFRAME_TIME + static_cast<float>(i) * .01f);
+                players[i].ApplyPoses(tree, characters[i].nodeHandles);
+            }
+
+            tree.Update(&allThreads);
+
+            for (std::size_t i = 0; i < charactersNumber; ++i) {
+                auto &&character = characters[i];
+
+                auto const meshWorldMatrix = tree.GetWorldMatrix(character.nodeHandles[0]).value_or(glm::mat4{1.f});
+
+                ComputeJointPalette(skin, tree, character.nodeHandles, meshWorldMatrix, character.palette);
+
+                meshes[i].palette = std::data(character.palette);
+            }
+        });
+
+        singleThreadedTime += Measure([&] { SkinMeshes(singleThread, meshes); });
+        multiThreadedTime += Measure([&] { SkinMeshes(allThreads, meshes); });
+    }
+
+    auto const frames = static_cast<float>(framesNumber);
+    auto const vertices = static_cast<float>(charactersNumber * kVERTICES_NUMBER);
+
+    std::cout << charactersNumber << " characters, "s << kJOINTS_NUMBER << " joints, "s << kVERTICES_NUMBER << " vertices each\n"s;
+    std::cout << "animation sampling and palettes: "s << animationTime / frames << " ms per frame\n"s;
+    std::cout << "skinning on a single thread: "s << singleThreadedTime / frames << " ms per frame, "s;
+    std::cout << vertices * frames / singleThreadedTime / 1000.f << " Mvertices/s\n"s;
+    std::cout << "skinning on all threads: "s << multiThreadedTime / frames << " ms per frame, "s;
+    std::cout << vertices * frames / multiThreadedTime / 1000.f << " Mvertices/s\n"s;
+}
@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <cmath>
+
+#include "animation.hxx"
+
+namespace {
+// Samples the key values of the sampler at 'time' lying after the 'key' one, rotations are spherically interpolated.
+void SampleValue(animation_sampler_t const &sampler, std::size_t key, float time, bool rotation, float *value)
+{
+    auto const components = static_cast<std::size_t>(sampler.components);
+
+    auto const cubic = sampler.interpolation == eINTERPOLATION::nCUBIC_SPLINE;
+    auto const stride = components * (cubic ? 3 : 1);
+
+    // Cubic-spline key values are preceded by the in-tangents and followed by the out-tangents.
+    auto const values = std::data(sampler.values);
+    auto const keyValue = [values, stride, cubic, components] (std::size_t k) { return values + k * stride + (cubic ? components : 0); };
+
+    if (key + 1 >= std::size(sampler.times) || time <= sampler.times[key] || sampler.interpolation == eINTERPOLATION::nSTEP) {
+        std::copy_n(keyValue(key), components, value);
+        return;
+    }
+
+    auto const delta = sampler.times[key + 1] - sampler.times[key];
+    auto const t = (time - sampler.times[key]) / delta;
+
+    auto const v0 = keyValue(key);
+    auto const v1 = keyValue(key + 1);
+
+    if (cubic) {
+        auto const t2 = t * t;
+        auto const t3 = t2 * t;
+
+        auto const outTangent = v0 + components;
+        auto const inTangent = v1 - components;
+
+        for (std::size_t i = 0; i < components; ++i) {
+            value[i] = (2.f * t3 - 3.f * t2 + 1.f) * v0[i] + (t3 - 2.f * t2 + t) * delta * outTangent[i] +
+                       (-2.f * t3 + 3.f * t2) * v1[i] + (t3 - t2) * delta * inTangent[i];
+        }
+    }
+
+    else if (rotation) {
+        auto const q = glm::slerp(glm::quat{v0[3], v0[0], v0[1], v0[2]}, glm::quat{v1[3], v1[0], v1[1], v1[2]}, t);
+
+        value[0] = q.x;
+        value[1] = q.y;
+        value[2] = q.z;
+        value[3] = q.w;
+    }
+
+    else for (std::size_t i = 0; i < components; ++i)
+        value[i] = v0[i] + (v1[i] - v0[i]) * t;
+}
+}
+
+std::size_t FindAnimationKey(std::vector<float> const &times, float time, std::size_t cachedKey) noexcept
+{
+    auto const keysNumber = std::size(times);
+
+    if (cachedKey + 1 < keysNumber && times[cachedKey] <= time) {
+        if (time < times[cachedKey + 1])
+            return cachedKey;
+
+        if (cachedKey + 2 >= keysNumber || time < times[cachedKey + 2])
+            return cachedKey + 1;
+    }
+
+    auto const it = std::upper_bound(std::cbegin(times), std::cend(times), time);
+
+    return it == std::cbegin(times) ? 0 : static_cast<std::size_t>(std::distance(std::cbegin(times), it)) - 1;
+}
+
+AnimationPlayer::AnimationPlayer(std::vector<scene_node_t> const &nodes, scene_animation_t const &animation)
+    : animation_{&animation}, animatedNodes_(std::size(nodes), 0), channelKeys_(std::size(animation.channels), 0)
+{
+    std::transform(std::cbegin(nodes), std::cend(nodes), std::back_inserter(poses_), [] (auto &&node)
+    {
+        return node_pose_t{node.translation, node.rotation, node.scale};
+    });
+
+    for (auto &&channel : animation.channels)
+        if (channel.node < std::size(animatedNodes_))
+            animatedNodes_[channel.node] = 1;
+}
+
+void AnimationPlayer::Sample(float time)
+{
+    if (auto const duration = animation_->duration; duration > 0.f) {
+        time = std::fmod(time, duration);
+
+        if (time < 0.f)
+            time += duration;
+    }
+
+    auto &&channels = animation_->channels;
+
+    for (std::size_t i = 0; i < std::size(channels); ++i) {
+        auto &&channel = channels[i];
+        auto &&sampler = animation_->samplers[channel.sampler];
+
+        if (channel.node >= std::size(poses_) || std::empty(sampler.times))
+            continue;
+
+        auto const key = FindAnimationKey(sampler.times, time, channelKeys_[i]);
+        channelKeys_[i] = key;
+
+        std::array<float, 4> value;
+
+        SampleValue(sampler, key, time, channel.path == eANIMATION_PATH::nROTATION, std::data(value));
+
+        auto &&pose = poses_[channel.node];
+
+        switch (channel.path) {
+            case eANIMATION_PATH::nTRANSLATION:
+                pose.translation = glm::vec3{value[0], value[1], value[2]};
+                break;
+
+            case eANIMATION_PATH::nROTATION:
+                pose.rotation = glm::normalize(glm::quat{value[3], value[0], value[1], value[2]});
+                break;
+
+            case eANIMATION_PATH::nSCALE:
+                pose.scale = glm::vec3{value[0], value[1], value[2]};
+                break;
+        }
+    }
+}
+
+void AnimationPlayer::ApplyPoses(SceneTree &tree, std::vector<NodeHandle> const &nodeHandles) const
+{
+    auto const count = std::min(std::size(animatedNodes_), std::size(nodeHandles));
+
+    for (std::size_t i = 0; i < count; ++i)
+        if (animatedNodes_[i])
+            tree.SetLocalPose(nodeHandles[i], poses_[i]);
+}
+
+void ComputeJointPalette(scene_skin_t const &skin, SceneTree const &tree, std::vector<NodeHandle> const &nodeHandles,
+                         glm::mat4 const &meshWorldMatrix, std::vector<glm::mat4> &palette)
+{
+    auto const inverseMeshWorldMatrix = glm::inverse(meshWorldMatrix);
+
+    palette.resize(std::size(skin.joints));
+
+    for (std::size_t i = 0; i < std::size(skin.joints); ++i) {
+        auto const jointWorldMatrix = tree.GetWorldMatrix(nodeHandles.at(skin.joints[i])).value_or(glm::mat4{1.f});
+
+        palette[i] = inverseMeshWorldMatrix * jointWorldMatrix * skin.inverseBindMatrices[i];
+    }
+}
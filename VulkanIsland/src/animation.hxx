@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "main.hxx"
+#include "math.hxx"
+#include "glTFLoader.hxx"
+#include "transform.hxx"
+#include "scene_tree.hxx"
+
+
+// Index of the last key not later than 'time', zero if 'time' precedes all the keys.
+// Playback mostly advances by less than a key per frame, so the cached key and the next one are tried
+// before falling back to the binary search.
+[[nodiscard]] std::size_t FindAnimationKey(std::vector<float> const &times, float time, std::size_t cachedKey) noexcept;
+
+// Playback state of an animation: poses of the scene nodes and the key cached by each channel.
+// The animation has to outlive the player.
+class AnimationPlayer final {
+public:
+
+    AnimationPlayer(std::vector<scene_node_t> const &nodes, scene_animation_t const &animation);
+
+    // Samples the animation at 'time' wrapped around the animation duration.
+    void Sample(float time);
+
+    // Sets the poses of the animated nodes to their scene tree nodes, 'nodeHandles' are indexed by the scene node indices.
+    // The rest nodes keep their local matrices, the world matrices are composed by the next tree update.
+    void ApplyPoses(SceneTree &tree, std::vector<NodeHandle> const &nodeHandles) const;
+
+    std::vector<node_pose_t> const &poses() const noexcept { return poses_; }
+
+private:
+    scene_animation_t const *animation_;
+
+    std::vector<node_pose_t> poses_;
+    std::vector<std::uint8_t> animatedNodes_;
+
+    std::vector<std::size_t> channelKeys_;
+};
+
+// Skinning matrices of the joints relative to the skinned mesh node: inverse(meshWorld) * jointWorld * inverseBind.
+// The joint world matrices are taken from the updated scene tree, 'nodeHandles' are indexed by the scene node indices.
+void ComputeJointPalette(scene_skin_t const &skin, SceneTree const &tree, std::vector<NodeHandle> const &nodeHandles,
+                         glm::mat4 const &meshWorldMatrix, std::vector<glm::mat4> &palette);
@@ -0,0 +1,322 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <numeric>
+
+#include "bounding_volume_hierarchy.hxx"
+
+namespace {
+auto constexpr kBINS_NUMBER = 16u;
+
+// Nodes having no more primitives are not split even if the surface area heuristic favours splitting.
+auto constexpr kMIN_SPLIT_PRIMITIVES = 3u;
+
+// Nodes having more primitives are split even if the surface area heuristic favours a leaf.
+auto constexpr kMAX_LEAF_PRIMITIVES = 8u;
+
+// Cost of a node traversal relative to a primitive test.
+auto constexpr kTRAVERSAL_COST = 1.f;
+
+struct bin_t {
+    aabb_t bounds;
+    std::uint32_t count{0};
+};
+
+struct split_t {
+    float cost{std::numeric_limits<float>::max()};
+
+    int axis{-1};
+    std::uint32_t bin{0};
+};
+}
+
+void aabb_t::extend(aabb_t const &bounds) noexcept
+{
+    for (auto i = 0; i < 3; ++i) {
+        min[i] = std::min(min[i], bounds.min[i]);
+        max[i] = std::max(max[i], bounds.max[i]);
+    }
+}
+
+void aabb_t::extend(glm::vec3 const &point) noexcept
+{
+    for (auto i = 0; i < 3; ++i) {
+        min[i] = std::min(min[i], point[i]);
+        max[i] = std::max(max[i], point[i]);
+    }
+}
+
+float aabb_t::area() const noexcept
+{
+    if (empty())
+        return 0.f;
+
+    auto const extent = max - min;
+
+    return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+}
+
+bool aabb_t::overlaps(aabb_t const &bounds) const noexcept
+{
+    return min.x <= bounds.max.x && bounds.min.x <= max.x &&
+           min.y <= bounds.max.y && bounds.min.y <= max.y &&
+           min.z <= bounds.max.z && bounds.min.z <= max.z;
+}
+
+float aabb_t::distance(glm::vec3 const &point) const noexcept
+{
+    auto squaredDistance = 0.f;
+
+    for (auto i = 0; i < 3; ++i) {
+        auto const d = std::max({min[i] - point[i], 0.f, point[i] - max[i]});
+        squaredDistance += d * d;
+    }
+
+    return std::sqrt(squaredDistance);
+}
+
+aabb_t TransformBounds(aabb_t const &bounds, glm::mat4 const &matrix)
+{
+    if (bounds.empty())
+        return bounds;
+
+    aabb_t transformed;
+
+    // Arvo's method: each matrix element contributes its minimal and maximal product to the result.
+    for (auto i = 0; i < 3; ++i) {
+        transformed.min[i] = transformed.max[i] = matrix[3][i];
+
+        for (auto j = 0; j < 3; ++j) {
+            auto const a = matrix[j][i] * bounds.min[j];
+            auto const b = matrix[j][i] * bounds.max[j];
+
+            transformed.min[i] += std::min(a, b);
+            transformed.max[i] += std::max(a, b);
+        }
+    }
+
+    return transformed;
+}
+
+void BoundingVolumeHierarchy::Build(std::vector<aabb_t> const &primitiveBounds)
+{
+    nodes_.clear();
+    dirtyLeaves_.clear();
+    dirtyNodes_.clear();
+
+    primitiveBounds_ = primitiveBounds;
+
+    auto const primitiveCount = static_cast<std::uint32_t>(std::size(primitiveBounds_));
+
+    primitiveIndices_.resize(primitiveCount);
+    std::iota(std::begin(primitiveIndices_), std::end(primitiveIndices_), 0u);
+
+    primitiveLeaves_.assign(primitiveCount, kINVALID_NODE);
+
+    if (primitiveCount == 0)
+        return;
+
+    nodes_.reserve(primitiveCount * 2 - 1);
+    nodes_.push_back(node_t{aabb_t{}, 0, primitiveCount, kINVALID_NODE});
+
+    std::vector<glm::vec3> centers(primitiveCount);
+
+    std::transform(std::cbegin(primitiveBounds_), std::cend(primitiveBounds_), std::begin(centers), [] (auto &&bounds)
+    {
+        return bounds.empty() ? glm::vec3{0.f} : bounds.center();
+    });
+
+    std::vector<std::uint32_t> stack{0};
+
+    while (!std::empty(stack)) {
+        auto const nodeIndex = stack.back();
+        stack.pop_back();
+
+        auto const first = nodes_[nodeIndex].first;
+        auto const count = nodes_[nodeIndex].count;
+
+        auto const begin = std::next(std::begin(primitiveIndices_), first);
+        auto const end = std::next(begin, count);
+
+        aabb_t bounds, centerBounds;
+
+        std::for_each(begin, end, [&] (auto primitive)
+        {
+            bounds.extend(primitiveBounds_[primitive]);
+            centerBounds.extend(centers[primitive]);
+        });
+
+        nodes_[nodeIndex].bounds = bounds;
+
+        auto makeLeaf = [&, nodeIndex] ()
+        {
+            std::for_each(begin, end, [this, nodeIndex] (auto primitive) { primitiveLeaves_[primitive] = nodeIndex; });
+        };
+
+        if (count < kMIN_SPLIT_PRIMITIVES) {
+            makeLeaf();
+            continue;
+        }
+
+        split_t split;
+
+        for (auto axis = 0; axis < 3; ++axis) {
+            auto const extent = centerBounds.max[axis] - centerBounds.min[axis];
+
+            if (!(extent > 0.f))
+                continue;
+
+            std::array<bin_t, kBINS_NUMBER> bins;
+
+            auto const binScale = kBINS_NUMBER / extent;
+
+            std::for_each(begin, end, [&] (auto primitive)
+            {
+                auto const bin = std::min(static_cast<std::uint32_t>((centers[primitive][axis] - centerBounds.min[axis]) * binScale), kBINS_NUMBER - 1);
+
+                bins[bin].bounds.extend(primitiveBounds_[primitive]);
+                ++bins[bin].count;
+            });
+
+            // Areas and counts of the right sides of the planes between the bins are swept from the right.
+            std::array<float, kBINS_NUMBER - 1> rightAreas;
+            std::array<std::uint32_t, kBINS_NUMBER - 1> rightCounts;
+
+            aabb_t rightBounds;
+            std::uint32_t rightCount = 0;
+
+            for (auto bin = kBINS_NUMBER - 1; bin > 0; --bin) {
+                rightBounds.extend(bins[bin].bounds);
+                rightCount += bins[bin].count;
+
+                rightAreas[bin - 1] = rightBounds.area();
+                rightCounts[bin - 1] = rightCount;
+            }
+
+            aabb_t leftBounds;
+            std::uint32_t leftCount = 0;
+
+            for (auto bin = 0u; bin < kBINS_NUMBER - 1; ++bin) {
+                leftBounds.extend(bins[bin].bounds);
+                leftCount += bins[bin].count;
+
+                if (leftCount == 0 || rightCounts[bin] == 0)
+                    continue;
+
+                auto const cost = leftBounds.area() * leftCount + rightAreas[bin] * rightCounts[bin];
+
+                if (cost < split.cost)
+                    split = split_t{cost, axis, bin};
+            }
+        }
+
+        auto const area = bounds.area();
+
+        auto const leafCost = static_cast<float>(count);
+        auto const splitCost = area > 0.f ? kTRAVERSAL_COST + split.cost / area : leafCost;
+
+        std::uint32_t leftCount = 0;
+
+        if (split.axis != -1 && (splitCost < leafCost || count > kMAX_LEAF_PRIMITIVES)) {
+            auto const axis = split.axis;
+            auto const binScale = kBINS_NUMBER / (centerBounds.max[axis] - centerBounds.min[axis]);
+
+            auto const middle = std::partition(begin, end, [&] (auto primitive)
+            {
+                return std::min(static_cast<std::uint32_t>((centers[primitive][axis] - centerBounds.min[axis]) * binScale), kBINS_NUMBER - 1) <= split.bin;
+            });
+
+            leftCount = static_cast<std::uint32_t>(std::distance(begin, middle));
+        }
+
+        // All the centers coincide, but the node is still too big for a leaf.
+        else if (count > kMAX_LEAF_PRIMITIVES)
+            leftCount = count / 2;
+
+        if (leftCount == 0 || leftCount == count) {
+            makeLeaf();
+            continue;
+        }
+
+        auto const childIndex = static_cast<std::uint32_t>(std::size(nodes_));
+
+        nodes_.push_back(node_t{aabb_t{}, first, leftCount, nodeIndex});
+        nodes_.push_back(node_t{aabb_t{}, first + leftCount, count - leftCount, nodeIndex});
+
+        nodes_[nodeIndex].first = childIndex;
+        nodes_[nodeIndex].count = 0;
+
+        stack.push_back(childIndex + 1);
+        stack.push_back(childIndex);
+    }
+
+    dirtyNodes_.assign(std::size(nodes_), 0);
+}
+
+void BoundingVolumeHierarchy::UpdatePrimitive(std::uint32_t primitive, aabb_t const &bounds)
+{
+    if (primitive >= std::size(primitiveBounds_))
+        return;
+
+    primitiveBounds_[primitive] = bounds;
+
+    dirtyLeaves_.push_back(primitiveLeaves_[primitive]);
+}
+
+void BoundingVolumeHierarchy::Refit()
+{
+    if (std::empty(dirtyLeaves_))
+        return;
+
+    std::vector<std::uint32_t> refitNodes;
+
+    for (auto leaf : dirtyLeaves_) {
+        for (auto nodeIndex = leaf; nodeIndex != kINVALID_NODE && dirtyNodes_[nodeIndex] == 0; nodeIndex = nodes_[nodeIndex].parent) {
+            dirtyNodes_[nodeIndex] = 1;
+            refitNodes.push_back(nodeIndex);
+        }
+    }
+
+    dirtyLeaves_.clear();
+
+    // Children are always placed after their parents, so the descending order refits the children first.
+    std::sort(std::begin(refitNodes), std::end(refitNodes), std::greater<>{});
+
+    for (auto nodeIndex : refitNodes) {
+        auto &&node = nodes_[nodeIndex];
+
+        aabb_t bounds;
+
+        if (node.leaf()) {
+            for (auto i = node.first; i < node.first + node.count; ++i)
+                bounds.extend(primitiveBounds_[primitiveIndices_[i]]);
+        }
+
+        else {
+            bounds.extend(nodes_[node.first].bounds);
+            bounds.extend(nodes_[node.first + 1].bounds);
+        }
+
+        node.bounds = bounds;
+
+        dirtyNodes_[nodeIndex] = 0;
+    }
+}
+
+std::vector<std::uint32_t> BoundingVolumeHierarchy::Overlap(aabb_t const &bounds) const
+{
+    std::vector<std::uint32_t> primitives;
+
+    Traverse([&bounds] (auto &&nodeBounds)
+    {
+        return nodeBounds.overlaps(bounds);
+    },
+    [this, &bounds, &primitives] (auto primitive)
+    {
+        if (primitiveBounds_[primitive].overlaps(bounds))
+            primitives.push_back(primitive);
+    });
+
+    return primitives;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "main.hxx"
+#include "math.hxx"
+
+
+// Axis aligned bounding box, the default one is empty and has inverted bounds.
+struct aabb_t {
+    glm::vec3 min{std::numeric_limits<float>::max()};
+    glm::vec3 max{-std::numeric_limits<float>::max()};
+
+    bool empty() const noexcept { return min.x > max.x || min.y > max.y || min.z > max.z; }
+
+    void extend(aabb_t const &bounds) noexcept;
+    void extend(glm::vec3 const &point) noexcept;
+
+    glm::vec3 center() const noexcept { return (min + max) * .5f; }
+
+    // Half of the surface area, which is enough for the surface area heuristic.
+    float area() const noexcept;
+
+    bool overlaps(aabb_t const &bounds) const noexcept;
+
+    // Distance from the point to the box, zero if the point is inside.
+    float distance(glm::vec3 const &point) const noexcept;
+};
+
+// Bounds of the box transformed by the affine matrix.
+[[nodiscard]] aabb_t TransformBounds(aabb_t const &bounds, glm::mat4 const &matrix);
+
+
+// Bounding volume hierarchy over primitive bounds built using the binned surface area heuristic.
+// Changed primitive bounds are propagated by refitting the touched nodes, the topology stays the same
+// until the next build, so the tree quality degrades if the primitives move far from their original places.
+class BoundingVolumeHierarchy final {
+public:
+
+    static auto constexpr kINVALID_NODE = std::numeric_limits<std::uint32_t>::max();
+
+    // Interior nodes have zero 'count' and their children are 'first' and 'first + 1' nodes,
+    // leaf nodes reference 'count' primitives starting at 'first' of the primitive indices.
+    struct node_t {
+        aabb_t bounds;
+
+        std::uint32_t first{0}, count{0};
+        std::uint32_t parent{kINVALID_NODE};
+
+        bool leaf() const noexcept { return count != 0; }
+    };
+
+    void Build(std::vector<aabb_t> const &primitiveBounds);
+
+    // Sets new bounds of the primitive, the hierarchy isn't changed until the refit.
+    void UpdatePrimitive(std::uint32_t primitive, aabb_t const &bounds);
+
+    // Recomputes bounds of the nodes above the updated primitives bottom-up.
+    void Refit();
+
+    // Visits primitives of the leaves whose bounds and all of their ancestors ones pass 'test'.
+    template<class T, class V>
+    void Traverse(T &&test, V &&visitor) const
+    {
+        if (std::empty(nodes_))
+            return;
+
+        std::vector<std::uint32_t> stack{0};
+
+        while (!std::empty(stack)) {
+            auto &&node = nodes_[stack.back()];
+            stack.pop_back();
+
+            if (!test(node.bounds))
+                continue;
+
+            if (node.leaf()) {
+                for (auto i = node.first; i < node.first + node.count; ++i)
+                    visitor(primitiveIndices_[i]);
+            }
+
+            else {
+                stack.push_back(node.first + 1);
+                stack.push_back(node.first);
+            }
+        }
+    }
+
+    // Primitives whose bounds overlap the box.
+    [[nodiscard]] std::vector<std::uint32_t> Overlap(aabb_t const &bounds) const;
+
+    bool empty() const noexcept { return std::empty(nodes_); }
+
+    aabb_t const &bounds() const noexcept { return nodes_.front().bounds; }
+
+    std::vector<node_t> const &nodes() const noexcept { return nodes_; }
+    std::vector<aabb_t> const &primitiveBounds() const noexcept { return primitiveBounds_; }
+
+private:
+    std::vector<node_t> nodes_;
+
+    std::vector<aabb_t> primitiveBounds_;
+
+    // Primitives referenced by the leaves and the leaf of each primitive.
+    std::vector<std::uint32_t> primitiveIndices_;
+    std::vector<std::uint32_t> primitiveLeaves_;
+
+    // Leaves of the updated primitives and the marks of the nodes to be refitted.
+    std::vector<std::uint32_t> dirtyLeaves_;
+    std::vector<std::uint8_t> dirtyNodes_;
+};
@@ -313,4 +313,17 @@ CreateBufferHandle(VulkanDevice const &device, VkDeviceSize size, VkBufferUsageF
     else buffer.emplace(handle);
 
     return buffer;
-}
\ No newline at end of file
+}
+
+void CopyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkImage dstImage, std::uint16_t width, std::uint16_t height) noexcept
+{
+    VkBufferImageCopy const copyRegion{
+        0,
+        0, 0,
+        { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
+        { 0, 0, 0 },
+        { width, height, 1 }
+    };
+
+    vkCmdCopyBufferToImage(commandBuffer, srcBuffer, dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
+}
@@ -199,20 +199,15 @@ void CopyBufferToBuffer(VulkanDevice const &device, Q &queue, VkBuffer srcBuffer
     EndSingleTimeCommand(device, queue, commandBuffer, commandPool);
 }
 
+// Records the copy of the buffer to the first mip level of the image in the transfer destination layout.
+void CopyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkImage dstImage, std::uint16_t width, std::uint16_t height) noexcept;
+
 template<class Q, typename std::enable_if_t<std::is_base_of_v<VulkanQueue<Q>, std::decay_t<Q>>>...>
 void CopyBufferToImage(VulkanDevice const &device, Q &queue, VkBuffer srcBuffer, VkImage dstImage, std::uint16_t width, std::uint16_t height, VkCommandPool commandPool)
 {
     auto commandBuffer = BeginSingleTimeCommand(device, queue, commandPool);
 
-    VkBufferImageCopy const copyRegion{
-        0,
-        0, 0,
-        { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
-        { 0, 0, 0 },
-        { width, height, 1 }
-    };
-
-    vkCmdCopyBufferToImage(commandBuffer, srcBuffer, dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
+    CopyBufferToImage(commandBuffer, srcBuffer, dstImage, width, height);
 
     EndSingleTimeCommand(device, queue, commandBuffer, commandPool);
 }
@@ -13,7 +13,7 @@ VkPhysicalDeviceFeatures constexpr kDEVICE_FEATURES{
     VkBool32(VK_FALSE), // dualSrcBlend,
     VkBool32(VK_FALSE), // logicOp,
     VkBool32(VK_TRUE),  // multiDrawIndirect,
-    VkBool32(VK_FALSE), // drawIndirectFirstInstance,
+    VkBool32(VK_TRUE),  // drawIndirectFirstInstance,
     VkBool32(VK_TRUE),  // depthClamp,
     VkBool32(VK_FALSE), // depthBiasClamp,
     VkBool32(VK_TRUE),  // fillModeNonSolid,
@@ -1,4 +1,6 @@
 #include <variant>
+#include <map>
+#include <cstring>
 
 #ifdef _MSC_VER
 #include <filesystem>
@@ -20,6 +22,10 @@ namespace fs = boost::filesystem;
 #include "glTFLoader.hxx"
 #include "scene_tree.hxx"
 #include "mesh.hxx"
+#include "mesh_optimizer.hxx"
+#include "mesh_quantizer.hxx"
+#include "mesh_simplifier.hxx"
+#include "scene_cache.hxx"
 
 namespace glTF {
 auto constexpr kBYTE                 = 0x1400; // 5120
@@ -30,6 +36,19 @@ auto constexpr kINT                  = 0x1404;
 auto constexpr kUNSIGNED_INT         = 0x1405;
 auto constexpr kFLOAT                = 0x1406; // 5126
 
+auto constexpr kTRIANGLES            = 4;
+
+auto constexpr kNEAREST                 = 0x2600; // 9728
+auto constexpr kLINEAR                  = 0x2601;
+auto constexpr kNEAREST_MIPMAP_NEAREST  = 0x2700; // 9984
+auto constexpr kLINEAR_MIPMAP_NEAREST   = 0x2701;
+auto constexpr kNEAREST_MIPMAP_LINEAR   = 0x2702;
+auto constexpr kLINEAR_MIPMAP_LINEAR    = 0x2703;
+
+auto constexpr kREPEAT                  = 0x2901; // 10497
+auto constexpr kCLAMP_TO_EDGE           = 0x812F; // 33071
+auto constexpr kMIRRORED_REPEAT         = 0x8370; // 33648
+
 //auto constexpr kARRAY_BUFFER         = 0x8892;
 //auto constexpr kELEMENT_ARRAY_BUFFER = 0x8893;
 
@@ -284,33 +303,55 @@ static_assert(has_type_at_index<semantic::tex_coord_0, std::tuple_element_t<0, s
 
 
 
-template<class T, class V, std::size_t O, typename = std::make_index_sequence<std::variant_size_v<V>>>
-struct pick;
+std::uint32_t get_semantics_mask(accessors_set_t const &accessorsSet)
+{
+    std::uint32_t mask = 0;
 
-template<class T, class V, std::size_t O, std::size_t... I>
-struct pick<T, V, O, std::index_sequence<I...>> {
-    using candidates_t = std::tuple<std::variant_alternative_t<I, V>...>;
-};
+    for (auto &&[semantic, index] : accessorsSet) {
+        mask |= std::visit([] (auto semantic)
+        {
+            return 1u << semantic_location_v<std::decay_t<decltype(semantic)>>;
+
+        }, semantic);
+    }
+
+    return mask;
+}
 
-std::optional<std::size_t> foo(std::set<semantics_t> const &semantics_set)
+template<class T, class U, std::size_t... I>
+constexpr T convert_attribute(U const &value, std::index_sequence<I...>)
 {
-//    using candidates_t = float;
+    return T{static_cast<typename T::value_type>(value.array[I])...};
+}
 
-    std::size_t offset = 0;
+// Returns the accessor data as an array of the type requested by a vertex format,
+// components are converted only if accessor and vertex format types differ.
+template<class T>
+std::vector<T> const *get_attribute_buffer(buffer_t const &buffer, std::vector<T> &storage)
+{
+    if (auto ptr = std::get_if<std::vector<T>>(&buffer); ptr)
+        return ptr;
 
-    for (auto semantic : semantics_set) {
-        /*std::visit([] (auto semantic)
-        {
-            using type = std::decay_t<decltype(semantic)>;
+    return std::visit([&storage] (auto &&source) -> std::vector<T> const *
+    {
+        using U = typename std::decay_t<decltype(source)>::value_type;
 
-        }, semantic);*/
+        if constexpr (U::size != T::size)
+            return nullptr;
 
-        ++offset;
-    }
+        else {
+            storage.resize(std::size(source));
 
-    return { };
-}
+            std::transform(std::cbegin(source), std::cend(source), std::begin(storage), [] (auto &&value)
+            {
+                return convert_attribute<T>(value, std::make_index_sequence<T::size>{});
+            });
+
+            return &storage;
+        }
 
+    }, buffer);
+}
 }
 
 struct scene_t {
@@ -325,10 +366,36 @@ struct node_t {
 
     std::optional<std::size_t> mesh;
     std::optional<std::size_t> camera;
+    std::optional<std::size_t> skin;
 
     std::vector<std::size_t> children;
 };
 
+struct skin_t {
+    std::optional<std::size_t> inverseBindMatrices;
+    std::vector<std::size_t> joints;
+};
+
+struct animation_t {
+    struct channel_t {
+        std::size_t sampler;
+
+        // Channels without a target node are ignored.
+        std::optional<std::size_t> node;
+        std::string path;
+    };
+
+    struct sampler_t {
+        std::size_t input, output;
+        std::string interpolation;
+    };
+
+    std::string name;
+
+    std::vector<channel_t> channels;
+    std::vector<sampler_t> samplers;
+};
+
 struct buffer_t {
     std::size_t byteLength;
     std::string uri;
@@ -350,17 +417,6 @@ struct mesh_t {
 
         attribute::accessors_set_t attributeAccessors;
 
-        struct attributes_t {
-            std::optional<std::size_t> position;
-            std::optional<std::size_t> normal;
-            std::optional<std::size_t> tangent;
-            std::optional<std::size_t> texCoord0;
-            std::optional<std::size_t> texCoord1;
-            std::optional<std::size_t> color0;
-            std::optional<std::size_t> joints0;
-            std::optional<std::size_t> weights0;
-        } attributes;
-
         std::uint32_t mode{4};
     };
 
@@ -379,7 +435,7 @@ struct material_t {
 
         std::array<float, 4> baseColorFactor{{1.f, 1.f, 1.f, 1.f}};
 
-        float metallicFactor, roughnessFactor;
+        float metallicFactor{1.f}, roughnessFactor{1.f};
     } pbr;
 
     struct normal_texture_t {
@@ -405,7 +461,7 @@ struct material_t {
 
     std::optional<emissive_texture_t> emissiveTexture;
 
-    std::array<float, 3> emissiveFactor{{1.f, 1.f, 1.f}};
+    std::array<float, 3> emissiveFactor{{0.f, 0.f, 0.f}};
 
     std::string name;
     bool doubleSided{false};
@@ -429,12 +485,12 @@ struct camera_t {
 
 struct texture_t {
     std::size_t source;
-    std::size_t sampler;
+    std::optional<std::size_t> sampler;
 };
 
 struct sampler_t {
-    std::uint32_t minFilter, magFilter;
-    std::uint32_t wrapS, wrapT;
+    std::uint32_t minFilter{kLINEAR_MIPMAP_LINEAR}, magFilter{kLINEAR};
+    std::uint32_t wrapS{kREPEAT}, wrapT{kREPEAT};
 };
 
 struct buffer_view_t {
@@ -446,15 +502,20 @@ struct buffer_view_t {
 };
 
 struct accessor_t {
-    std::size_t bufferView;
+    // Accessor without a buffer view is initialized with zeros.
+    std::optional<std::size_t> bufferView;
     std::size_t byteOffset;
     std::size_t count;
 
+    // Elements replaced over the base accessor data: indices and values are tightly packed.
     struct sparse_t {
         std::size_t count;
+
         std::size_t valuesBufferView;
+        std::size_t valuesByteOffset;
 
         std::size_t indicesBufferView;
+        std::size_t indicesByteOffset;
         std::uint32_t indicesComponentType;
     };
 
@@ -514,7 +575,7 @@ void from_json(nlohmann::json const &j, node_t &node)
 
     else {
         std::array<float, 3> translation{{0.f, 0.f, 0.f}};
-        std::array<float, 4> rotation{{0.f, 1.f, 0.f, 0.f}};
+        std::array<float, 4> rotation{{0.f, 0.f, 0.f, 1.f}};
         std::array<float, 3> scale{{1.f, 1.f, 1.f}};
 
         if (j.count("translation"s))
@@ -538,6 +599,45 @@ void from_json(nlohmann::json const &j, node_t &node)
 
     if (j.count("camera"s))
         node.camera = j.at("camera"s).get<std::decay_t<decltype(node.camera)::value_type>>();
+
+    if (j.count("skin"s))
+        node.skin = j.at("skin"s).get<std::decay_t<decltype(node.skin)::value_type>>();
+}
+
+void from_json(nlohmann::json const &j, skin_t &skin)
+{
+    if (j.count("inverseBindMatrices"s))
+        skin.inverseBindMatrices = j.at("inverseBindMatrices"s).get<std::size_t>();
+
+    skin.joints = j.at("joints"s).get<decltype(skin_t::joints)>();
+}
+
+void from_json(nlohmann::json const &j, animation_t::channel_t &channel)
+{
+    channel.sampler = j.at("sampler"s).get<decltype(animation_t::channel_t::sampler)>();
+
+    auto &&target = j.at("target"s);
+
+    if (target.count("node"s))
+        channel.node = target.at("node"s).get<std::size_t>();
+
+    channel.path = target.at("path"s).get<decltype(animation_t::channel_t::path)>();
+}
+
+void from_json(nlohmann::json const &j, animation_t::sampler_t &sampler)
+{
+    sampler.input = j.at("input"s).get<decltype(animation_t::sampler_t::input)>();
+    sampler.output = j.at("output"s).get<decltype(animation_t::sampler_t::output)>();
+
+    sampler.interpolation = j.value("interpolation"s, "LINEAR"s);
+}
+
+void from_json(nlohmann::json const &j, animation_t &animation)
+{
+    animation.name = j.value("name"s, ""s);
+
+    animation.channels = j.at("channels"s).get<decltype(animation_t::channels)>();
+    animation.samplers = j.at("samplers"s).get<decltype(animation_t::samplers)>();
 }
 
 void from_json(nlohmann::json const &j, mesh_t &mesh)
@@ -563,31 +663,6 @@ void from_json(nlohmann::json const &j, mesh_t &mesh)
             }
         }
 
-        // TODO: remove
-        if (json_attributes.count("POSITION"s))
-            primitive.attributes.position = json_attributes.at("POSITION"s).get<decltype(mesh_t::primitive_t::attributes_t::position)::value_type>();
-
-        if (json_attributes.count("NORMAL"s))
-            primitive.attributes.normal = json_attributes.at("NORMAL"s).get<decltype(mesh_t::primitive_t::attributes_t::normal)::value_type>();
-
-        if (json_attributes.count("TANGENT"s))
-            primitive.attributes.tangent = json_attributes.at("TANGENT"s).get<decltype(mesh_t::primitive_t::attributes_t::tangent)::value_type>();
-
-        if (json_attributes.count("TEXCOORD_0"s))
-            primitive.attributes.texCoord0 = json_attributes.at("TEXCOORD_0"s).get<decltype(mesh_t::primitive_t::attributes_t::texCoord0)::value_type>();
-
-        if (json_attributes.count("TEXCOORD_1"s))
-            primitive.attributes.texCoord1 = json_attributes.at("TEXCOORD_1"s).get<decltype(mesh_t::primitive_t::attributes_t::texCoord1)::value_type>();
-
-        if (json_attributes.count("COLOR_0"s))
-            primitive.attributes.color0 = json_attributes.at("COLOR_0"s).get<decltype(mesh_t::primitive_t::attributes_t::color0)::value_type>();
-
-        if (json_attributes.count("JOINTS_0"s))
-            primitive.attributes.joints0 = json_attributes.at("JOINTS_0"s).get<decltype(mesh_t::primitive_t::attributes_t::joints0)::value_type>();
-
-        if (json_attributes.count("WEIGHTS_0"s))
-            primitive.attributes.weights0 = json_attributes.at("WEIGHTS_0"s).get<decltype(mesh_t::primitive_t::attributes_t::weights0)::value_type>();
-
         if (json_primitive.count("mode"s))
             primitive.mode = json_primitive.at("mode"s).get<decltype(mesh_t::primitive_t::mode)>();
 
@@ -599,64 +674,54 @@ void from_json(nlohmann::json const &j, mesh_t &mesh)
 
 void from_json(nlohmann::json const &j, material_t &material)
 {
-    auto &&json_pbrMetallicRoughness = j.at("pbrMetallicRoughness"s);
+    // Texture info fields other than the index are optional.
+    auto const texture_info = [] (nlohmann::json const &json)
+    {
+        return std::make_pair(json.at("index"s).get<std::size_t>(), json.value("texCoord"s, std::size_t{0}));
+    };
 
-    if (json_pbrMetallicRoughness.count("baseColorTexture"s)) {
-        auto const json_baseColorTexture = json_pbrMetallicRoughness.at("baseColorTexture"s);
+    if (j.count("pbrMetallicRoughness"s)) {
+        auto &&json_pbrMetallicRoughness = j.at("pbrMetallicRoughness"s);
 
-        material.pbr.baseColorTexture = {
-            json_baseColorTexture.at("index"s).get<decltype(material_t::pbr_t::texture_t::index)>(),
-            json_baseColorTexture.count("texCoord"s) ? json_baseColorTexture.at("texCoord"s).get<decltype(material_t::pbr_t::texture_t::texCoord)>() : 0
-        };
-    }
+        if (json_pbrMetallicRoughness.count("baseColorTexture"s)) {
+            auto [index, texCoord] = texture_info(json_pbrMetallicRoughness.at("baseColorTexture"s));
+            material.pbr.baseColorTexture = material_t::pbr_t::texture_t{index, texCoord};
+        }
 
-    material.pbr.baseColorFactor = json_pbrMetallicRoughness.at("baseColorFactor"s).get<decltype(material_t::pbr_t::baseColorFactor)>();
+        if (json_pbrMetallicRoughness.count("metallicRoughnessTexture"s)) {
+            auto [index, texCoord] = texture_info(json_pbrMetallicRoughness.at("metallicRoughnessTexture"s));
+            material.pbr.metallicRoughnessTexture = material_t::pbr_t::texture_t{index, texCoord};
+        }
 
-    if (json_pbrMetallicRoughness.count("metallicRoughnessTexture"s)) {
-        auto const json_metallicRoughnessTexture = json_pbrMetallicRoughness.at("metallicRoughnessTexture"s);
+        material.pbr.baseColorFactor = json_pbrMetallicRoughness.value("baseColorFactor"s, material.pbr.baseColorFactor);
 
-        material.pbr.metallicRoughnessTexture = {
-            json_metallicRoughnessTexture.at("index"s).get<decltype(material_t::pbr_t::texture_t::index)>(),
-            json_metallicRoughnessTexture.count("texCoord"s) ? json_metallicRoughnessTexture.at("texCoord"s).get<decltype(material_t::pbr_t::texture_t::texCoord)>() : 0
-        };
+        material.pbr.metallicFactor = json_pbrMetallicRoughness.value("metallicFactor"s, material.pbr.metallicFactor);
+        material.pbr.roughnessFactor = json_pbrMetallicRoughness.value("roughnessFactor"s, material.pbr.roughnessFactor);
     }
 
-    material.pbr.metallicFactor = json_pbrMetallicRoughness.at("metallicFactor"s).get<decltype(material_t::pbr_t::metallicFactor)>();
-    material.pbr.roughnessFactor = json_pbrMetallicRoughness.at("roughnessFactor"s).get<decltype(material_t::pbr_t::roughnessFactor)>();
-
     if (j.count("normalTexture"s)) {
-        auto const json_normalTexture = j.at("normalTexture"s);
+        auto &&json_normalTexture = j.at("normalTexture"s);
+        auto [index, texCoord] = texture_info(json_normalTexture);
 
-        material.normalTexture = {
-            json_normalTexture.at("index"s).get<decltype(material_t::normal_texture_t::index)>(),
-            json_normalTexture.count("texCoord"s) ? json_normalTexture.at("texCoord"s).get<decltype(material_t::normal_texture_t::texCoord)>() : 0,
-            json_normalTexture.at("scale"s).get<decltype(material_t::normal_texture_t::scale)>()
-        };
+        material.normalTexture = material_t::normal_texture_t{index, texCoord, json_normalTexture.value("scale"s, 1.f)};
     }
 
     if (j.count("occlusionTexture"s)) {
-        auto const json_occlusionTexture = j.at("occlusionTexture"s);
+        auto &&json_occlusionTexture = j.at("occlusionTexture"s);
+        auto [index, texCoord] = texture_info(json_occlusionTexture);
 
-        material.occlusionTexture = {
-            json_occlusionTexture.at("index"s).get<decltype(material_t::occlusion_texture_t::index)>(),
-            json_occlusionTexture.count("texCoord"s) ? json_occlusionTexture.at("texCoord"s).get<decltype(material_t::occlusion_texture_t::texCoord)>() : 0,
-            json_occlusionTexture.at("strength"s).get<decltype(material_t::occlusion_texture_t::strength)>()
-        };
+        material.occlusionTexture = material_t::occlusion_texture_t{index, texCoord, json_occlusionTexture.value("strength"s, 1.f)};
     }
 
     if (j.count("emissiveTexture"s)) {
-        auto const json_emissiveTexture = j.at("emissiveTexture"s);
-
-        material.emissiveTexture = {
-            json_emissiveTexture.at("index"s).get<decltype(material_t::emissive_texture_t::index)>(),
-            json_emissiveTexture.count("texCoord"s) ? json_emissiveTexture.at("texCoord"s).get<decltype(material_t::emissive_texture_t::texCoord)>() : 0
-        };
-
-        material.emissiveFactor = j.at("emissiveFactor"s).get<decltype(material_t::emissiveFactor)>();
+        auto [index, texCoord] = texture_info(j.at("emissiveTexture"s));
+        material.emissiveTexture = material_t::emissive_texture_t{index, texCoord};
     }
 
-    material.name = j.at("name"s).get<decltype(material_t::name)>();
-    material.doubleSided = j.at("doubleSided"s).get<decltype(material_t::doubleSided)>();
+    material.emissiveFactor = j.value("emissiveFactor"s, material.emissiveFactor);
+
+    material.name = j.value("name"s, material.name);
+    material.doubleSided = j.value("doubleSided"s, material.doubleSided);
 }
 
 void from_json(nlohmann::json const &j, camera_t &camera)
@@ -693,16 +758,18 @@ void from_json(nlohmann::json const &j, camera_t &camera)
 void from_json(nlohmann::json const &j, texture_t &texture)
 {
     texture.source = j.at("source"s).get<decltype(texture_t::source)>();
-    texture.sampler = j.at("sampler"s).get<decltype(texture_t::sampler)>();
+
+    if (j.count("sampler"s))
+        texture.sampler = j.at("sampler"s).get<std::size_t>();
 }
 
 void from_json(nlohmann::json const &j, sampler_t &sampler)
 {
-    sampler.minFilter = j.at("minFilter"s).get<decltype(sampler_t::minFilter)>();
-    sampler.magFilter = j.at("magFilter"s).get<decltype(sampler_t::magFilter)>();
+    sampler.minFilter = j.value("minFilter"s, sampler.minFilter);
+    sampler.magFilter = j.value("magFilter"s, sampler.magFilter);
 
-    sampler.wrapS = j.at("wrapS"s).get<decltype(sampler_t::wrapS)>();
-    sampler.wrapT = j.at("wrapT"s).get<decltype(sampler_t::wrapT)>();
+    sampler.wrapS = j.value("wrapS"s, sampler.wrapS);
+    sampler.wrapT = j.value("wrapT"s, sampler.wrapT);
 }
 
 void from_json(nlohmann::json const &j, buffer_view_t &bufferView)
@@ -722,7 +789,8 @@ void from_json(nlohmann::json const &j, buffer_view_t &bufferView)
 
 void from_json(nlohmann::json const &j, accessor_t &accessor)
 {
-    accessor.bufferView = j.at("bufferView"s).get<decltype(accessor_t::bufferView)>();
+    if (j.count("bufferView"s))
+        accessor.bufferView = j.at("bufferView"s).get<std::size_t>();
 
     if (j.count("byteOffset"s))
         accessor.byteOffset = j.at("byteOffset"s).get<decltype(accessor_t::byteOffset)>();
@@ -738,16 +806,22 @@ void from_json(nlohmann::json const &j, accessor_t &accessor)
 
         sparse.count = json_sparse.at("count"s).get<decltype(accessor_t::sparse_t::count)>();
 
-        sparse.valuesBufferView = json_sparse.at("values"s).at("bufferView"s).get<decltype(accessor_t::sparse_t::valuesBufferView)>();
+        auto &&json_values = json_sparse.at("values"s);
 
-        sparse.indicesBufferView = json_sparse.at("indices"s).at("bufferView"s).get<decltype(accessor_t::sparse_t::indicesBufferView)>();
-        sparse.indicesComponentType = json_sparse.at("indices"s).at("componentType"s).get<decltype(accessor_t::sparse_t::indicesComponentType)>();
+        sparse.valuesBufferView = json_values.at("bufferView"s).get<decltype(accessor_t::sparse_t::valuesBufferView)>();
+        sparse.valuesByteOffset = json_values.value("byteOffset"s, std::size_t{0});
+
+        auto &&json_indices = json_sparse.at("indices"s);
+
+        sparse.indicesBufferView = json_indices.at("bufferView"s).get<decltype(accessor_t::sparse_t::indicesBufferView)>();
+        sparse.indicesByteOffset = json_indices.value("byteOffset"s, std::size_t{0});
+        sparse.indicesComponentType = json_indices.at("componentType"s).get<decltype(accessor_t::sparse_t::indicesComponentType)>();
 
         accessor.sparse = sparse;
     }
 
-    accessor.min = j.at("min"s).get<decltype(accessor_t::min)>();
-    accessor.max = j.at("max"s).get<decltype(accessor_t::max)>();
+    accessor.min = j.value("min"s, decltype(accessor_t::min){ });
+    accessor.max = j.value("max"s, decltype(accessor_t::max){ });
 
     accessor.type = j.at("type"s).get<decltype(accessor_t::type)>();
     accessor.componentType = j.at("componentType"s).get<decltype(accessor_t::componentType)>();
@@ -800,6 +874,93 @@ std::optional<attribute::buffer_t> instantiate_attribute_buffer(std::string_view
     return std::nullopt;
 }
 
+template<class I, class T>
+bool scatter_sparse_values(std::vector<T> &buffer, std::byte const *indices, std::byte const *values, std::size_t count)
+{
+    auto const size = std::size(buffer);
+
+    // Both arrays are tightly packed, the values are copied straight to the decoded elements.
+    for (std::size_t i = 0; i < count; ++i) {
+        I index;
+        std::memcpy(&index, indices + i * sizeof(I), sizeof(I));
+
+        if (static_cast<std::size_t>(index) >= size)
+            return false;
+
+        std::memcpy(&buffer[index], values + i * sizeof(T), sizeof(T));
+    }
+
+    return true;
+}
+
+// Patches the decoded accessor elements in place with the sparse substitution values.
+template<class T>
+bool apply_sparse_accessor(std::vector<T> &buffer, accessor_t::sparse_t const &sparse, std::vector<buffer_view_t> const &bufferViews,
+                           std::vector<std::vector<std::byte>> const &binBuffers)
+{
+    if (sparse.count == 0)
+        return true;
+
+    auto &&indicesBufferView = bufferViews.at(sparse.indicesBufferView);
+    auto &&valuesBufferView = bufferViews.at(sparse.valuesBufferView);
+
+    auto &&indicesBinBuffer = binBuffers.at(indicesBufferView.buffer);
+    auto &&valuesBinBuffer = binBuffers.at(valuesBufferView.buffer);
+
+    std::size_t indexSize = 0;
+
+    switch (sparse.indicesComponentType) {
+        case glTF::kUNSIGNED_BYTE:
+            indexSize = sizeof(std::uint8_t);
+            break;
+
+        case glTF::kUNSIGNED_SHORT:
+            indexSize = sizeof(std::uint16_t);
+            break;
+
+        case glTF::kUNSIGNED_INT:
+            indexSize = sizeof(std::uint32_t);
+            break;
+
+        default:
+            std::cerr << "unsupported sparse indices component type\n"s;
+            return false;
+    }
+
+    auto const indicesBeginIndex = indicesBufferView.byteOffset + sparse.indicesByteOffset;
+    auto const valuesBeginIndex = valuesBufferView.byteOffset + sparse.valuesByteOffset;
+
+    if (indicesBeginIndex + sparse.count * indexSize > std::size(indicesBinBuffer) ||
+        valuesBeginIndex + sparse.count * sizeof(T) > std::size(valuesBinBuffer)) {
+        std::cerr << "sparse accessor is out of buffer bounds\n"s;
+        return false;
+    }
+
+    auto const indices = std::data(indicesBinBuffer) + indicesBeginIndex;
+    auto const values = std::data(valuesBinBuffer) + valuesBeginIndex;
+
+    bool patched = false;
+
+    switch (indexSize) {
+        case sizeof(std::uint8_t):
+            patched = scatter_sparse_values<std::uint8_t>(buffer, indices, values, sparse.count);
+            break;
+
+        case sizeof(std::uint16_t):
+            patched = scatter_sparse_values<std::uint16_t>(buffer, indices, values, sparse.count);
+            break;
+
+        default:
+            patched = scatter_sparse_values<std::uint32_t>(buffer, indices, values, sparse.count);
+            break;
+    }
+
+    if (!patched)
+        std::cerr << "sparse accessor index is out of range\n"s;
+
+    return patched;
+}
+
 template<std::size_t N>
 std::optional<attribute::attribute_t> try_to_get_attribute_type(std::int32_t componentType)
 {
@@ -848,114 +1009,469 @@ std::optional<attribute::attribute_t> try_to_get_attribute_type(std::string_view
 }
 
 
-bool LoadScene(std::string_view name, std::vector<Vertex> &vertices, std::vector<std::uint32_t> &_indices)
+glm::mat4 get_local_matrix(node_t const &node)
 {
-    auto current_path = fs::current_path();
+    return std::visit([] (auto &&transform)
+    {
+        using T = std::decay_t<decltype(transform)>;
 
-    fs::path contents{"contents"s};
-    fs::path folder{std::data(name)};
+        if constexpr (std::is_same_v<T, mat4>)
+            return glm::make_mat4(std::data(transform.m));
 
-    if (!fs::exists(current_path / contents))
-        contents = current_path / fs::path{"../"s} / contents;
+        else {
+            auto &&[position, rotation, scale] = transform;
 
-    folder = contents / folder;
+            auto matrix = glm::translate(glm::mat4{1.f}, glm::make_vec3(std::data(position.xyz)));
+            matrix = matrix * glm::mat4_cast(glm::make_quat(std::data(rotation.xyzw)));
 
-    auto glTF_path = folder / fs::path{"scene.gltf"s};
+            return glm::scale(matrix, glm::make_vec3(std::data(scale.xyz)));
+        }
 
-    std::ifstream glTFFile(glTF_path.native(), std::ios::in);
+    }, node.transform);
+}
 
-    if (glTFFile.bad() || glTFFile.fail()) {
-        std::cerr << "failed to open file: "s << glTF_path << std::endl;
-        return false;
+// Rest pose of the node as translation, rotation and scale, identity if the node is defined by a matrix.
+std::tuple<glm::vec3, glm::quat, glm::vec3> get_local_pose(node_t const &node)
+{
+    if (auto trs = std::get_if<std::tuple<vec3, quat, vec3>>(&node.transform); trs) {
+        auto &&[position, rotation, scale] = *trs;
+
+        return {
+            glm::make_vec3(std::data(position.xyz)), glm::make_quat(std::data(rotation.xyzw)), glm::make_vec3(std::data(scale.xyz))
+        };
     }
 
-    nlohmann::json json;
-    glTFFile >> json;
+    return {glm::vec3{0.f}, glm::quat{1.f, 0.f, 0.f, 0.f}, glm::vec3{1.f}};
+}
 
-    auto scenes = json.at("scenes"s).get<std::vector<glTF::scene_t>>();
-    auto nodes = json.at("nodes"s).get<std::vector<glTF::node_t>>();
+scene_sampler_t get_scene_sampler(sampler_t const &sampler)
+{
+    auto const get_address_mode = [] (std::uint32_t wrap)
+    {
+        switch (wrap) {
+            case kCLAMP_TO_EDGE:
+                return VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+            case kMIRRORED_REPEAT:
+                return VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT;
+
+            default:
+                return VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        }
+    };
+
+    scene_sampler_t sceneSampler;
+
+    sceneSampler.magFilter = sampler.magFilter == kNEAREST ? VK_FILTER_NEAREST : VK_FILTER_LINEAR;
+
+    switch (sampler.minFilter) {
+        case kNEAREST:
+        case kNEAREST_MIPMAP_NEAREST:
+            sceneSampler.minFilter = VK_FILTER_NEAREST;
+            sceneSampler.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+            break;
+
+        case kNEAREST_MIPMAP_LINEAR:
+            sceneSampler.minFilter = VK_FILTER_NEAREST;
+            sceneSampler.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+            break;
+
+        case kLINEAR:
+        case kLINEAR_MIPMAP_NEAREST:
+            sceneSampler.minFilter = VK_FILTER_LINEAR;
+            sceneSampler.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+            break;
+
+        default:
+            sceneSampler.minFilter = VK_FILTER_LINEAR;
+            sceneSampler.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+            break;
+    }
+
+    sceneSampler.addressModeU = get_address_mode(sampler.wrapS);
+    sceneSampler.addressModeV = get_address_mode(sampler.wrapT);
+
+    return sceneSampler;
+}
+
+// Fills the scene images, samplers, textures and materials. Images with the same URI,
+// samplers with the same state and textures referring to the same image and sampler are merged.
+void import_materials(scene_data_t &sceneData, std::string_view name, std::vector<image_t> const &images, std::vector<texture_t> const &textures,
+                      std::vector<sampler_t> const &samplers, std::vector<material_t> const &materials)
+{
+    std::map<std::string, std::int32_t> imagesByURI;
+    std::vector<std::int32_t> imageIndices;
+
+    for (auto &&image : images) {
+        // Only the images referenced by URI can be loaded.
+        if (auto uri = std::get_if<std::string>(&image.data); uri) {
+            auto const path = (fs::path{std::data(name)} / fs::path{*uri}).generic_string();
+
+            auto [it, inserted] = imagesByURI.try_emplace(path, static_cast<std::int32_t>(std::size(sceneData.images)));
+
+            if (inserted)
+                sceneData.images.push_back(path);
+
+            imageIndices.push_back(it->second);
+        }
+
+        else imageIndices.push_back(-1);
+    }
+
+    auto const get_sampler_index = [&sceneData] (scene_sampler_t const &sampler)
+    {
+        auto it = std::find(std::cbegin(sceneData.samplers), std::cend(sceneData.samplers), sampler);
 
-    std::vector<SceneTree> sceneTrees;
+        if (it == std::cend(sceneData.samplers))
+            it = sceneData.samplers.insert(std::cend(sceneData.samplers), sampler);
 
-    std::transform(std::begin(scenes), std::end(scenes), std::back_inserter(sceneTrees), [&nodes] (auto &&scene)
+        return static_cast<std::uint32_t>(std::distance(std::cbegin(sceneData.samplers), it));
+    };
+
+    std::vector<std::int32_t> textureIndices;
+
+    for (auto &&texture : textures) {
+        auto const sampler = texture.sampler ? get_scene_sampler(samplers.at(*texture.sampler)) : scene_sampler_t{};
+
+        scene_texture_t const sceneTexture{imageIndices.at(texture.source), get_sampler_index(sampler)};
+
+        auto it = std::find_if(std::cbegin(sceneData.textures), std::cend(sceneData.textures), [&sceneTexture] (auto &&texture)
+        {
+            return texture.image == sceneTexture.image && texture.sampler == sceneTexture.sampler;
+        });
+
+        if (it == std::cend(sceneData.textures))
+            it = sceneData.textures.insert(std::cend(sceneData.textures), sceneTexture);
+
+        textureIndices.push_back(static_cast<std::int32_t>(std::distance(std::cbegin(sceneData.textures), it)));
+    }
+
+    auto const get_texture_index = [&textureIndices] (auto &&texture)
     {
-        SceneTree sceneTree{scene.name};
+        return texture ? textureIndices.at(texture->index) : -1;
+    };
 
-        auto parent = sceneTree.root();
+    for (auto &&material : materials) {
+        scene_material_t sceneMaterial;
 
-        using handles_t = std::vector<NodeHandle>;
+        sceneMaterial.baseColorFactor = material.pbr.baseColorFactor;
+        sceneMaterial.emissiveFactor = material.emissiveFactor;
 
-        handles_t handles;
-        std::vector<handles_t> handlesStack;
+        sceneMaterial.metallicFactor = material.pbr.metallicFactor;
+        sceneMaterial.roughnessFactor = material.pbr.roughnessFactor;
 
-        std::vector<std::vector<std::size_t>> indicesStack{scene.nodes};
+        sceneMaterial.baseColorTexture = get_texture_index(material.pbr.baseColorTexture);
+        sceneMaterial.metallicRoughnessTexture = get_texture_index(material.pbr.metallicRoughnessTexture);
+        sceneMaterial.normalTexture = get_texture_index(material.normalTexture);
+        sceneMaterial.occlusionTexture = get_texture_index(material.occlusionTexture);
+        sceneMaterial.emissiveTexture = get_texture_index(material.emissiveTexture);
+
+        sceneMaterial.doubleSided = material.doubleSided;
+
+        sceneData.materials.push_back(sceneMaterial);
+    }
+}
 
-        while (!indicesStack.empty()) {
-            auto &&indices = indicesStack.back();
+std::size_t get_accessor_index(mesh_t::primitive_t const &primitive, std::size_t semanticIndex)
+{
+    auto it = std::find_if(std::cbegin(primitive.attributeAccessors), std::cend(primitive.attributeAccessors), [semanticIndex] (auto &&accessor)
+    {
+        return accessor.first.index() == semanticIndex;
+    });
 
-            if (indices.empty()) {
-                handlesStack.pop_back();
+    return it->second;
+}
 
-                if (!handlesStack.empty() && !handlesStack.back().empty())
-                    parent = handlesStack.back().back();
+template<class VF, std::size_t... I>
+bool interleave_primitive(vertex_stream_t &stream, mesh_t::primitive_t const &primitive,
+                          std::vector<attribute::buffer_t> const &attributeBuffers, std::index_sequence<I...>)
+{
+    using traits = vertex_format_traits<VF>;
 
-                indicesStack.pop_back();
+    using format_semantics_t = std::tuple_element_t<0, VF>;
+    using format_types_t = std::tuple_element_t<1, VF>;
 
-                continue;
-            }
+    std::tuple<std::vector<std::tuple_element_t<I, format_types_t>>...> storages;
 
-            if (std::size(indicesStack) != std::size(handlesStack)) {
-                for (auto index : indices) {
-                    auto &&node = nodes.at(index);
+    auto const buffers = std::make_tuple(attribute::get_attribute_buffer(
+        attributeBuffers.at(get_accessor_index(primitive, variant_index_v<std::tuple_element_t<I, format_semantics_t>, semantics_t>)),
+        std::get<I>(storages)
+    )...);
 
-                    // TODO: add mesh component
-                    /*if (node.mesh)
-                        continue;*/
+    if (!(... && (std::get<I>(buffers) != nullptr)))
+        return false;
 
-                    if (auto handle = sceneTree.AttachNode(parent, node.name); handle) {
-                        handles.emplace_back(*handle);
+    auto const count = std::size(*std::get<0>(buffers));
 
-                        std::visit([&sceneTree, handle] (auto &&transform)
-                        {
-                            using T = std::decay_t<decltype(transform)>;
+    if (!(... && (std::size(*std::get<I>(buffers)) == count)))
+        return false;
 
-                            if constexpr (std::is_same_v<T, mat4>)
-                                sceneTree.AddComponent<Transform>(*handle, glm::make_mat4(std::data(transform.m)), glm::mat4{1.f});
+    stream.buffer.resize(std::size(stream.buffer) + count * traits::stride);
 
-                            else {
-                                auto &&[position, rotation, scale] = transform;
+    traits::interleave(std::data(stream.buffer) + stream.count * traits::stride, count, std::data(*std::get<I>(buffers))...);
 
-                                auto matrix = glm::translate(glm::mat4{1.f}, glm::make_vec3(std::data(position.xyz)));
-                                matrix = matrix * glm::mat4_cast(glm::make_quat(std::data(rotation.xyzw)));
-                                matrix = glm::scale(matrix, glm::make_vec3(std::data(scale.xyz)));
+    stream.count += count;
 
-                                sceneTree.AddComponent<Transform>(*handle, std::move(matrix), glm::mat4{1.f});
-                            }
+    return true;
+}
 
-                        }, node.transform);
-                    }
+// Converts the decoded accessor to floats, integer components are treated as normalized ones.
+std::optional<std::vector<float>> get_float_values(attribute::buffer_t const &buffer)
+{
+    return std::visit([] (auto &&buffer) -> std::optional<std::vector<float>>
+    {
+        using T = typename std::decay_t<decltype(buffer)>::value_type::value_type;
+
+        auto constexpr N = std::decay_t<decltype(buffer)>::value_type::size;
+
+        if constexpr (sizeof(T) > 2 && !std::is_floating_point_v<T>)
+            return { };
+
+        else {
+            std::vector<float> values;
+            values.reserve(std::size(buffer) * N);
+
+            for (auto &&element : buffer) {
+                for (auto value : element.array) {
+                    if constexpr (std::is_floating_point_v<T>)
+                        values.push_back(value);
+
+                    else values.push_back(std::max(static_cast<float>(value) / std::numeric_limits<T>::max(), -1.f));
                 }
+            }
+
+            return values;
+        }
 
-                handlesStack.emplace_back(std::move(handles));
+    }, buffer);
+}
+
+std::optional<std::vector<glm::mat4>>
+read_matrices(accessor_t const &accessor, std::vector<buffer_view_t> const &bufferViews, std::vector<std::vector<std::byte>> const &binBuffers)
+{
+    if (accessor.type != "MAT4"sv || accessor.componentType != kFLOAT || !accessor.bufferView || accessor.sparse)
+        return { };
+
+    auto &&bufferView = bufferViews.at(*accessor.bufferView);
+    auto &&binBuffer = binBuffers.at(bufferView.buffer);
+
+    auto const stride = bufferView.byteStride != 0 ? bufferView.byteStride : sizeof(std::array<float, 16>);
+    auto const offset = accessor.byteOffset + bufferView.byteOffset;
+
+    if (accessor.count != 0 && offset + (accessor.count - 1) * stride + sizeof(std::array<float, 16>) > std::size(binBuffer))
+        return { };
+
+    std::vector<glm::mat4> matrices;
+    matrices.reserve(accessor.count);
+
+    for (std::size_t i = 0; i < accessor.count; ++i) {
+        std::array<float, 16> matrix;
+        std::memcpy(std::data(matrix), std::data(binBuffer) + offset + i * stride, sizeof(matrix));
+
+        matrices.push_back(glm::make_mat4(std::data(matrix)));
+    }
+
+    return matrices;
+}
+
+// Skin joints and animation targets are remapped to the flattened scene nodes, -1 marks glTF nodes out of the scenes.
+void import_skins(scene_data_t &sceneData, std::vector<skin_t> const &skins, std::vector<std::int32_t> const &sceneNodeIndices,
+                  std::vector<accessor_t> const &accessors, std::vector<buffer_view_t> const &bufferViews,
+                  std::vector<std::vector<std::byte>> const &binBuffers)
+{
+    for (auto &&skin : skins) {
+        auto &&sceneSkin = sceneData.skins.emplace_back();
+
+        auto const valid = std::all_of(std::cbegin(skin.joints), std::cend(skin.joints), [&sceneNodeIndices] (auto joint)
+        {
+            return joint < std::size(sceneNodeIndices) && sceneNodeIndices[joint] != -1;
+        });
+
+        if (!valid) {
+            std::cerr << "skin joints are out of the scenes\n"s;
+            continue;
+        }
+
+        std::vector<glm::mat4> inverseBindMatrices(std::size(skin.joints), glm::mat4{1.f});
+
+        if (skin.inverseBindMatrices) {
+            auto matrices = read_matrices(accessors.at(*skin.inverseBindMatrices), bufferViews, binBuffers);
+
+            if (!matrices || std::size(*matrices) < std::size(skin.joints)) {
+                std::cerr << "unsupported skin inverse bind matrices\n"s;
+                continue;
             }
 
-            auto index = indices.back();
-            indices.pop_back();
+            std::copy_n(std::cbegin(*matrices), std::size(skin.joints), std::begin(inverseBindMatrices));
+        }
 
-            auto &&node = nodes.at(index);
+        std::transform(std::cbegin(skin.joints), std::cend(skin.joints), std::back_inserter(sceneSkin.joints), [&sceneNodeIndices] (auto joint)
+        {
+            return static_cast<std::uint32_t>(sceneNodeIndices[joint]);
+        });
+
+        sceneSkin.inverseBindMatrices = std::move(inverseBindMatrices);
+    }
+}
 
-            if (!node.children.empty()) {
-                indicesStack.emplace_back(node.children);
+void import_animations(scene_data_t &sceneData, std::vector<animation_t> const &animations, std::vector<std::int32_t> const &sceneNodeIndices,
+                       std::vector<attribute::buffer_t> const &attributeBuffers)
+{
+    for (auto &&animation : animations) {
+        scene_animation_t sceneAnimation;
+        sceneAnimation.name = animation.name;
+
+        for (auto &&sampler : animation.samplers) {
+            auto &&sceneSampler = sceneAnimation.samplers.emplace_back();
+
+            if (sampler.interpolation == "STEP"sv)
+                sceneSampler.interpolation = eINTERPOLATION::nSTEP;
+
+            else if (sampler.interpolation == "CUBICSPLINE"sv)
+                sceneSampler.interpolation = eINTERPOLATION::nCUBIC_SPLINE;
 
-                parent = handlesStack.back().back();
+            auto times = get_float_values(attributeBuffers.at(sampler.input));
+            auto values = get_float_values(attributeBuffers.at(sampler.output));
+
+            if (!times || !values || !std::is_sorted(std::cbegin(*times), std::cend(*times))) {
+                std::cerr << "unsupported animation sampler accessors: "s << animation.name << '\n';
+                continue;
             }
 
-            handlesStack.back().pop_back();
+            sceneSampler.times = std::move(*times);
+            sceneSampler.values = std::move(*values);
+
+            if (!std::empty(sceneSampler.times))
+                sceneAnimation.duration = std::max(sceneAnimation.duration, sceneSampler.times.back());
         }
 
-        sceneTree.Update();
-        return sceneTree;
-    });
+        for (auto &&channel : animation.channels) {
+            animation_channel_t sceneChannel;
+
+            if (channel.path == "translation"sv)
+                sceneChannel.path = eANIMATION_PATH::nTRANSLATION;
+
+            else if (channel.path == "rotation"sv)
+                sceneChannel.path = eANIMATION_PATH::nROTATION;
+
+            else if (channel.path == "scale"sv)
+                sceneChannel.path = eANIMATION_PATH::nSCALE;
+
+            // Morph target weights aren't supported.
+            else continue;
+
+            if (!channel.node || *channel.node >= std::size(sceneNodeIndices) || sceneNodeIndices[*channel.node] == -1)
+                continue;
+
+            if (channel.sampler >= std::size(sceneAnimation.samplers))
+                continue;
+
+            sceneChannel.node = static_cast<std::uint32_t>(sceneNodeIndices[*channel.node]);
+            sceneChannel.sampler = static_cast<std::uint32_t>(channel.sampler);
+
+            auto &&sampler = sceneAnimation.samplers[channel.sampler];
+
+            sampler.components = sceneChannel.path == eANIMATION_PATH::nROTATION ? 4 : 3;
+
+            auto const valuesPerKey = sampler.components * (sampler.interpolation == eINTERPOLATION::nCUBIC_SPLINE ? 3 : 1);
+
+            if (std::empty(sampler.times) || std::size(sampler.values) != std::size(sampler.times) * valuesPerKey) {
+                std::cerr << "animation sampler keys mismatch: "s << animation.name << '\n';
+                continue;
+            }
+
+            sceneAnimation.channels.push_back(sceneChannel);
+        }
+
+        sceneData.animations.push_back(std::move(sceneAnimation));
+    }
+}
+
+bool LoadScene(std::string_view name, scene_data_t &sceneData, import_options_t const &options)
+{
+    auto current_path = fs::current_path();
+
+    fs::path contents{"contents"s};
+    fs::path folder{std::data(name)};
+
+    if (!fs::exists(current_path / contents))
+        contents = current_path / fs::path{"../"s} / contents;
+
+    folder = contents / folder;
+
+    auto glTF_path = folder / fs::path{"scene.gltf"s};
+
+    std::ifstream glTFFile(glTF_path.native(), std::ios::in | std::ios::binary);
+
+    if (glTFFile.bad() || glTFFile.fail()) {
+        std::cerr << "failed to open file: "s << glTF_path << std::endl;
+        return false;
+    }
+
+    std::string const glTFContents{std::istreambuf_iterator<char>{glTFFile}, std::istreambuf_iterator<char>{}};
+
+    // Import options change the cooked scene as well as the source files do.
+    auto sourceHash = HashBytes(std::data(glTFContents), std::size(glTFContents));
+
+    sourceHash = HashBytes(&options.optimizeOverdraw, sizeof(options.optimizeOverdraw), sourceHash);
+    sourceHash = HashBytes(&options.overdrawThreshold, sizeof(options.overdrawThreshold), sourceHash);
+    sourceHash = HashBytes(&options.quantizeVertices, sizeof(options.quantizeVertices), sourceHash);
+    sourceHash = HashBytes(&options.buildMeshlets, sizeof(options.buildMeshlets), sourceHash);
+    sourceHash = HashBytes(&options.levelOfDetailCount, sizeof(options.levelOfDetailCount), sourceHash);
+    sourceHash = HashBytes(&options.levelOfDetailReduction, sizeof(options.levelOfDetailReduction), sourceHash);
+
+    auto const cookedScenePath = folder / fs::path{"scene.cooked"s};
+
+    if (options.useCookedScene && LoadCookedScene(cookedScenePath, folder, sourceHash, sceneData)) {
+        std::cout << "loaded cooked scene: "s << cookedScenePath << '\n';
+        return true;
+    }
+
+    auto json = nlohmann::json::parse(glTFContents);
+
+    auto scenes = json.at("scenes"s).get<std::vector<glTF::scene_t>>();
+    auto nodes = json.at("nodes"s).get<std::vector<glTF::node_t>>();
+
+    // Flattened scene node of each glTF node, a node instantiated by several scenes refers to the first instance.
+    std::vector<std::int32_t> sceneNodeIndices(std::size(nodes), -1);
+
+    // Depth first flattening keeps parents ahead of their children.
+    for (auto &&scene : scenes) {
+        std::vector<std::pair<std::size_t, std::int32_t>> stack;
+
+        for (auto it = std::crbegin(scene.nodes); it != std::crend(scene.nodes); ++it)
+            stack.emplace_back(*it, -1);
+
+        while (!stack.empty()) {
+            auto const [index, parent] = stack.back();
+            stack.pop_back();
+
+            auto &&node = nodes.at(index);
+
+            auto const nodeIndex = static_cast<std::int32_t>(std::size(sceneData.nodes));
+
+            auto const mesh = node.mesh ? static_cast<std::int32_t>(*node.mesh) : -1;
+
+            auto &&sceneNode = sceneData.nodes.emplace_back();
+
+            sceneNode.name = node.name;
+            sceneNode.parent = parent;
+            sceneNode.localMatrix = get_local_matrix(node);
+
+            std::tie(sceneNode.translation, sceneNode.rotation, sceneNode.scale) = get_local_pose(node);
+
+            sceneNode.posed = std::holds_alternative<std::tuple<vec3, quat, vec3>>(node.transform);
+
+            sceneNode.mesh = mesh;
+            sceneNode.skin = node.skin ? static_cast<std::int32_t>(*node.skin) : -1;
+
+            if (sceneNodeIndices.at(index) == -1)
+                sceneNodeIndices.at(index) = nodeIndex;
+
+            for (auto it = std::crbegin(node.children); it != std::crend(node.children); ++it)
+                stack.emplace_back(*it, nodeIndex);
+        }
+    }
 
     auto meshes = json.at("meshes"s).get<std::vector<glTF::mesh_t>>();
 
@@ -963,13 +1479,13 @@ bool LoadScene(std::string_view name, std::vector<Vertex> &vertices, std::vector
     auto bufferViews = json.at("bufferViews"s).get<std::vector<glTF::buffer_view_t>>();
     auto accessors = json.at("accessors"s).get<std::vector<glTF::accessor_t>>();
 
-#if TEMPORARILY_DISABLED
-    auto images = json.at("images"s).get<std::vector<glTF::image_t>>();
-    auto textures = json.at("textures"s).get<std::vector<glTF::texture_t>>();
-    auto samplers = json.at("samplers"s).get<std::vector<glTF::sampler_t>>();
+    auto images = json.value("images"s, std::vector<glTF::image_t>{ });
+    auto textures = json.value("textures"s, std::vector<glTF::texture_t>{ });
+    auto samplers = json.value("samplers"s, std::vector<glTF::sampler_t>{ });
 
-    auto materials = json.at("materials"s).get<std::vector<glTF::material_t>>();
-#endif
+    auto materials = json.value("materials"s, std::vector<glTF::material_t>{ });
+
+    import_materials(sceneData, name, images, textures, samplers, materials);
 
 #if TEMPORARILY_DISABLED
     auto cameras = json.at("cameras"s).get<std::vector<glTF::camera_t>>();
@@ -1001,125 +1517,416 @@ bool LoadScene(std::string_view name, std::vector<Vertex> &vertices, std::vector
     
     for (auto &&accessor : accessors) {
         if (auto buffer = glTF::instantiate_attribute_buffer(accessor.type, accessor.componentType); buffer) {
-            auto &&bufferView = bufferViews.at(accessor.bufferView);
-            auto &&binBuffer = binBuffers.at(bufferView.buffer);
-
-            std::visit([&accessor, &bufferView, &binBuffer, &attributeBuffers] (auto &&buffer)
+            auto decoded = std::visit([&accessor, &bufferViews, &binBuffers, &attributeBuffers] (auto &&buffer)
             {
                 auto const size = sizeof(typename std::decay_t<decltype(buffer)>::value_type);
 
-                std::size_t const srcBeginIndex = accessor.byteOffset + bufferView.byteOffset;
-                std::size_t const srcEndIndex = srcBeginIndex + accessor.count * size;
-
                 buffer.resize(accessor.count);
 
-                if (bufferView.byteStride != 0)
-                    for (std::size_t srcIndex = srcBeginIndex, dstIndex = 0u; srcIndex < srcEndIndex; srcIndex += bufferView.byteStride, ++dstIndex)
-                        memmove(&buffer.at(dstIndex), &binBuffer.at(srcIndex), size);
+                if (accessor.bufferView) {
+                    auto &&bufferView = bufferViews.at(*accessor.bufferView);
+                    auto &&binBuffer = binBuffers.at(bufferView.buffer);
 
-                else memmove(std::data(buffer), &binBuffer.at(srcBeginIndex), srcEndIndex - srcBeginIndex);
+                    std::size_t const srcBeginIndex = accessor.byteOffset + bufferView.byteOffset;
+                    std::size_t const srcStride = bufferView.byteStride != 0 ? bufferView.byteStride : size;
+
+                    // Elements are 'srcStride' bytes apart, though the last one only takes its own size.
+                    if (accessor.count != 0 && srcBeginIndex + (accessor.count - 1) * srcStride + size > std::size(binBuffer)) {
+                        std::cerr << "accessor is out of buffer bounds\n"s;
+                        return false;
+                    }
+
+                    if (srcStride != size)
+                        for (std::size_t i = 0; i < accessor.count; ++i)
+                            std::memcpy(&buffer[i], &binBuffer[srcBeginIndex + i * srcStride], size);
+
+                    else if (accessor.count != 0)
+                        std::memcpy(std::data(buffer), &binBuffer[srcBeginIndex], accessor.count * size);
+                }
+
+                else std::memset(std::data(buffer), 0, accessor.count * size);
+
+                if (accessor.sparse && !glTF::apply_sparse_accessor(buffer, *accessor.sparse, bufferViews, binBuffers))
+                    return false;
 
                 attributeBuffers.emplace_back(std::move(buffer));
 
+                return true;
+
             }, std::move(buffer.value()));
+
+            if (!decoded)
+                return false;
         }
+
+        // Keeps the decoded buffers indexed as the accessors, matrices are read separately.
+        else attributeBuffers.emplace_back();
     }
 
-    //vertex_buffer_t vertexBuffer;
+    auto skins = json.value("skins"s, std::vector<glTF::skin_t>{ });
+    auto animations = json.value("animations"s, std::vector<glTF::animation_t>{ });
 
-#if NOT_YET_IMPLEMENTED
-    std::vector<glTF::attribute::vertex_attribute_t> vertexAttributes;
-#endif
+    import_skins(sceneData, skins, sceneNodeIndices, accessors, bufferViews, binBuffers);
+    import_animations(sceneData, animations, sceneNodeIndices, attributeBuffers);
+
+    std::map<std::size_t, vertex_stream_t> streams;
+
+    vertex_cache_statistics_t cacheStatisticsBefore, cacheStatisticsAfter;
+    overdraw_statistics_t overdrawStatisticsBefore, overdrawStatisticsAfter;
+
+    std::size_t vertexBytesBefore = 0, vertexBytesAfter = 0;
+
+    struct mesh_primitive_t {
+        std::size_t formatIndex;
+        std::uint32_t primitiveIndex;
+        std::int32_t materialIndex;
+    };
+
+    // Imported primitives of each mesh referenced by the streams they have been placed to.
+    std::vector<std::vector<mesh_primitive_t>> meshPrimitives(std::size(meshes));
 
-    for (auto &&mesh : meshes) {
-        for (auto &&primitive : mesh.primitives) {
-            std::visit([&_indices, offset = std::size(vertices)] (auto &&indices)
+    for (std::size_t meshIndex = 0; meshIndex < std::size(meshes); ++meshIndex) {
+        for (auto &&primitive : meshes[meshIndex].primitives) {
+            auto const semanticsMask = attribute::get_semantics_mask(primitive.attributeAccessors);
+
+            auto const formatIndex = get_vertex_format_index(semanticsMask);
+
+            if (!formatIndex) {
+                std::cerr << "unsupported primitive vertex format\n"s;
+                continue;
+            }
+
+            auto &&stream = streams[*formatIndex];
+
+            auto const vertexOffset = stream.count;
+
+            auto format = instantiate_vertex_format(*formatIndex);
+
+            auto interleaved = std::visit([&primitive, &attributeBuffers, &stream] (auto &&format)
+            {
+                using format_t = std::decay_t<decltype(format)>;
+
+                // Quantized vertices are only produced from the interleaved float ones.
+                if constexpr (vertex_format_traits<format_t>::quantized)
+                    return false;
+
+                else {
+                    if (stream.layout.stride == 0)
+                        stream.layout = make_vertex_layout<format_t>();
+
+                    auto constexpr attributes_number = vertex_format_traits<format_t>::attributes_number;
+
+                    return glTF::interleave_primitive<format_t>(stream, primitive, attributeBuffers, std::make_index_sequence<attributes_number>{});
+                }
+
+            }, *format);
+
+            if (!interleaved) {
+                std::cerr << "failed to interleave primitive vertex attributes\n"s;
+                continue;
+            }
+
+            std::vector<std::uint32_t> primitiveIndices;
+
+            std::visit([&primitiveIndices] (auto &&indices)
             {
-                std::transform(std::begin(indices), std::end(indices), std::back_inserter(_indices), [offset] (auto index)
+                primitiveIndices.resize(std::size(indices));
+
+                std::transform(std::cbegin(indices), std::cend(indices), std::begin(primitiveIndices), [] (auto index)
                 {
-                    return static_cast<std::uint32_t>(offset + index.array.at(0));
+                    return static_cast<std::uint32_t>(index.array.at(0));
                 });
 
             }, attributeBuffers.at(primitive.indices));
 
-            std::vector<semantics_t> semantics;
+            std::vector<meshlet_t> primitiveMeshlets;
 
-            std::vector<attribute::vertex_attribute_t> xxxx;
+            // Simplified index lists along with their geometric errors.
+            std::vector<std::pair<std::vector<std::uint32_t>, float>> primitiveLevelsOfDetail;
 
-#if 0
-            for (auto &&attributeAccessor : primitive.attributeAccessors) {
-                auto [semantic1, index] = attributeAccessor;
+            if (primitive.mode == kTRIANGLES) {
+                auto const stride = stream.layout.stride;
+                auto const vertices = std::data(stream.buffer) + vertexOffset * stride;
+
+                auto vertexCount = stream.count - vertexOffset;
+
+                cacheStatisticsBefore += AnalyzeVertexCache(primitiveIndices, vertexCount);
+
+                vertexCount = WeldVertices(vertices, vertexCount, stride, primitiveIndices);
 
-                std::visit([&attributeBuffers, &xxxx, index] (auto semantic1)
+                OptimizeVertexCache(primitiveIndices, vertexCount);
+
+                auto const &attributeDescriptions = stream.layout.attributeDescriptions;
+
+                auto const position = std::find_if(std::cbegin(attributeDescriptions), std::cend(attributeDescriptions), [] (auto &&description)
                 {
-                    //using semantic_t = decltype(semantic);
+                    return description.location == semantic_location_v<semantic::position>;
+                });
 
-                    //semantics = std::tuple_cat(semantics, std::make_tuple(semantic));
+                // Geometry aware stages require float positions.
+                std::byte const *positions = nullptr;
 
-                    std::visit([&xxxx, semantic = semantic1] (auto attributeBuffer)
-                    {
-                        using attribute_t = typename std::decay_t<decltype(attributeBuffer)>::value_type;
+                if (position != std::cend(attributeDescriptions) && position->format == VK_FORMAT_R32G32B32_SFLOAT)
+                    positions = vertices + position->offset;
 
-                        //using vf_t = std::pair<std::tuple<semantic_t>, std::tuple<attribute_t>>;
+                if (options.optimizeOverdraw && positions != nullptr) {
+                    overdrawStatisticsBefore += AnalyzeOverdraw(primitiveIndices, positions, vertexCount, stride);
 
-                        //xxxx.emplace_back(std::make_pair(semantic, attribute_t{}));
+                    OptimizeOverdraw(primitiveIndices, positions, vertexCount, stride, options.overdrawThreshold);
 
-                        /*auto vertex_format_index = attribute::get_vertex_format_index<vf_t>();
+                    overdrawStatisticsAfter += AnalyzeOverdraw(primitiveIndices, positions, vertexCount, stride);
+                }
+
+                vertexCount = OptimizeVertexFetch(vertices, vertexCount, stride, primitiveIndices);
+
+                cacheStatisticsAfter += AnalyzeVertexCache(primitiveIndices, vertexCount);
+
+                if (options.buildMeshlets && positions != nullptr)
+                    primitiveMeshlets = BuildMeshlets(primitiveIndices, positions, vertexCount, stride);
 
-                        if (vertex_format_index == -1)
-                            throw std::runtime_error("unsupported vertex format"s);*/
+                if (positions != nullptr) {
+                    auto levelIndices = primitiveIndices;
+                    auto levelError = 0.f;
 
-                    }, attributeBuffers.at(index));
+                    for (std::uint32_t level = 0; level < options.levelOfDetailCount; ++level) {
+                        auto const indexCount = std::size(levelIndices);
+                        auto const targetIndexCount = static_cast<std::size_t>(indexCount / 3 * options.levelOfDetailReduction) * 3;
 
-                    //[[maybe_unused]] auto &&accessor = accessors.at(index);
+                        auto const error = SimplifyMesh(levelIndices, vertices, vertexCount, stream.layout, targetIndexCount);
 
-                    /*[[maybe_unused]] auto attribyte_type = std::get<>(glTF::try_to_get_attribute_type(accessor.type, accessor.componentType));
+                        // Stop when the mesh can't be simplified any further.
+                        if (std::empty(levelIndices) || std::size(levelIndices) == indexCount)
+                            break;
 
-                    if (attribyte_type) {
+                        OptimizeVertexCache(levelIndices, vertexCount);
+
+                        // Each level is simplified from the previous one, so the errors are accumulated conservatively.
+                        levelError += error;
+
+                        primitiveLevelsOfDetail.emplace_back(levelIndices, levelError);
                     }
+                }
 
-                    else throw std::runtime_error("unsupported attribute type"s);*/
+                stream.count = vertexOffset + vertexCount;
+                stream.buffer.resize(stream.count * stride);
+            }
+
+            primitive_range_t range;
+
+            auto const vertexCount = stream.count - vertexOffset;
+
+            auto &&positionAccessor = accessors.at(get_accessor_index(primitive, variant_index_v<semantic::position, semantics_t>));
 
-                }, semantic1);
+            auto hasBounds = false;
+
+            // The accessor bounds are used when present, otherwise the imported vertices are scanned.
+            if (std::size(positionAccessor.min) == 3 && std::size(positionAccessor.max) == 3) {
+                std::copy(std::cbegin(positionAccessor.min), std::cend(positionAccessor.min), std::begin(range.boundsMin));
+                std::copy(std::cbegin(positionAccessor.max), std::cend(positionAccessor.max), std::begin(range.boundsMax));
+
+                hasBounds = true;
             }
-#endif
 
-            //static_assert(attribute::is_vertex_format_v<std::pair<std::tuple<semantic::position, semantic::normal>, std::tuple<vec<3, std::float_t>, vec<2, std::float_t>>>>, "33333");
+            else if (vertexCount != 0) {
+                auto const &attributeDescriptions = stream.layout.attributeDescriptions;
 
-#if NOT_YET_IMPLEMENTED
-            for (auto &&accessor : primitive.attributeAccessors) {
-                std::visit([&vertexAttributes, &attributeBuffers] (auto accessor)
+                auto const position = std::find_if(std::cbegin(attributeDescriptions), std::cend(attributeDescriptions), [] (auto &&description)
                 {
-                    auto [semantic, index] = accessor;
+                    return description.location == semantic_location_v<semantic::position>;
+                });
+
+                if (position != std::cend(attributeDescriptions) && position->format == VK_FORMAT_R32G32B32_SFLOAT) {
+                    auto const positions = std::data(stream.buffer) + vertexOffset * stream.layout.stride + position->offset;
+
+                    std::tie(range.boundsMin, range.boundsMax) = ComputePositionBounds(positions, vertexCount, stream.layout.stride);
+
+                    hasBounds = true;
+                }
+            }
+
+            // Stream the primitive is drawn from: the quantized vertices are moved to the stream of the quantized format.
+            auto targetStream = &stream;
+            auto targetFormatIndex = *formatIndex;
+            auto targetVertexOffset = vertexOffset;
+
+            if (auto const quantizedFormatIndex = get_quantized_vertex_format_index(*formatIndex); options.quantizeVertices && quantizedFormatIndex) {
+                auto &&quantizedStream = streams[*quantizedFormatIndex];
+
+                if (quantizedStream.layout.stride == 0)
+                    quantizedStream.layout = make_vertex_layout(*instantiate_vertex_format(*quantizedFormatIndex));
+
+                auto const quantizedStride = quantizedStream.layout.stride;
+
+                if (hasBounds) {
+                    auto const minBound = range.boundsMin;
+                    auto const maxBound = range.boundsMax;
+
+                    quantizedStream.buffer.resize((quantizedStream.count + vertexCount) * quantizedStride);
+
+                    auto const quantized = QuantizeVertices(std::data(quantizedStream.buffer) + quantizedStream.count * quantizedStride, quantizedStream.layout,
+                                                            std::data(stream.buffer) + vertexOffset * stream.layout.stride, stream.layout,
+                                                            vertexCount, minBound, maxBound);
 
-                    /*glTF::attribute::vertex_attribute_t pair = std::make_pair(semantic, std::move(attributeBuffers.at(index)));
+                    if (quantized) {
+                        std::tie(range.positionScale, range.positionOffset) = GetPositionDequantization(minBound, maxBound);
 
-                    vertexAttributes.push_back(std::move(pair));*/
+                        targetStream = &quantizedStream;
+                        targetFormatIndex = *quantizedFormatIndex;
+                        targetVertexOffset = quantizedStream.count;
 
-                    /*std::visit([semantic = semantic, &vertexAttributes] (auto &&buffer)
-                    {
-                        glTF::attribute::vertex_attribute_t pair = std::make_pair(semantic, std::move(buffer));
+                        quantizedStream.count += vertexCount;
 
-                        vertexAttributes.push_back(std::move(pair));
+                        stream.count = vertexOffset;
+                        stream.buffer.resize(stream.count * stream.layout.stride);
+                    }
 
-                    }, attributeBuffers.at(index));*/
+                    else {
+                        quantizedStream.buffer.resize(quantizedStream.count * quantizedStride);
 
-                }, accessor);
+                        std::cerr << "failed to quantize primitive vertices\n"s;
+                    }
+                }
             }
-#endif
 
-            auto &&positions = std::get<std::vector<vec<3, std::float_t>>>(attributeBuffers.at(*primitive.attributes.position));
-            auto &&normals = std::get<std::vector<vec<3, std::float_t>>>(attributeBuffers.at(*primitive.attributes.normal));
-            auto &&uvs = std::get<std::vector<vec<2, std::float_t>>>(attributeBuffers.at(*primitive.attributes.texCoord0));
-            //std::vector<vec<2, std::float_t>> uvs(normals.size());
+            vertexBytesBefore += vertexCount * stream.layout.stride;
+            vertexBytesAfter += vertexCount * targetStream->layout.stride;
+
+            range.indexCount = static_cast<std::uint32_t>(std::size(primitiveIndices));
+            range.vertexOffset = static_cast<std::int32_t>(targetVertexOffset);
+
+            range.firstLevelOfDetail = static_cast<std::uint32_t>(std::size(sceneData.levelsOfDetail));
+            range.levelOfDetailCount = static_cast<std::uint32_t>(std::size(primitiveLevelsOfDetail) + 1);
+
+            sceneData.levelsOfDetail.push_back(level_of_detail_t{0, range.indexCount, 0.f});
+
+            for (auto &&[levelIndices, levelError] : primitiveLevelsOfDetail) {
+                sceneData.levelsOfDetail.push_back(level_of_detail_t{
+                    static_cast<std::uint32_t>(std::size(primitiveIndices)), static_cast<std::uint32_t>(std::size(levelIndices)), levelError
+                });
+
+                primitiveIndices.insert(std::end(primitiveIndices), std::cbegin(levelIndices), std::cend(levelIndices));
+            }
+
+            if (vertexCount <= std::numeric_limits<std::uint16_t>::max()) {
+                range.indexType = VK_INDEX_TYPE_UINT16;
+                range.firstIndex = static_cast<std::uint32_t>(std::size(sceneData.indices16));
+
+                std::transform(std::cbegin(primitiveIndices), std::cend(primitiveIndices), std::back_inserter(sceneData.indices16), [] (auto index)
+                {
+                    return static_cast<std::uint16_t>(index);
+                });
+            }
+
+            else {
+                range.indexType = VK_INDEX_TYPE_UINT32;
+                range.firstIndex = static_cast<std::uint32_t>(std::size(sceneData.indices32));
+
+                sceneData.indices32.insert(std::end(sceneData.indices32), std::cbegin(primitiveIndices), std::cend(primitiveIndices));
+            }
+
+            for (auto level = range.firstLevelOfDetail; level < range.firstLevelOfDetail + range.levelOfDetailCount; ++level)
+                sceneData.levelsOfDetail[level].firstIndex += range.firstIndex;
+
+            range.firstMeshlet = static_cast<std::uint32_t>(std::size(sceneData.meshlets));
+            range.meshletCount = static_cast<std::uint32_t>(std::size(primitiveMeshlets));
 
-            vertices.reserve(std::size(positions));
+            for (auto &&meshlet : primitiveMeshlets) {
+                meshlet.firstIndex += range.firstIndex;
+                sceneData.meshlets.push_back(meshlet);
+            }
+
+            meshPrimitives[meshIndex].push_back(mesh_primitive_t{
+                targetFormatIndex,
+                static_cast<std::uint32_t>(std::size(targetStream->primitives)),
+                primitive.material && *primitive.material < std::size(materials) ? static_cast<std::int32_t>(*primitive.material) : -1
+            });
 
-            for (auto i = 0u; i < std::size(positions); ++i)
-                vertices.emplace_back(positions.at(i).array, normals.at(i).array, uvs.at(i).array);
+            targetStream->primitives.push_back(std::move(range));
         }
     }
 
+    std::cout << "mesh optimization: ACMR "s << cacheStatisticsBefore.ACMR() << " -> "s << cacheStatisticsAfter.ACMR();
+    std::cout << ", ATVR "s << cacheStatisticsBefore.ATVR() << " -> "s << cacheStatisticsAfter.ATVR();
+    std::cout << ", vertices "s << cacheStatisticsBefore.vertices << " -> "s << cacheStatisticsAfter.vertices << '\n';
+
+    if (options.optimizeOverdraw)
+        std::cout << "overdraw optimization: "s << overdrawStatisticsBefore.overdraw() << " -> "s << overdrawStatisticsAfter.overdraw() << '\n';
+
+    if (options.quantizeVertices)
+        std::cout << "vertex quantization: "s << vertexBytesBefore << " -> "s << vertexBytesAfter << " bytes\n"s;
+
+    std::map<std::size_t, std::uint32_t> streamIndices;
+
+    for (auto &&[formatIndex, stream] : streams) {
+        // All primitives of the stream might have been moved to the quantized one.
+        if (stream.count == 0)
+            continue;
+
+        streamIndices.emplace(formatIndex, static_cast<std::uint32_t>(std::size(sceneData.vertexStreams)));
+
+        sceneData.vertexStreams.push_back(std::move(stream));
+    }
+
+    // Geometry of each mesh is imported once, its instances are drawn by a single instanced draw per primitive.
+    std::vector<std::vector<std::uint32_t>> meshInstances(std::size(meshes));
+
+    for (std::size_t nodeIndex = 0; nodeIndex < std::size(sceneData.nodes); ++nodeIndex) {
+        if (auto mesh = sceneData.nodes[nodeIndex].mesh; mesh >= 0 && static_cast<std::size_t>(mesh) < std::size(meshes))
+            meshInstances[mesh].push_back(static_cast<std::uint32_t>(nodeIndex));
+    }
+
+    for (std::size_t meshIndex = 0; meshIndex < std::size(meshes); ++meshIndex) {
+        auto &&instances = meshInstances[meshIndex];
+
+        if (std::empty(instances))
+            continue;
+
+        auto const firstInstance = static_cast<std::uint32_t>(std::size(sceneData.instances));
+        auto const instanceCount = static_cast<std::uint32_t>(std::size(instances));
+
+        sceneData.instances.insert(std::end(sceneData.instances), std::cbegin(instances), std::cend(instances));
+
+        for (auto &&[formatIndex, primitiveIndex, materialIndex] : meshPrimitives[meshIndex]) {
+            auto const streamIndex = streamIndices.at(formatIndex);
+
+            auto &&range = sceneData.vertexStreams[streamIndex].primitives[primitiveIndex];
+
+            sceneData.drawCommands.push_back(draw_command_t{
+                streamIndex, primitiveIndex,
+                range.indexType, range.firstIndex, range.indexCount, range.vertexOffset,
+                materialIndex, firstInstance, instanceCount
+            });
+        }
+    }
+
+    // Grouping by the vertex stream, the index type and the material minimizes pipeline, buffers and descriptor sets rebinding.
+    std::stable_sort(std::begin(sceneData.drawCommands), std::end(sceneData.drawCommands), [] (auto &&lhs, auto &&rhs)
+    {
+        return std::tie(lhs.streamIndex, lhs.indexType, lhs.materialIndex) < std::tie(rhs.streamIndex, rhs.indexType, rhs.materialIndex);
+    });
+
+    std::cout << "materials: "s << std::size(sceneData.materials) << ", textures: "s << std::size(sceneData.textures);
+    std::cout << ", images: "s << std::size(sceneData.images) << ", samplers: "s << std::size(sceneData.samplers) << '\n';
+
+    std::cout << "draw commands: "s << std::size(sceneData.drawCommands) << ", mesh instances: "s << std::size(sceneData.instances) << '\n';
+
+    std::cout << "indices: "s << std::size(sceneData.indices16) << " 16-bit, "s << std::size(sceneData.indices32) << " 32-bit\n"s;
+
+    if (options.buildMeshlets)
+        std::cout << "meshlets: "s << std::size(sceneData.meshlets) << '\n';
+
+    if (options.levelOfDetailCount != 0)
+        std::cout << "levels of detail: "s << std::size(sceneData.levelsOfDetail) << '\n';
+
+    if (options.useCookedScene) {
+        std::vector<std::string> bufferURIs;
+
+        std::transform(std::cbegin(buffers), std::cend(buffers), std::back_inserter(bufferURIs), [] (auto &&buffer) { return buffer.uri; });
+
+        if (!SaveCookedScene(cookedScenePath, folder, sourceHash, bufferURIs, sceneData))
+            std::cerr << "failed to save cooked scene: "s << cookedScenePath << '\n';
+    }
+
     return true;
 }
 }
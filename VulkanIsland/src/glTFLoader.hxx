@@ -3,8 +3,166 @@
 #include "main.hxx"
 #include "helpers.hxx"
 #include "math.hxx"
+#include "mesh.hxx"
+#include "mesh_optimizer.hxx"
+
+// Scene node of the flattened hierarchy: parents always precede their children.
+struct scene_node_t {
+    std::string name;
+
+    // Index of the parent node or -1 for root nodes.
+    std::int32_t parent{-1};
+
+    glm::mat4 localMatrix{1.f};
+
+    // Rest pose of the nodes defined by translation, rotation and scale, identity if the node has a matrix instead.
+    // Only such nodes may be animated, the animated pose replaces the local matrix.
+    glm::vec3 translation{0.f};
+    glm::quat rotation{1.f, 0.f, 0.f, 0.f};
+    glm::vec3 scale{1.f};
+
+    // The node is defined by the rest pose, the identity pose alone doesn't tell it from a node with an identity matrix.
+    // The local matrices of such nodes are composed from their poses by the scene tree update.
+    bool posed{false};
+
+    // Index of the instantiated mesh or -1.
+    std::int32_t mesh{-1};
+
+    // Index of the skin deforming the mesh or -1.
+    std::int32_t skin{-1};
+};
+
+// Joints are scene node indices, each one has an inverse bind matrix.
+struct scene_skin_t {
+    std::vector<std::uint32_t> joints;
+    std::vector<glm::mat4> inverseBindMatrices;
+};
+
+enum class eINTERPOLATION : std::uint32_t {
+    nSTEP = 0, nLINEAR, nCUBIC_SPLINE
+};
+
+enum class eANIMATION_PATH : std::uint32_t {
+    nTRANSLATION = 0, nROTATION, nSCALE
+};
+
+// Key times and values of an animated property, rotations are stored as (x, y, z, w) quaternions.
+// Cubic-spline samplers store an in-tangent, a value and an out-tangent for each key.
+struct animation_sampler_t {
+    std::vector<float> times;
+    std::vector<float> values;
+
+    std::uint32_t components{3};
+    eINTERPOLATION interpolation{eINTERPOLATION::nLINEAR};
+};
+
+struct animation_channel_t {
+    std::uint32_t sampler{0};
+
+    // Index of the animated scene node.
+    std::uint32_t node{0};
+
+    eANIMATION_PATH path{eANIMATION_PATH::nTRANSLATION};
+};
+
+struct scene_animation_t {
+    std::string name;
+
+    std::vector<animation_sampler_t> samplers;
+    std::vector<animation_channel_t> channels;
+
+    // Time of the last key of all the samplers.
+    float duration{0.f};
+};
+
+// Unique sampler state.
+struct scene_sampler_t {
+    VkFilter minFilter{VK_FILTER_LINEAR}, magFilter{VK_FILTER_LINEAR};
+    VkSamplerMipmapMode mipmapMode{VK_SAMPLER_MIPMAP_MODE_LINEAR};
+    VkSamplerAddressMode addressModeU{VK_SAMPLER_ADDRESS_MODE_REPEAT}, addressModeV{VK_SAMPLER_ADDRESS_MODE_REPEAT};
+
+    bool operator== (scene_sampler_t const &rhs) const noexcept
+    {
+        return std::tie(minFilter, magFilter, mipmapMode, addressModeU, addressModeV) ==
+               std::tie(rhs.minFilter, rhs.magFilter, rhs.mipmapMode, rhs.addressModeU, rhs.addressModeV);
+    }
+};
+
+// Unique image and sampler pair, -1 image refers to an image that can't be loaded.
+struct scene_texture_t {
+    std::int32_t image{-1};
+    std::uint32_t sampler{0};
+};
+
+// Texture indices refer to the scene textures, -1 if the material has no such texture.
+struct scene_material_t {
+    std::array<float, 4> baseColorFactor{1.f, 1.f, 1.f, 1.f};
+    std::array<float, 3> emissiveFactor{0.f, 0.f, 0.f};
+
+    float metallicFactor{1.f}, roughnessFactor{1.f};
+
+    std::int32_t baseColorTexture{-1}, metallicRoughnessTexture{-1};
+    std::int32_t normalTexture{-1}, occlusionTexture{-1}, emissiveTexture{-1};
+
+    bool doubleSided{false};
+};
+
+struct scene_data_t {
+    std::vector<vertex_stream_t> vertexStreams;
+
+    std::vector<std::uint16_t> indices16;
+    std::vector<std::uint32_t> indices32;
+
+    std::vector<meshlet_t> meshlets;
+
+    std::vector<level_of_detail_t> levelsOfDetail;
+
+    std::vector<scene_node_t> nodes;
+
+    std::vector<scene_skin_t> skins;
+    std::vector<scene_animation_t> animations;
+
+    // Node indices of the mesh instances grouped by mesh, the groups are referenced by the draw commands.
+    std::vector<std::uint32_t> instances;
+
+    std::vector<draw_command_t> drawCommands;
+
+    // Unique image paths relative to the contents folder.
+    std::vector<std::string> images;
+
+    std::vector<scene_sampler_t> samplers;
+    std::vector<scene_texture_t> textures;
+
+    // Draw command material indices refer to the scene materials.
+    std::vector<scene_material_t> materials;
+};
 
 namespace glTF
 {
-bool LoadScene(std::string_view name, std::vector<Vertex> &vertices, std::vector<std::uint32_t> &indices);
+struct import_options_t {
+    // Reorders triangle clusters of each primitive to reduce overdraw, costs extra import time.
+    bool optimizeOverdraw{false};
+
+    // Maximal allowed vertex cache efficiency degradation caused by overdraw optimization.
+    float overdrawThreshold{1.05f};
+
+    // Stores primitives using quantized vertex formats where one is available.
+    bool quantizeVertices{false};
+
+    // Splits triangle primitives into meshlets with culling bounds.
+    bool buildMeshlets{false};
+
+    // Number of simplified levels of detail generated for each triangle primitive.
+    std::uint32_t levelOfDetailCount{0};
+
+    // Index count ratio of each level of detail to the previous one.
+    float levelOfDetailReduction{.5f};
+
+    // Reads the cooked scene instead of the glTF one when it's up to date, otherwise cooks it.
+    bool useCookedScene{true};
+};
+
+// Indices of primitives having less than 65536 vertices are stored in 'indices16', the rest ones go to 'indices32'.
+// The result is cooked next to the source scene and is used instead of it while the source stays unchanged.
+bool LoadScene(std::string_view name, scene_data_t &scene, import_options_t const &options = { });
 }
\ No newline at end of file
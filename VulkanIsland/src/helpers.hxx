@@ -7,6 +7,8 @@
 #include <cmath>
 #include <type_traits>
 #include <chrono>
+#include <array>
+#include <new>
 
 template<class C, class = void>
 struct is_iterable : std::false_type {};
@@ -108,6 +110,61 @@ struct wrap_variant_by_vector<std::variant<Ts...>> {
     using type = std::variant<std::vector<Ts>...>;
 };
 
+template<class T, class V>
+struct variant_index;
+
+template<class T, class... Ts>
+struct variant_index<T, std::variant<Ts...>> {
+    static auto constexpr value = [] ()
+    {
+        auto constexpr matches = std::array<bool, sizeof...(Ts)>{{ std::is_same_v<T, Ts>... }};
+
+        std::size_t index = 0;
+
+        while (index < std::size(matches) && !matches[index])
+            ++index;
+
+        return index;
+    } ();
+
+    static_assert(value < sizeof...(Ts), "type isn't an alternative of the variant");
+};
+
+template<class T, class V>
+auto constexpr variant_index_v = variant_index<T, V>::value;
+
+// Allocator of storage aligned to 'A' bytes, e.g. to a cache line.
+template<class T, std::size_t A>
+struct aligned_allocator {
+    using value_type = T;
+
+    template<class U>
+    struct rebind {
+        using other = aligned_allocator<U, A>;
+    };
+
+    aligned_allocator() = default;
+
+    template<class U>
+    constexpr aligned_allocator(aligned_allocator<U, A> const &) noexcept { }
+
+    [[nodiscard]] T *allocate(std::size_t n)
+    {
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t{A}));
+    }
+
+    void deallocate(T *pointer, std::size_t) noexcept
+    {
+        ::operator delete(pointer, std::align_val_t{A});
+    }
+
+    template<class U>
+    bool operator== (aligned_allocator<U, A> const &) const noexcept { return true; }
+
+    template<class U>
+    bool operator!= (aligned_allocator<U, A> const &) const noexcept { return false; }
+};
+
 
 // A function execution duration measurement.
 template<typename TimeT = std::chrono::milliseconds>
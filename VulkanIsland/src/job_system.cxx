@@ -0,0 +1,118 @@
+#include <optional>
+
+#include "job_system.hxx"
+
+
+JobSystem::JobSystem(std::size_t threadsNumber)
+{
+    if (threadsNumber == 0)
+        threadsNumber = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for (std::size_t i = 0; i < threadsNumber; ++i)
+        queues_.push_back(std::make_unique<queue_t>());
+
+    // The calling thread owns the first queue.
+    for (std::size_t thread = 1; thread < threadsNumber; ++thread)
+        workers_.emplace_back(&JobSystem::Work, this, thread);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        stop_ = true;
+    }
+
+    wakeup_.notify_all();
+
+    for (auto &&worker : workers_)
+        worker.join();
+}
+
+void JobSystem::Run(batch_t &batch, std::size_t count, std::size_t chunkSize)
+{
+    auto const jobsNumber = (count + chunkSize - 1) / chunkSize;
+    auto const threadsNumber = std::size(queues_);
+
+    batch.pendingJobs = jobsNumber;
+
+    // Consecutive chunks are dealt to the threads in turns, the stealing evens out the rest.
+    for (std::size_t thread = 0; thread < threadsNumber; ++thread) {
+        auto &&queue = *queues_[thread];
+
+        std::lock_guard<std::mutex> lock{queue.mutex};
+
+        for (auto job = thread; job < jobsNumber; job += threadsNumber) {
+            auto const begin = job * chunkSize;
+            queue.jobs.push_back(job_t{&batch, begin, std::min(begin + chunkSize, count)});
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        queuedJobs_ += jobsNumber;
+    }
+
+    wakeup_.notify_all();
+
+    while (batch.pendingJobs.load(std::memory_order_acquire) != 0)
+        if (!RunJob(0))
+            std::this_thread::yield();
+}
+
+bool JobSystem::RunJob(std::size_t thread)
+{
+    auto const threadsNumber = std::size(queues_);
+
+    std::optional<job_t> job;
+
+    {
+        auto &&queue = *queues_[thread];
+
+        std::lock_guard<std::mutex> lock{queue.mutex};
+
+        if (!std::empty(queue.jobs)) {
+            job = queue.jobs.back();
+            queue.jobs.pop_back();
+
+            --queuedJobs_;
+        }
+    }
+
+    for (std::size_t i = 1; !job && i < threadsNumber; ++i) {
+        auto &&queue = *queues_[(thread + i) % threadsNumber];
+
+        std::lock_guard<std::mutex> lock{queue.mutex};
+
+        if (!std::empty(queue.jobs)) {
+            job = queue.jobs.front();
+            queue.jobs.pop_front();
+
+            --queuedJobs_;
+        }
+    }
+
+    if (!job)
+        return false;
+
+    auto &&batch = *job->batch;
+
+    batch.invoke(batch.function, job->begin, job->end, thread);
+
+    // The batch may be gone right after the last job has been completed.
+    batch.pendingJobs.fetch_sub(1, std::memory_order_release);
+
+    return true;
+}
+
+void JobSystem::Work(std::size_t thread)
+{
+    while (!stop_) {
+        if (RunJob(thread))
+            continue;
+
+        std::unique_lock<std::mutex> lock{mutex_};
+
+        wakeup_.wait(lock, [this] { return stop_ || queuedJobs_ != 0; });
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "main.hxx"
+
+
+auto constexpr kCACHE_LINE_SIZE = 64u;
+
+// Pool of worker threads with a job queue per thread. A thread takes its own jobs from the back of its queue and steals
+// the ones from the front of the other queues once its queue is empty, so unevenly sized jobs are balanced between the threads.
+class JobSystem final {
+public:
+
+    // Uses all hardware threads if 'threadsNumber' is zero, the calling thread is counted as one of them.
+    explicit JobSystem(std::size_t threadsNumber = 0);
+    ~JobSystem();
+
+    JobSystem(JobSystem const &) = delete;
+    JobSystem &operator= (JobSystem const &) = delete;
+
+    std::size_t threadsNumber() const noexcept { return std::size(queues_); }
+
+    // Calls 'function(begin, end, thread)' for the chunks of [0, count) of 'chunkSize' elements and returns once all of them
+    // have been processed, i.e. the call is a barrier. 'thread' is less than threadsNumber() and allows per thread scratch data.
+    // The calling thread processes the chunks as well, so the call must not be issued from the jobs or from several threads.
+    template<class F>
+    void ParallelFor(std::size_t count, std::size_t chunkSize, F &&function);
+
+private:
+
+    struct batch_t final {
+        void (*invoke)(void *function, std::size_t begin, std::size_t end, std::size_t thread);
+        void *function;
+
+        std::atomic<std::size_t> pendingJobs{0};
+    };
+
+    struct job_t final {
+        batch_t *batch;
+        std::size_t begin, end;
+    };
+
+    struct alignas(kCACHE_LINE_SIZE) queue_t final {
+        std::mutex mutex;
+        std::deque<job_t> jobs;
+    };
+
+    std::vector<std::unique_ptr<queue_t>> queues_;
+
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+
+    std::atomic<std::size_t> queuedJobs_{0};
+    std::atomic<bool> stop_{false};
+
+    std::vector<std::thread> workers_;
+
+    void Run(batch_t &batch, std::size_t count, std::size_t chunkSize);
+
+    // Runs one job of the thread's queue or a stolen one, returns false if all the queues are empty.
+    bool RunJob(std::size_t thread);
+
+    void Work(std::size_t thread);
+};
+
+template<class F>
+void JobSystem::ParallelFor(std::size_t count, std::size_t chunkSize, F &&function)
+{
+    if (count == 0)
+        return;
+
+    chunkSize = std::max(chunkSize, std::size_t{1});
+
+    if (count <= chunkSize || threadsNumber() == 1) {
+        for (std::size_t begin = 0; begin < count; begin += chunkSize)
+            function(begin, std::min(begin + chunkSize, count), std::size_t{0});
+
+        return;
+    }
+
+    batch_t batch;
+
+    batch.function = const_cast<void *>(static_cast<void const *>(std::addressof(function)));
+    batch.invoke = [] (void *function, std::size_t begin, std::size_t end, std::size_t thread)
+    {
+        (*static_cast<std::remove_reference_t<F> *>(function))(begin, end, thread);
+    };
+
+    Run(batch, count, chunkSize);
+}
@@ -11,8 +11,13 @@
 #include <crtdbg.h>
 #endif
 
+#include <atomic>
 #include <chrono>
+#include <cstddef>
 #include <cmath>
+#include <map>
+#include <numeric>
+#include <thread>
 #include <unordered_map>
 
 #ifdef _MSC_VER
@@ -31,28 +36,86 @@
 #include "resource.hxx"
 #include "command_buffer.hxx"
 
+#include "mesh.hxx"
 #include "glTFLoader.hxx"
 #include "TARGA_loader.hxx"
 
 #include "scene_tree.hxx"
+#include "world_matrices_buffer.hxx"
+#include "bounding_volume_hierarchy.hxx"
+#include "scene_streamer.hxx"
 
 
 #define USE_GLM 1
 
 
+// The model transforms are the scene tree world matrices read from the WORLD_MATRICES storage buffer.
 struct transforms_t {
 #if !USE_GLM
-    mat4 model;
     mat4 view;
     mat4 proj;
 #else
-    glm::mat4 model;
     glm::mat4 view;
     glm::mat4 proj;
-    glm::mat4 modelView;
 #endif
 };
 
+// Per draw data, matches the DRAWS storage buffer of the vertex shaders.
+struct draw_data_t {
+    // Quantized positions are restored as 'position * positionScale + positionOffset'.
+    std::array<float, 4> positionScale;
+    std::array<float, 4> positionOffset;
+
+    // The first component is the material index.
+    std::array<std::int32_t, 4> material;
+};
+
+// Per material data, matches the MATERIALS storage buffer of the fragment shader.
+struct material_data_t {
+    std::array<float, 4> baseColorFactor;
+};
+
+// Values of the vertex shader inputs missing from a vertex stream, fetched through a zero stride binding.
+struct default_vertex_attributes_t {
+    std::array<float, 3> normal{0.f, 0.f, 1.f};
+    std::array<float, 2> texCoord{0.f, 0.f};
+};
+
+auto constexpr kDEFAULT_ATTRIBUTES_BINDING = 1u;
+
+// Per instance data fetched by the instance index, matches the INSTANCES storage buffer of the vertex shaders.
+struct instance_data_t {
+    // The index of the instance draw data and the node index of the instance scene tree node,
+    // the latter one indexes the WORLD_MATRICES storage buffer.
+    std::array<std::uint32_t, 4> draw;
+};
+
+// Transfers of a frame recorded to a command buffer of the graphics queue and submitted ahead of the frame draws, so they
+// are ordered after the previous frames by the barriers alone. The staging buffers are released once the fence is signaled.
+struct upload_t final {
+    VkCommandBuffer commandBuffer{VK_NULL_HANDLE};
+    VkFence fence{VK_NULL_HANDLE};
+
+    std::vector<std::shared_ptr<VulkanBuffer>> stagingBuffers;
+
+    // Scene image indices and textures written by the upload, they are usable once the fence is signaled.
+    std::vector<std::pair<std::size_t, VulkanTexture>> textures;
+};
+
+// Data to be copied to the draw input buffers, all the regions share a single staging buffer.
+struct staged_copies_t final {
+    std::vector<std::byte> data;
+    std::map<VkBuffer, std::vector<VkBufferCopy>> regions;
+
+    void Stage(VkBuffer buffer, void const *bytes, std::size_t size, VkDeviceSize offset)
+    {
+        regions[buffer].push_back(VkBufferCopy{std::size(data), offset, size});
+
+        auto const begin = static_cast<std::byte const *>(bytes);
+        data.insert(std::end(data), begin, begin + size);
+    }
+};
+
 
 struct app_t final {
     transforms_t transforms;
@@ -60,8 +123,7 @@ struct app_t final {
     std::uint32_t width{800u};
     std::uint32_t height{600u};
 
-    std::vector<Vertex> vertices;
-    std::vector<std::uint32_t> indices;
+    scene_data_t scene;
 
     std::unique_ptr<VulkanInstance> vulkanInstance;
     std::unique_ptr<VulkanDevice> vulkanDevice;
@@ -75,21 +137,86 @@ struct app_t final {
 
     VkPipelineLayout pipelineLayout;
     VkRenderPass renderPass;
-    VkPipeline graphicsPipeline;
+
+    // A pipeline per vertex stream layout.
+    std::vector<VkPipeline> graphicsPipelines;
 
     VkCommandPool graphicsCommandPool, transferCommandPool;
 
-    VkDescriptorSetLayout descriptorSetLayout;
-    VkDescriptorPool descriptorPool;
-    VkDescriptorSet descriptorSet;
+    VkDescriptorSetLayout descriptorSetLayout, materialDescriptorSetLayout;
+    VkDescriptorPool descriptorPool{VK_NULL_HANDLE};
+    VkDescriptorSet descriptorSet{VK_NULL_HANDLE};
+
+    // A descriptor set per scene material followed by the default material one.
+    std::vector<VkDescriptorSet> materialDescriptorSets;
 
     std::vector<VkCommandBuffer> commandBuffers;
 
+    // Submitted uploads which haven't been completed by the device yet.
+    std::vector<upload_t> uploads;
+
     VkSemaphore imageAvailableSemaphore, renderFinishedSemaphore;
 
-    std::shared_ptr<VulkanBuffer> vertexBuffer, indexBuffer, uboBuffer;
+    // Signaled once the last submitted frame has been completed, a single frame is in flight at most.
+    VkFence frameFence{VK_NULL_HANDLE};
+
+    std::vector<std::shared_ptr<VulkanBuffer>> vertexBuffers;
+    std::shared_ptr<VulkanBuffer> indexBuffer16, indexBuffer32, uboBuffer;
+
+    // A single default_vertex_attributes_t bound to the kDEFAULT_ATTRIBUTES_BINDING binding.
+    std::shared_ptr<VulkanBuffer> defaultAttributesBuffer;
+
+    // Indirect draw commands and per draw data in the scene draw commands order, and per instance transforms.
+    std::shared_ptr<VulkanBuffer> indirectBuffer, drawDataBuffer, instanceDataBuffer, materialDataBuffer;
+
+    // A texture per scene image, images that failed to load are replaced by the default texture.
+    std::vector<std::optional<VulkanTexture>> textures;
+    VulkanTexture defaultTexture;
+
+    // A sampler per scene sampler followed by the default sampler.
+    std::vector<std::shared_ptr<VulkanSampler>> samplers;
+
+    // Local bounds of the instance data primitives and the hierarchy over their world space bounds.
+    std::vector<aabb_t> instanceLocalBounds;
+    BoundingVolumeHierarchy sceneHierarchy;
+
+    // The scene nodes hierarchy, the world matrices of the nodes changed by its update are synced to the device each frame.
+    SceneTree sceneTree;
+
+    // Scene tree nodes of the instance data instances.
+    std::vector<NodeHandle> instanceNodes;
 
-    VulkanTexture texture;
+    std::unique_ptr<WorldMatricesBuffer> worldMatricesBuffer;
+
+    // Streams the scene content in the background while the frames are presented,
+    // otherwise the whole scene is loaded and uploaded before the first frame.
+    bool streamScene{true};
+
+    // Maximal number of bytes uploaded to the device per frame while the scene is streamed.
+    std::size_t streamingBudget{16u << 20};
+
+    std::unique_ptr<SceneStreamer> sceneStreamer;
+
+    // Indirect draw commands with their actual instance counts, the device copy has no instances
+    // for the draws which buffers haven't landed yet, so they are skipped by the recorded indirect draws.
+    std::vector<VkDrawIndexedIndirectCommand> indirectCommands;
+
+    std::vector<std::size_t> pendingDraws;
+    std::vector<std::pair<std::size_t, RawImage>> pendingImages;
+
+    // Textures of the retired uploads waiting for no frame in flight to replace the default texture in the material descriptor sets.
+    std::vector<std::pair<std::size_t, VulkanTexture>> landedTextures;
+
+    // The levels of detail are picked per draw for its nearest instance, so that the geometric error
+    // of the level projects to at most that many pixels. The indirect commands hold the index ranges of the picked levels.
+    float levelOfDetailPixelError{1.f};
+
+    std::vector<std::size_t> drawLevels;
+
+    // The largest scale of the draw instances transforms, the errors of the levels are in the primitive space.
+    std::vector<float> drawErrorScales;
+
+    std::chrono::high_resolution_clock::time_point streamingStartTime;
 };
 
 
@@ -124,15 +251,18 @@ std::shared_ptr<VulkanBuffer> StageData(VulkanDevice &device, T &&container)
 }
 
 
-void CleanupFrameData(app_t &app, VulkanDevice &device, VkPipeline graphicsPipeline, VkPipelineLayout pipelineLayout, VkRenderPass renderPass)
+void CleanupFrameData(app_t &app, VulkanDevice &device, std::vector<VkPipeline> &graphicsPipelines, VkPipelineLayout pipelineLayout, VkRenderPass renderPass)
 {
     if (app.graphicsCommandPool)
         vkFreeCommandBuffers(device.handle(), app.graphicsCommandPool, static_cast<std::uint32_t>(std::size(app.commandBuffers)), std::data(app.commandBuffers));
 
     app.commandBuffers.clear();
 
-    if (graphicsPipeline)
-        vkDestroyPipeline(device.handle(), graphicsPipeline, nullptr);
+    for (auto graphicsPipeline : graphicsPipelines)
+        if (graphicsPipeline)
+            vkDestroyPipeline(device.handle(), graphicsPipeline, nullptr);
+
+    graphicsPipelines.clear();
 
     if (pipelineLayout)
         vkDestroyPipelineLayout(device.handle(), pipelineLayout, nullptr);
@@ -146,16 +276,31 @@ void CleanupFrameData(app_t &app, VulkanDevice &device, VkPipeline graphicsPipel
 
 void CreateDescriptorSetLayout(VkDevice device, VkDescriptorSetLayout &descriptorSetLayout)
 {
-    std::array<VkDescriptorSetLayoutBinding, 2> constexpr layoutBindings{{
+    std::array<VkDescriptorSetLayoutBinding, 5> constexpr layoutBindings{{
         {
             0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
             1, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
             nullptr
         },
         {
-            1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
             1, VK_SHADER_STAGE_FRAGMENT_BIT,
             nullptr
+        },
+        {
+            2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            1, VK_SHADER_STAGE_VERTEX_BIT,
+            nullptr
+        },
+        {
+            3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            1, VK_SHADER_STAGE_VERTEX_BIT,
+            nullptr
+        },
+        {
+            4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            1, VK_SHADER_STAGE_VERTEX_BIT,
+            nullptr
         }
     }};
 
@@ -169,17 +314,38 @@ void CreateDescriptorSetLayout(VkDevice device, VkDescriptorSetLayout &descripto
         throw std::runtime_error("failed to create descriptor set layout: "s + std::to_string(result));
 }
 
-void CreateDescriptorPool(VkDevice device, VkDescriptorPool &descriptorPool)
+void CreateMaterialDescriptorSetLayout(VkDevice device, VkDescriptorSetLayout &descriptorSetLayout)
+{
+    std::array<VkDescriptorSetLayoutBinding, 1> constexpr layoutBindings{{
+        {
+            0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            1, VK_SHADER_STAGE_FRAGMENT_BIT,
+            nullptr
+        }
+    }};
+
+    VkDescriptorSetLayoutCreateInfo const createInfo{
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        nullptr, 0,
+        static_cast<std::uint32_t>(std::size(layoutBindings)), std::data(layoutBindings)
+    };
+
+    if (auto result = vkCreateDescriptorSetLayout(device, &createInfo, nullptr, &descriptorSetLayout); result != VK_SUCCESS)
+        throw std::runtime_error("failed to create material descriptor set layout: "s + std::to_string(result));
+}
+
+void CreateDescriptorPool(VkDevice device, VkDescriptorPool &descriptorPool, std::uint32_t materialsNumber)
 {
-    std::array<VkDescriptorPoolSize, 2> constexpr poolSizes{{
+    std::array<VkDescriptorPoolSize, 3> const poolSizes{{
         { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 },
-        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1 }
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, materialsNumber },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4 }
     }};
 
     VkDescriptorPoolCreateInfo const createInfo{
         VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
         nullptr, 0,
-        1,
+        1 + materialsNumber,
         static_cast<std::uint32_t>(std::size(poolSizes)), std::data(poolSizes)
     };
 
@@ -187,6 +353,28 @@ void CreateDescriptorPool(VkDevice device, VkDescriptorPool &descriptorPool)
         throw std::runtime_error("failed to create descriptor pool: "s + std::to_string(result));
 }
 
+// The world matrices buffer is recreated when the scene tree outgrows it, so its descriptor is written apart from the rest ones.
+void UpdateWorldMatricesDescriptorSet(app_t &app, VkDevice device, VkDescriptorSet descriptorSet)
+{
+    auto const worldMatrices = make_array(
+        VkDescriptorBufferInfo{app.worldMatricesBuffer->buffer()->handle(), 0, VK_WHOLE_SIZE}
+    );
+
+    VkWriteDescriptorSet const writeDescriptorSet{
+        VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        nullptr,
+        descriptorSet,
+        4,
+        0, static_cast<std::uint32_t>(std::size(worldMatrices)),
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        nullptr,
+        std::data(worldMatrices),
+        nullptr
+    };
+
+    vkUpdateDescriptorSets(device, 1, &writeDescriptorSet, 0, nullptr);
+}
+
 void CreateDescriptorSet(app_t &app, VkDevice device, VkDescriptorSet &descriptorSet)
 {
     auto layouts = make_array(app.descriptorSetLayout);
@@ -207,11 +395,17 @@ void CreateDescriptorSet(app_t &app, VkDevice device, VkDescriptorSet &descripto
     );
 
     // TODO: descriptor info typed by VkDescriptorType.
-    auto const images = make_array(
-        VkDescriptorImageInfo{app.texture.sampler->handle(), app.texture.view.handle(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL}
+    auto const fragmentStorageBuffers = make_array(
+        VkDescriptorBufferInfo{app.materialDataBuffer->handle(), 0, VK_WHOLE_SIZE}
+    );
+
+    // TODO: descriptor info typed by VkDescriptorType.
+    auto const vertexStorageBuffers = make_array(
+        VkDescriptorBufferInfo{app.drawDataBuffer->handle(), 0, VK_WHOLE_SIZE},
+        VkDescriptorBufferInfo{app.instanceDataBuffer->handle(), 0, VK_WHOLE_SIZE}
     );
 
-    std::array<VkWriteDescriptorSet, 2> const writeDescriptorsSet{{
+    std::array<VkWriteDescriptorSet, 3> const writeDescriptorsSet{{
         {
             VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
             nullptr,
@@ -228,15 +422,93 @@ void CreateDescriptorSet(app_t &app, VkDevice device, VkDescriptorSet &descripto
             nullptr,
             descriptorSet,
             1,
-            0, static_cast<std::uint32_t>(std::size(images)),
-            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-            std::data(images),
+            0, static_cast<std::uint32_t>(std::size(fragmentStorageBuffers)),
+            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            nullptr,
+            std::data(fragmentStorageBuffers),
+            nullptr
+        },
+        {
+            VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
             nullptr,
+            descriptorSet,
+            2,
+            0, static_cast<std::uint32_t>(std::size(vertexStorageBuffers)),
+            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            nullptr,
+            std::data(vertexStorageBuffers),
             nullptr
         }
     }};
 
     vkUpdateDescriptorSets(device, static_cast<std::uint32_t>(std::size(writeDescriptorsSet)), std::data(writeDescriptorsSet), 0, nullptr);
+
+    UpdateWorldMatricesDescriptorSet(app, device, descriptorSet);
+}
+
+// The materials without a base color texture or which texture hasn't been loaded yet use the default one.
+// Written sets invalidate the command buffers they are bound to, so the command buffers have to be recorded again.
+void UpdateMaterialDescriptorSets(app_t &app, VkDevice device, std::vector<VkDescriptorSet> const &descriptorSets)
+{
+    auto &&materials = app.scene.materials;
+
+    std::vector<VkDescriptorImageInfo> images;
+    images.reserve(std::size(descriptorSets));
+
+    for (std::size_t i = 0; i < std::size(descriptorSets); ++i) {
+        auto texture = &app.defaultTexture;
+        auto sampler = app.samplers.back().get();
+
+        if (i < std::size(materials) && materials[i].baseColorTexture >= 0) {
+            auto &&sceneTexture = app.scene.textures.at(static_cast<std::size_t>(materials[i].baseColorTexture));
+
+            if (sceneTexture.image >= 0) {
+                if (auto &&imageTexture = app.textures.at(static_cast<std::size_t>(sceneTexture.image)); imageTexture) {
+                    texture = &imageTexture.value();
+                    sampler = app.samplers.at(sceneTexture.sampler).get();
+                }
+            }
+        }
+
+        images.push_back(VkDescriptorImageInfo{sampler->handle(), texture->view.handle(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL});
+    }
+
+    std::vector<VkWriteDescriptorSet> writeDescriptorsSet;
+
+    for (std::size_t i = 0; i < std::size(descriptorSets); ++i) {
+        writeDescriptorsSet.push_back(VkWriteDescriptorSet{
+            VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            nullptr,
+            descriptorSets[i],
+            0,
+            0, 1,
+            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            &images[i],
+            nullptr,
+            nullptr
+        });
+    }
+
+    vkUpdateDescriptorSets(device, static_cast<std::uint32_t>(std::size(writeDescriptorsSet)), std::data(writeDescriptorsSet), 0, nullptr);
+}
+
+void CreateMaterialDescriptorSets(app_t &app, VkDevice device, std::vector<VkDescriptorSet> &descriptorSets)
+{
+    std::vector<VkDescriptorSetLayout> const layouts(std::size(app.scene.materials) + 1, app.materialDescriptorSetLayout);
+
+    descriptorSets.resize(std::size(layouts));
+
+    VkDescriptorSetAllocateInfo const allocateInfo{
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        nullptr,
+        app.descriptorPool,
+        static_cast<std::uint32_t>(std::size(layouts)), std::data(layouts)
+    };
+
+    if (auto result = vkAllocateDescriptorSets(device, &allocateInfo, std::data(descriptorSets)); result != VK_SUCCESS)
+        throw std::runtime_error("failed to allocate material descriptor sets: "s + std::to_string(result));
+
+    UpdateMaterialDescriptorSets(app, device, descriptorSets);
 }
 
 
@@ -341,6 +613,13 @@ void CreateGraphicsPipeline(app_t &app, VkDevice device)
 
     auto const vertShaderModule = CreateShaderModule(device, vertShaderByteCode);
 
+    auto const quantizedVertShaderByteCode = ReadShaderFile(R"(vert_quantized.spv)"sv);
+
+    if (quantizedVertShaderByteCode.empty())
+        throw std::runtime_error("failed to open quantized vertex shader file"s);
+
+    auto const quantizedVertShaderModule = CreateShaderModule(device, quantizedVertShaderByteCode);
+
     auto const fragShaderByteCode = ReadShaderFile(R"(frag.spv)"sv);
 
     if (fragShaderByteCode.empty())
@@ -366,27 +645,23 @@ void CreateGraphicsPipeline(app_t &app, VkDevice device)
         nullptr
     };
 
+    VkPipelineShaderStageCreateInfo const quantizedVertShaderCreateInfo{
+        VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+        nullptr, 0,
+        VK_SHADER_STAGE_VERTEX_BIT,
+        quantizedVertShaderModule,
+        "main",
+        nullptr
+    };
+
     auto const shaderStages = make_array(
         vertShaderCreateInfo, fragShaderCreateInfo
     );
 
-    auto constexpr vertexInputBindingDescriptions = make_array(
-        VkVertexInputBindingDescription{0, sizeof(Vertex), VK_VERTEX_INPUT_RATE_VERTEX}
+    auto const quantizedShaderStages = make_array(
+        quantizedVertShaderCreateInfo, fragShaderCreateInfo
     );
 
-    auto constexpr attributeDescriptions = make_array(
-        VkVertexInputAttributeDescription{0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, pos)},
-        VkVertexInputAttributeDescription{1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal)},
-        VkVertexInputAttributeDescription{2, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, uv)}
-    );
-
-    VkPipelineVertexInputStateCreateInfo const vertexInputCreateInfo{
-        VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-        nullptr, 0,
-        static_cast<std::uint32_t>(std::size(vertexInputBindingDescriptions)), std::data(vertexInputBindingDescriptions),
-        static_cast<std::uint32_t>(std::size(attributeDescriptions)), std::data(attributeDescriptions),
-    };
-
     VkPipelineInputAssemblyStateCreateInfo constexpr vertexAssemblyStateCreateInfo{
         VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
         nullptr, 0,
@@ -464,39 +739,97 @@ void CreateGraphicsPipeline(app_t &app, VkDevice device)
         { 0, 0, 0, 0 }
     };
 
+    auto const descriptorSetLayouts = make_array(app.descriptorSetLayout, app.materialDescriptorSetLayout);
+
     VkPipelineLayoutCreateInfo const layoutCreateInfo{
         VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
         nullptr, 0, 
-        1, &app.descriptorSetLayout,
+        static_cast<std::uint32_t>(std::size(descriptorSetLayouts)), std::data(descriptorSetLayouts),
         0, nullptr
     };
 
     if (auto result = vkCreatePipelineLayout(device, &layoutCreateInfo, nullptr, &app.pipelineLayout); result != VK_SUCCESS)
         throw std::runtime_error("failed to create pipeline layout: "s + std::to_string(result));
 
-    VkGraphicsPipelineCreateInfo const graphicsPipelineCreateInfo{
-        VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-        nullptr,
-        VK_PIPELINE_CREATE_DISABLE_OPTIMIZATION_BIT,
-        static_cast<std::uint32_t>(std::size(shaderStages)), std::data(shaderStages),
-        &vertexInputCreateInfo, &vertexAssemblyStateCreateInfo,
-        nullptr,
-        &viewportStateCreateInfo,
-        &rasterizer,
-        &multisampleCreateInfo,
-        &depthStencilStateCreateInfo,
-        &colorBlendStateCreateInfo,
-        nullptr,
-        app.pipelineLayout,
-        app.renderPass,
-        0,
-        VK_NULL_HANDLE, -1
-    };
+    auto constexpr normalMask = semantics_mask_v<semantic::normal>;
+    auto constexpr texCoordMask = semantics_mask_v<semantic::tex_coord_0>;
+
+    for (std::size_t streamIndex = 0; streamIndex < std::size(app.scene.vertexStreams); ++streamIndex) {
+        auto &&layout = app.scene.vertexStreams[streamIndex].layout;
+
+        auto const missingMask = (normalMask | texCoordMask) & ~layout.semanticsMask;
+
+        // The default normal and texture coordinates don't match the quantized shader inputs, quantized formats always have both.
+        if ((layout.semanticsMask & semantics_mask_v<semantic::position>) == 0 || (layout.quantized && missingMask != 0)) {
+            std::cerr << "vertex stream "s << streamIndex << " of format "s << layout.formatIndex << " isn't compatible with the vertex shader inputs\n"s;
+
+            app.graphicsPipelines.push_back(VK_NULL_HANDLE);
+            continue;
+        }
+
+        std::vector<VkVertexInputBindingDescription> vertexInputBindingDescriptions{
+            VkVertexInputBindingDescription{0, layout.stride, VK_VERTEX_INPUT_RATE_VERTEX}
+        };
+
+        auto attributeDescriptions = layout.attributeDescriptions;
+
+        // Missing normals and texture coordinates are read from the default attributes buffer, all vertices share its single element.
+        if (missingMask != 0) {
+            vertexInputBindingDescriptions.push_back(VkVertexInputBindingDescription{kDEFAULT_ATTRIBUTES_BINDING, 0, VK_VERTEX_INPUT_RATE_VERTEX});
+
+            if (missingMask & normalMask) {
+                attributeDescriptions.push_back(VkVertexInputAttributeDescription{
+                    semantic_location_v<semantic::normal>, kDEFAULT_ATTRIBUTES_BINDING,
+                    VK_FORMAT_R32G32B32_SFLOAT, static_cast<std::uint32_t>(offsetof(default_vertex_attributes_t, normal))
+                });
+            }
+
+            if (missingMask & texCoordMask) {
+                attributeDescriptions.push_back(VkVertexInputAttributeDescription{
+                    semantic_location_v<semantic::tex_coord_0>, kDEFAULT_ATTRIBUTES_BINDING,
+                    VK_FORMAT_R32G32_SFLOAT, static_cast<std::uint32_t>(offsetof(default_vertex_attributes_t, texCoord))
+                });
+            }
+        }
+
+        auto &&stages = layout.quantized ? quantizedShaderStages : shaderStages;
+
+        VkPipelineVertexInputStateCreateInfo const vertexInputCreateInfo{
+            VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+            nullptr, 0,
+            static_cast<std::uint32_t>(std::size(vertexInputBindingDescriptions)), std::data(vertexInputBindingDescriptions),
+            static_cast<std::uint32_t>(std::size(attributeDescriptions)), std::data(attributeDescriptions),
+        };
+
+        VkGraphicsPipelineCreateInfo const graphicsPipelineCreateInfo{
+            VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+            nullptr,
+            VK_PIPELINE_CREATE_DISABLE_OPTIMIZATION_BIT,
+            static_cast<std::uint32_t>(std::size(stages)), std::data(stages),
+            &vertexInputCreateInfo, &vertexAssemblyStateCreateInfo,
+            nullptr,
+            &viewportStateCreateInfo,
+            &rasterizer,
+            &multisampleCreateInfo,
+            &depthStencilStateCreateInfo,
+            &colorBlendStateCreateInfo,
+            nullptr,
+            app.pipelineLayout,
+            app.renderPass,
+            0,
+            VK_NULL_HANDLE, -1
+        };
+
+        VkPipeline graphicsPipeline;
 
-    if (auto result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &graphicsPipelineCreateInfo, nullptr, &app.graphicsPipeline); result != VK_SUCCESS)
-        throw std::runtime_error("failed to create graphics pipeline: "s + std::to_string(result));
+        if (auto result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &graphicsPipelineCreateInfo, nullptr, &graphicsPipeline); result != VK_SUCCESS)
+            throw std::runtime_error("failed to create graphics pipeline: "s + std::to_string(result));
+
+        app.graphicsPipelines.push_back(graphicsPipeline);
+    }
 
     vkDestroyShaderModule(device, fragShaderModule, nullptr);
+    vkDestroyShaderModule(device, quantizedVertShaderModule, nullptr);
     vkDestroyShaderModule(device, vertShaderModule, nullptr);
 }
 
@@ -547,11 +880,11 @@ void CreateCommandPool(VkDevice device, Q &queue, VkCommandPool &commandPool, Vk
 
 
 [[nodiscard]] std::shared_ptr<VulkanBuffer>
-InitVertexBuffer(app_t &app, VulkanDevice &device)
+InitVertexBuffer(app_t &app, VulkanDevice &device, vertex_stream_t const &vertexStream)
 {
     std::shared_ptr<VulkanBuffer> buffer;
 
-    if (auto stagingBuffer = StageData(device, app.vertices); stagingBuffer) {
+    if (auto stagingBuffer = StageData(device, vertexStream.buffer); stagingBuffer) {
         auto constexpr usageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
         auto constexpr propertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
@@ -569,13 +902,15 @@ InitVertexBuffer(app_t &app, VulkanDevice &device)
     return buffer;
 }
 
+// Uploads the data to a device local buffer of the given usage.
+template<class T>
 [[nodiscard]] std::shared_ptr<VulkanBuffer>
-InitIndexBuffer(app_t &app, VulkanDevice &device)
+InitDeviceBuffer(app_t &app, VulkanDevice &device, std::vector<T> const &data, VkBufferUsageFlags usage)
 {
     std::shared_ptr<VulkanBuffer> buffer;
 
-    if (auto stagingBuffer = StageData(device, app.indices); stagingBuffer) {
-        auto constexpr usageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+    if (auto stagingBuffer = StageData(device, data); stagingBuffer) {
+        auto const usageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage;
         auto constexpr propertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
         buffer = device.resourceManager().CreateBuffer(stagingBuffer->memory()->size(), usageFlags, propertyFlags);
@@ -592,6 +927,63 @@ InitIndexBuffer(app_t &app, VulkanDevice &device)
     return buffer;
 }
 
+// Device local buffer of the given usage to be filled later by transfers.
+[[nodiscard]] std::shared_ptr<VulkanBuffer>
+CreateDeviceBuffer(VulkanDevice &device, std::size_t size, VkBufferUsageFlags usage)
+{
+    auto const usageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage;
+    auto constexpr propertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+    return device.resourceManager().CreateBuffer(static_cast<VkDeviceSize>(size), usageFlags, propertyFlags);
+}
+
+
+// Indirect commands, per draw and per instance data of the scene draw commands. Instances are laid out
+// draw after draw, so the instance index fetches the index of its draw data and the node index of its world matrix.
+// The local bounds of the instanced primitives and the scene tree nodes of the instances follow the instance data order.
+[[nodiscard]] std::tuple<std::vector<VkDrawIndexedIndirectCommand>, std::vector<draw_data_t>, std::vector<instance_data_t>, std::vector<aabb_t>, std::vector<NodeHandle>>
+BuildDrawData(scene_data_t const &scene, std::vector<NodeHandle> const &nodeHandles)
+{
+    std::vector<VkDrawIndexedIndirectCommand> indirectCommands;
+    std::vector<draw_data_t> drawData;
+    std::vector<instance_data_t> instanceData;
+    std::vector<aabb_t> instanceBounds;
+    std::vector<NodeHandle> instanceNodes;
+
+    for (auto &&drawCommand : scene.drawCommands) {
+        auto &&primitive = scene.vertexStreams.at(drawCommand.streamIndex).primitives.at(drawCommand.primitiveIndex);
+
+        auto &&scale = primitive.positionScale;
+        auto &&offset = primitive.positionOffset;
+
+        auto const drawIndex = static_cast<std::uint32_t>(std::size(drawData));
+
+        indirectCommands.push_back(VkDrawIndexedIndirectCommand{
+            drawCommand.indexCount, drawCommand.instanceCount, drawCommand.firstIndex, drawCommand.vertexOffset,
+            static_cast<std::uint32_t>(std::size(instanceData))
+        });
+
+        drawData.push_back(draw_data_t{
+            {scale[0], scale[1], scale[2], 1.f},
+            {offset[0], offset[1], offset[2], 0.f},
+            {drawCommand.materialIndex < 0 ? static_cast<std::int32_t>(std::size(scene.materials)) : drawCommand.materialIndex, 0, 0, 0}
+        });
+
+        aabb_t bounds;
+        bounds.min = glm::vec3{primitive.boundsMin[0], primitive.boundsMin[1], primitive.boundsMin[2]};
+        bounds.max = glm::vec3{primitive.boundsMax[0], primitive.boundsMax[1], primitive.boundsMax[2]};
+
+        for (auto instance = drawCommand.firstInstance; instance < drawCommand.firstInstance + drawCommand.instanceCount; ++instance) {
+            auto const nodeHandle = nodeHandles.at(scene.instances.at(instance));
+
+            instanceData.push_back(instance_data_t{{drawIndex, NodeHandleIndex(nodeHandle), 0, 0}});
+            instanceBounds.push_back(bounds);
+            instanceNodes.push_back(nodeHandle);
+        }
+    }
+
+    return {std::move(indirectCommands), std::move(drawData), std::move(instanceData), std::move(instanceBounds), std::move(instanceNodes)};
+}
 
 [[nodiscard]] std::shared_ptr<VulkanBuffer>
 CreateUniformBuffer(VulkanDevice &device, std::size_t size)
@@ -655,24 +1047,76 @@ void CreateCommandBuffers(app_t &app, VulkanDevice const &device, VkRenderPass r
 
         vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, app.graphicsPipeline);
+        auto &&drawCommands = app.scene.drawCommands;
+
+        // There is no descriptor set until the streamed scene has been loaded.
+        if (app.descriptorSet != VK_NULL_HANDLE) {
+            auto const descriptorSets = make_array(app.descriptorSet);
+
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, app.pipelineLayout,
+                                    0, static_cast<std::uint32_t>(std::size(descriptorSets)), std::data(descriptorSets), 0, nullptr);
+        }
+
+        // The default material descriptor set follows the scene materials ones.
+        auto const defaultMaterial = static_cast<std::int32_t>(std::size(app.scene.materials));
+
+        std::optional<std::uint32_t> boundStream;
+        std::optional<std::int32_t> boundMaterial;
+
+        VkBuffer boundIndexBuffer = VK_NULL_HANDLE;
+
+        // Each run of draws sharing the vertex stream, the index type and the material is a single indirect draw call.
+        for (auto first = std::cbegin(drawCommands); first != std::cend(drawCommands);) {
+            auto const streamIndex = first->streamIndex;
+            auto const indexType = first->indexType;
+            auto const materialIndex = first->materialIndex;
+
+            auto const last = std::find_if(first, std::cend(drawCommands), [streamIndex, indexType, materialIndex] (auto &&drawCommand)
+            {
+                return drawCommand.streamIndex != streamIndex || drawCommand.indexType != indexType || drawCommand.materialIndex != materialIndex;
+            });
+
+            auto const firstDraw = static_cast<VkDeviceSize>(std::distance(std::cbegin(drawCommands), first));
+            auto const drawCount = static_cast<std::uint32_t>(std::distance(first, last));
+
+            first = last;
+
+            auto const graphicsPipeline = app.graphicsPipelines.at(streamIndex);
+
+            if (graphicsPipeline == VK_NULL_HANDLE)
+                continue;
+
+            if (boundStream != streamIndex) {
+                vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+
+                // The default attributes binding is ignored by the pipelines of the streams having all the shader inputs.
+                auto const vertexBuffers = make_array(app.vertexBuffers.at(streamIndex)->handle(), app.defaultAttributesBuffer->handle());
+                auto const offsets = make_array(VkDeviceSize{0}, VkDeviceSize{0});
+
+                vkCmdBindVertexBuffers(commandBuffer, 0, static_cast<std::uint32_t>(std::size(vertexBuffers)), std::data(vertexBuffers), std::data(offsets));
 
-        auto const descriptorSets = make_array(app.descriptorSet);
+                boundStream = streamIndex;
+            }
 
-        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, app.pipelineLayout,
-                                0, static_cast<std::uint32_t>(std::size(descriptorSets)), std::data(descriptorSets), 0, nullptr);
+            auto const indexBuffer = indexType == VK_INDEX_TYPE_UINT16 ? app.indexBuffer16->handle() : app.indexBuffer32->handle();
 
-        auto const vertexBuffers = make_array(app.vertexBuffer->handle());
-        auto const offsets = make_array(VkDeviceSize{0});
+            if (indexBuffer != boundIndexBuffer) {
+                vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, indexType);
+                boundIndexBuffer = indexBuffer;
+            }
 
-        vkCmdBindVertexBuffers(commandBuffer, 0, 1, std::data(vertexBuffers), std::data(offsets));
+            if (auto const material = materialIndex < 0 ? defaultMaterial : materialIndex; boundMaterial != material) {
+                auto const materialDescriptorSets = make_array(app.materialDescriptorSets.at(static_cast<std::size_t>(material)));
 
-        auto constexpr index_type = std::is_same_v<typename decltype(app.indices)::value_type, std::uint32_t> ?
-                                    VK_INDEX_TYPE_UINT32 : VK_INDEX_TYPE_UINT16;
+                vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, app.pipelineLayout,
+                                        1, static_cast<std::uint32_t>(std::size(materialDescriptorSets)), std::data(materialDescriptorSets), 0, nullptr);
 
-        vkCmdBindIndexBuffer(commandBuffer, app.indexBuffer->handle(), 0, index_type);
+                boundMaterial = material;
+            }
 
-        vkCmdDrawIndexed(commandBuffer, static_cast<std::uint32_t>(std::size(app.indices)), 1, 0, 0, 0);
+            vkCmdDrawIndexedIndirect(commandBuffer, app.indirectBuffer->handle(), firstDraw * sizeof(VkDrawIndexedIndirectCommand),
+                                     drawCount, sizeof(VkDrawIndexedIndirectCommand));
+        }
 
         vkCmdEndRenderPass(commandBuffer);
 
@@ -695,67 +1139,769 @@ void CreateSemaphores(app_t &app, VkDevice device)
         throw std::runtime_error("failed to create render semaphore: "s + std::to_string(result));
 }
 
-std::optional<VulkanTexture> LoadTexture(app_t &app, VulkanDevice &device, std::string_view name)
+void CreateFrameFence(app_t &app, VkDevice device)
 {
-    std::optional<VulkanTexture> texture;
+    VkFenceCreateInfo constexpr createInfo{
+        VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+        nullptr,
+        VK_FENCE_CREATE_SIGNALED_BIT
+    };
 
-    auto constexpr generateMipMaps = true;
+    if (auto result = vkCreateFence(device, &createInfo, nullptr, &app.frameFence); result != VK_SUCCESS)
+        throw std::runtime_error("failed to create frame fence: "s + std::to_string(result));
+}
 
-    if (auto rawImage = LoadTARGA(name); rawImage) {
-        auto stagingBuffer = std::visit([&device] (auto &&data)
-        {
-            return StageData(device, std::forward<decltype(data)>(data));
-        }, std::move(rawImage->data));
+// Begins recording the transfers of the frame.
+[[nodiscard]] upload_t BeginUpload(app_t &app)
+{
+    upload_t upload;
 
-        if (stagingBuffer) {
-            auto const width = static_cast<std::uint16_t>(rawImage->width);
-            auto const height = static_cast<std::uint16_t>(rawImage->height);
+    VkCommandBufferAllocateInfo const allocateInfo{
+        VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        nullptr,
+        app.graphicsCommandPool,
+        VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        1
+    };
 
-            auto constexpr usageFlags = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-            auto constexpr propertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    if (auto result = vkAllocateCommandBuffers(app.vulkanDevice->handle(), &allocateInfo, &upload.commandBuffer); result != VK_SUCCESS)
+        throw std::runtime_error("failed to allocate upload command buffer: "s + std::to_string(result));
 
-            auto constexpr tiling = VK_IMAGE_TILING_OPTIMAL;
+    VkCommandBufferBeginInfo const beginInfo{
+        VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        nullptr,
+        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        nullptr
+    };
 
-            texture = CreateTexture(device, rawImage->format, rawImage->type, width, height, rawImage->mipLevels,
-                                    VK_SAMPLE_COUNT_1_BIT, tiling, VK_IMAGE_ASPECT_COLOR_BIT, usageFlags, propertyFlags);
+    if (auto result = vkBeginCommandBuffer(upload.commandBuffer, &beginInfo); result != VK_SUCCESS)
+        throw std::runtime_error("failed to record upload command buffer: "s + std::to_string(result));
 
-            if (texture) {
-                TransitionImageLayout(device, app.transferQueue, *texture->image, VK_IMAGE_LAYOUT_UNDEFINED,
-                                      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, app.transferCommandPool);
+    return upload;
+}
 
-                CopyBufferToImage(device, app.transferQueue, stagingBuffer->handle(), texture->image->handle(), width, height, app.transferCommandPool);
+// Submits the upload to the graphics queue, it has to be submitted before the draws of the frame.
+void SubmitUpload(app_t &app, upload_t &&upload)
+{
+    auto &&device = app.vulkanDevice->handle();
 
-                if (generateMipMaps)
-                    GenerateMipMaps(device, app.transferQueue, *texture->image, app.transferCommandPool);
+    if (auto result = vkEndCommandBuffer(upload.commandBuffer); result != VK_SUCCESS)
+        throw std::runtime_error("failed to end upload command buffer: "s + std::to_string(result));
 
-                else TransitionImageLayout(device, app.transferQueue, *texture->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                           VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, app.transferCommandPool);
-            }
-        }
-    }
+    VkFenceCreateInfo constexpr fenceCreateInfo{
+        VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+        nullptr, 0
+    };
 
-    else std::cerr << "failed to load an image\n"s;
+    if (auto result = vkCreateFence(device, &fenceCreateInfo, nullptr, &upload.fence); result != VK_SUCCESS)
+        throw std::runtime_error("failed to create upload fence: "s + std::to_string(result));
 
-    return texture;
-}
+    VkSubmitInfo const submitInfo{
+        VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        nullptr,
+        0, nullptr,
+        nullptr,
+        1, &upload.commandBuffer,
+        0, nullptr,
+    };
 
+    if (auto result = vkQueueSubmit(app.graphicsQueue.handle(), 1, &submitInfo, upload.fence); result != VK_SUCCESS)
+        throw std::runtime_error("failed to submit upload command buffer: "s + std::to_string(result));
 
+    app.uploads.push_back(std::move(upload));
+}
 
-void RecreateSwapChain(app_t &app)
+// Releases the command buffers, the fences and the staging buffers of the uploads completed by the device,
+// their textures are handed over to the landed ones.
+void RetireUploads(app_t &app)
 {
-    if (app.width < 1 || app.height < 1) return;
+    auto &&device = app.vulkanDevice->handle();
 
-    vkDeviceWaitIdle(app.vulkanDevice->handle());
+    auto const it = std::remove_if(std::begin(app.uploads), std::end(app.uploads), [&app, device] (auto &&upload)
+    {
+        if (vkGetFenceStatus(device, upload.fence) != VK_SUCCESS)
+            return false;
 
-    CleanupFrameData(app, *app.vulkanDevice, app.graphicsPipeline, app.pipelineLayout, app.renderPass);
+        vkFreeCommandBuffers(device, app.graphicsCommandPool, 1, &upload.commandBuffer);
+        vkDestroyFence(device, upload.fence, nullptr);
 
-    auto swapchain = CreateSwapchain(*app.vulkanDevice, app.surface, app.width, app.height,
-                                     app.presentationQueue, app.graphicsQueue, app.transferQueue, app.transferCommandPool);
+        std::move(std::begin(upload.textures), std::end(upload.textures), std::back_inserter(app.landedTextures));
 
-    if (swapchain)
-        app.swapchain = std::move(swapchain.value());
+        return true;
+    });
 
-    else throw std::runtime_error("failed to create the swapchain"s);
+    app.uploads.erase(it, std::end(app.uploads));
+}
+
+// Records the image upload and the generation of its mip levels, the texture can be sampled once the upload has been completed.
+std::optional<VulkanTexture> UploadTexture(VulkanDevice &device, RawImage &&rawImage, upload_t &upload)
+{
+    std::optional<VulkanTexture> texture;
+
+    auto constexpr generateMipMaps = true;
+
+    auto stagingBuffer = std::visit([&device] (auto &&data)
+    {
+        return StageData(device, std::forward<decltype(data)>(data));
+    }, std::move(rawImage.data));
+
+    if (stagingBuffer) {
+        auto const width = static_cast<std::uint16_t>(rawImage.width);
+        auto const height = static_cast<std::uint16_t>(rawImage.height);
+
+        auto constexpr usageFlags = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        auto constexpr propertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+        auto constexpr tiling = VK_IMAGE_TILING_OPTIMAL;
+
+        texture = CreateTexture(device, rawImage.format, rawImage.type, width, height, rawImage.mipLevels,
+                                VK_SAMPLE_COUNT_1_BIT, tiling, VK_IMAGE_ASPECT_COLOR_BIT, usageFlags, propertyFlags);
+
+        if (texture) {
+            TransitionImageLayout(upload.commandBuffer, *texture->image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+            CopyBufferToImage(upload.commandBuffer, stagingBuffer->handle(), texture->image->handle(), width, height);
+
+            if (generateMipMaps)
+                GenerateMipMaps(upload.commandBuffer, *texture->image);
+
+            else TransitionImageLayout(upload.commandBuffer, *texture->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+            upload.stagingBuffers.push_back(std::move(stagingBuffer));
+        }
+    }
+
+    return texture;
+}
+
+// Decodes the scene images on a pool of worker threads, the decoded images are uploaded by the calling thread.
+// The upload is submitted ahead of the first frame, so the textures are used right away.
+void LoadSceneTextures(app_t &app, VulkanDevice &device)
+{
+    auto &&images = app.scene.images;
+
+    std::vector<std::optional<RawImage>> rawImages(std::size(images));
+
+    {
+        std::atomic<std::size_t> nextImage{0};
+
+        auto const workersNumber = std::min<std::size_t>(std::max(std::thread::hardware_concurrency(), 1u), std::size(images));
+
+        std::vector<std::thread> workers;
+
+        for (std::size_t i = 0; i < workersNumber; ++i) {
+            workers.emplace_back([&images, &rawImages, &nextImage]
+            {
+                for (auto index = nextImage++; index < std::size(images); index = nextImage++)
+                    rawImages[index] = LoadTARGA(images[index]);
+            });
+        }
+
+        for (auto &&worker : workers)
+            worker.join();
+    }
+
+    auto upload = BeginUpload(app);
+
+    for (std::size_t i = 0; i < std::size(images); ++i) {
+        std::optional<VulkanTexture> texture;
+
+        if (auto &&rawImage = rawImages[i]; rawImage)
+            texture = UploadTexture(device, std::move(*rawImage), upload);
+
+        if (!texture)
+            std::cerr << "failed to load an image: "s << images[i] << '\n';
+
+        app.textures.push_back(std::move(texture));
+    }
+
+    SubmitUpload(app, std::move(upload));
+}
+
+// A white texel used by the materials without textures and until the streamed textures are loaded.
+void CreateDefaultTexture(app_t &app, VulkanDevice &device)
+{
+    RawImage defaultImage;
+
+    defaultImage.format = VK_FORMAT_R8G8B8A8_UNORM;
+    defaultImage.type = VK_IMAGE_VIEW_TYPE_2D;
+    defaultImage.width = defaultImage.height = 1;
+    defaultImage.data = std::vector<vec<4, std::uint8_t>>{vec<4, std::uint8_t>{255, 255, 255, 255}};
+
+    auto upload = BeginUpload(app);
+
+    if (auto texture = UploadTexture(device, std::move(defaultImage), upload); !texture)
+        throw std::runtime_error("failed to create the default texture"s);
+
+    else app.defaultTexture = std::move(texture.value());
+
+    SubmitUpload(app, std::move(upload));
+}
+
+void CreateSceneSamplers(app_t &app, VulkanDevice &device)
+{
+    auto &&resourceManager = device.resourceManager();
+
+    for (auto &&sampler : app.scene.samplers) {
+        auto imageSampler = resourceManager.CreateImageSampler(sampler.minFilter, sampler.magFilter, sampler.mipmapMode,
+                                                               sampler.addressModeU, sampler.addressModeV, VK_LOD_CLAMP_NONE);
+
+        if (!imageSampler)
+            throw std::runtime_error("failed to create a texture sampler"s);
+
+        app.samplers.push_back(std::move(imageSampler));
+    }
+
+    if (auto imageSampler = resourceManager.CreateImageSampler(app.defaultTexture.image->mipLevels()); !imageSampler)
+        throw std::runtime_error("failed to create a texture sampler"s);
+
+    else app.samplers.push_back(std::move(imageSampler));
+}
+
+// Creates the device buffers and descriptor sets of the loaded scene. The streamed scene buffers
+// are left unfilled and its draws have no instances until their data is uploaded by StreamScene().
+void CreateSceneResources(app_t &app, VulkanDevice &device, bool streamed)
+{
+    if (std::empty(app.scene.drawCommands))
+        throw std::runtime_error("scene has nothing to draw"s);
+
+    for (auto &&vertexStream : app.scene.vertexStreams) {
+        auto buffer = streamed ? CreateDeviceBuffer(device, std::size(vertexStream.buffer), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)
+                               : InitVertexBuffer(app, device, vertexStream);
+
+        if (!buffer)
+            throw std::runtime_error("failed to init vertex buffer"s);
+
+        app.vertexBuffers.push_back(std::move(buffer));
+    }
+
+    if (!std::empty(app.scene.indices16)) {
+        app.indexBuffer16 = streamed ? CreateDeviceBuffer(device, std::size(app.scene.indices16) * sizeof(std::uint16_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT)
+                                     : InitDeviceBuffer(app, device, app.scene.indices16, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+
+        if (!app.indexBuffer16)
+            throw std::runtime_error("failed to init 16-bit index buffer"s);
+    }
+
+    if (!std::empty(app.scene.indices32)) {
+        app.indexBuffer32 = streamed ? CreateDeviceBuffer(device, std::size(app.scene.indices32) * sizeof(std::uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT)
+                                     : InitDeviceBuffer(app, device, app.scene.indices32, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+
+        if (!app.indexBuffer32)
+            throw std::runtime_error("failed to init 32-bit index buffer"s);
+    }
+
+    // The rendered scene tree is built at once from the flattened scene nodes, the nodes of all the glTF scenes share it.
+    {
+        std::vector<std::int32_t> parents;
+        std::vector<std::string> names;
+        std::vector<glm::mat4> localMatrices;
+
+        for (auto &&node : app.scene.nodes) {
+            parents.push_back(node.parent);
+            names.push_back(node.name);
+            localMatrices.push_back(node.posed ? glm::mat4{1.f} : node.localMatrix);
+        }
+
+        auto nodeHandles = app.sceneTree.BuildHierarchy(parents, names, localMatrices);
+
+        if (!nodeHandles)
+            throw std::runtime_error("failed to build the scene tree"s);
+
+        // The scene is turned by the root, so the rotation reaches the shaders through the world matrices.
+        auto rootMatrix = glm::rotate(glm::mat4{1.f}, glm::radians(90.f), glm::vec3{1, 0, 0});
+        rootMatrix = glm::rotate(rootMatrix, glm::radians(90.f), glm::vec3{0, 0, 1});
+
+        app.sceneTree.SetLocalMatrix(app.sceneTree.root(), rootMatrix);
+
+        for (std::size_t index = 0; index < std::size(app.scene.nodes); ++index) {
+            auto &&node = app.scene.nodes[index];
+            auto const handle = (*nodeHandles)[index];
+
+            // The local matrices of such nodes are composed by the tree update, so animations may write the poses directly.
+            if (node.posed)
+                app.sceneTree.SetLocalPose(handle, node_pose_t{node.translation, node.rotation, node.scale});
+
+            if (node.mesh >= 0)
+                app.sceneTree.AddComponent<Mesh>(handle, static_cast<std::uint32_t>(node.mesh));
+        }
+
+        // The first update computes the world matrices of all the nodes, they are uploaded as a whole by the first sync.
+        app.sceneTree.Update();
+
+        app.worldMatricesBuffer = std::make_unique<WorldMatricesBuffer>(device);
+
+        auto upload = BeginUpload(app);
+
+        if (!app.worldMatricesBuffer->Sync(app.sceneTree, { }, upload.commandBuffer, upload.stagingBuffers))
+            throw std::runtime_error("failed to init world matrices buffer"s);
+
+        SubmitUpload(app, std::move(upload));
+
+        auto [indirectCommands, drawData, instanceData, instanceBounds, instanceNodes] = BuildDrawData(app.scene, *nodeHandles);
+
+        std::vector<glm::mat4> instanceWorldMatrices;
+        instanceWorldMatrices.reserve(std::size(instanceNodes));
+
+        for (auto nodeHandle : instanceNodes)
+            instanceWorldMatrices.push_back(app.sceneTree.GetWorldMatrix(nodeHandle).value_or(glm::mat4{1.f}));
+
+        std::vector<aabb_t> worldBounds(std::size(instanceData));
+
+        std::transform(std::cbegin(instanceBounds), std::cend(instanceBounds), std::cbegin(instanceWorldMatrices), std::begin(worldBounds), [] (auto &&bounds, auto &&worldMatrix)
+        {
+            return TransformBounds(bounds, worldMatrix);
+        });
+
+        app.sceneHierarchy.Build(worldBounds);
+        app.instanceLocalBounds = std::move(instanceBounds);
+        app.instanceNodes = std::move(instanceNodes);
+
+        app.indirectCommands = indirectCommands;
+
+        app.drawLevels.assign(std::size(indirectCommands), 0);
+        app.drawErrorScales.assign(std::size(indirectCommands), 0.f);
+
+        for (std::size_t drawIndex = 0; drawIndex < std::size(indirectCommands); ++drawIndex) {
+            auto &&indirectCommand = indirectCommands[drawIndex];
+
+            for (auto instance = indirectCommand.firstInstance; instance < indirectCommand.firstInstance + indirectCommand.instanceCount; ++instance) {
+                auto &&worldMatrix = instanceWorldMatrices.at(instance);
+
+                for (auto column = 0; column < 3; ++column)
+                    app.drawErrorScales[drawIndex] = std::max(app.drawErrorScales[drawIndex], glm::length(glm::vec3{worldMatrix[column]}));
+            }
+        }
+
+        if (streamed) {
+            for (auto &&indirectCommand : indirectCommands)
+                indirectCommand.instanceCount = 0;
+
+            app.pendingDraws.resize(std::size(indirectCommands));
+            std::iota(std::begin(app.pendingDraws), std::end(app.pendingDraws), 0);
+        }
+
+        if (app.indirectBuffer = InitDeviceBuffer(app, device, indirectCommands, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT); !app.indirectBuffer)
+            throw std::runtime_error("failed to init indirect buffer"s);
+
+        if (app.drawDataBuffer = InitDeviceBuffer(app, device, drawData, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT); !app.drawDataBuffer)
+            throw std::runtime_error("failed to init draw data buffer"s);
+
+        if (app.instanceDataBuffer = InitDeviceBuffer(app, device, instanceData, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT); !app.instanceDataBuffer)
+            throw std::runtime_error("failed to init instance data buffer"s);
+    }
+
+    {
+        std::vector<material_data_t> materialData;
+
+        for (auto &&material : app.scene.materials)
+            materialData.push_back(material_data_t{material.baseColorFactor});
+
+        // The default material.
+        materialData.push_back(material_data_t{{1.f, 1.f, 1.f, 1.f}});
+
+        if (app.materialDataBuffer = InitDeviceBuffer(app, device, materialData, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT); !app.materialDataBuffer)
+            throw std::runtime_error("failed to init material data buffer"s);
+    }
+
+    if (streamed)
+        app.textures.resize(std::size(app.scene.images));
+
+    CreateSceneSamplers(app, device);
+
+    CreateDescriptorPool(device.handle(), app.descriptorPool, static_cast<std::uint32_t>(std::size(app.scene.materials) + 1));
+    CreateDescriptorSet(app, device.handle(), app.descriptorSet);
+    CreateMaterialDescriptorSets(app, device.handle(), app.materialDescriptorSets);
+}
+
+void RecreateCommandBuffers(app_t &app)
+{
+    vkFreeCommandBuffers(app.vulkanDevice->handle(), app.graphicsCommandPool, static_cast<std::uint32_t>(std::size(app.commandBuffers)), std::data(app.commandBuffers));
+    app.commandBuffers.clear();
+
+    CreateCommandBuffers(app, *app.vulkanDevice, app.renderPass, app.graphicsCommandPool, app.commandBuffers, app.swapchain.framebuffers);
+}
+
+// Vertices of the primitive run up to the next primitive of the stream, the primitives are placed in the order of their vertices.
+std::size_t GetPrimitiveVertexCount(vertex_stream_t const &stream, std::size_t primitiveIndex)
+{
+    auto const vertexOffset = static_cast<std::size_t>(stream.primitives.at(primitiveIndex).vertexOffset);
+
+    if (primitiveIndex + 1 < std::size(stream.primitives))
+        return static_cast<std::size_t>(stream.primitives[primitiveIndex + 1].vertexOffset) - vertexOffset;
+
+    return stream.count - vertexOffset;
+}
+
+// Updates the scene tree and uploads the world matrices of the changed nodes, the world bounds of their instances are refitted.
+void UpdateWorldMatrices(app_t &app)
+{
+    if (!app.worldMatricesBuffer)
+        return;
+
+    auto &&changedNodes = app.sceneTree.Update();
+
+    if (std::empty(changedNodes))
+        return;
+
+    auto const buffer = app.worldMatricesBuffer->buffer();
+
+    auto upload = BeginUpload(app);
+
+    if (!app.worldMatricesBuffer->Sync(app.sceneTree, changedNodes, upload.commandBuffer, upload.stagingBuffers))
+        throw std::runtime_error("failed to sync world matrices buffer"s);
+
+    SubmitUpload(app, std::move(upload));
+
+    // The descriptor set is bound to the command buffers recorded for the previous buffer.
+    if (buffer != app.worldMatricesBuffer->buffer()) {
+        vkQueueWaitIdle(app.graphicsQueue.handle());
+
+        UpdateWorldMatricesDescriptorSet(app, app.vulkanDevice->handle(), app.descriptorSet);
+
+        RecreateCommandBuffers(app);
+    }
+
+    std::vector<std::uint8_t> changed(app.sceneTree.nodesNumber(), 0);
+
+    for (auto handle : changedNodes)
+        changed[NodeHandleIndex(handle)] = 1;
+
+    for (std::size_t instance = 0; instance < std::size(app.instanceNodes); ++instance) {
+        auto const nodeHandle = app.instanceNodes[instance];
+
+        if (!changed[NodeHandleIndex(nodeHandle)])
+            continue;
+
+        if (auto worldMatrix = app.sceneTree.GetWorldMatrix(nodeHandle); worldMatrix)
+            app.sceneHierarchy.UpdatePrimitive(static_cast<std::uint32_t>(instance), TransformBounds(app.instanceLocalBounds.at(instance), *worldMatrix));
+    }
+
+    app.sceneHierarchy.Refit();
+}
+
+// Submits the staged copies to the indirect, index and vertex buffers read by the draws.
+void UploadDrawInputs(app_t &app, staged_copies_t const &copies)
+{
+    auto stagingBuffer = StageData(*app.vulkanDevice, copies.data);
+
+    if (!stagingBuffer)
+        throw std::runtime_error("failed to stage draw input data"s);
+
+    auto upload = BeginUpload(app);
+
+    auto constexpr drawStages = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+
+    // The frames submitted earlier may still read the buffers being written.
+    VkMemoryBarrier constexpr readBarrier{
+        VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        nullptr,
+        0, VK_ACCESS_TRANSFER_WRITE_BIT
+    };
+
+    vkCmdPipelineBarrier(upload.commandBuffer, drawStages, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &readBarrier, 0, nullptr, 0, nullptr);
+
+    for (auto &&[buffer, regions] : copies.regions)
+        vkCmdCopyBuffer(upload.commandBuffer, stagingBuffer->handle(), buffer, static_cast<std::uint32_t>(std::size(regions)), std::data(regions));
+
+    VkMemoryBarrier constexpr writeBarrier{
+        VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        nullptr,
+        VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT
+    };
+
+    vkCmdPipelineBarrier(upload.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, drawStages, 0, 1, &writeBarrier, 0, nullptr, 0, nullptr);
+
+    upload.stagingBuffers.push_back(std::move(stagingBuffer));
+
+    SubmitUpload(app, std::move(upload));
+}
+
+// Distances from the camera to the nearest instances of the draws in the world space.
+std::vector<float> ComputeDrawDistances(app_t const &app)
+{
+    auto const eye = glm::vec3{glm::inverse(app.transforms.view)[3]};
+
+    auto &&instanceBounds = app.sceneHierarchy.primitiveBounds();
+
+    std::vector<float> drawDistances(std::size(app.indirectCommands), std::numeric_limits<float>::max());
+
+    for (std::size_t drawIndex = 0; drawIndex < std::size(app.indirectCommands); ++drawIndex) {
+        auto &&indirectCommand = app.indirectCommands[drawIndex];
+
+        for (auto instance = indirectCommand.firstInstance; instance < indirectCommand.firstInstance + indirectCommand.instanceCount; ++instance)
+            drawDistances[drawIndex] = std::min(drawDistances[drawIndex], instanceBounds.at(instance).distance(eye));
+    }
+
+    return drawDistances;
+}
+
+// Picks the levels of detail of the draws, only the index ranges of the draws which level has changed are patched in the indirect buffer.
+void SelectLevelsOfDetail(app_t &app)
+{
+    auto &&scene = app.scene;
+
+    if (std::empty(app.drawLevels) || app.height == 0)
+        return;
+
+    auto const drawDistances = ComputeDrawDistances(app);
+
+    // The viewport height divided by '2 * tan(fovy / 2)'.
+    auto const projectionScale = app.transforms.proj[1][1] * static_cast<float>(app.height) * .5f;
+
+    staged_copies_t copies;
+
+    for (std::size_t drawIndex = 0; drawIndex < std::size(scene.drawCommands); ++drawIndex) {
+        auto &&drawCommand = scene.drawCommands[drawIndex];
+        auto &&primitive = scene.vertexStreams.at(drawCommand.streamIndex).primitives.at(drawCommand.primitiveIndex);
+
+        if (primitive.levelOfDetailCount < 2 || app.drawErrorScales[drawIndex] <= 0.f)
+            continue;
+
+        // The errors are scaled by the instance transforms, so the distance is scaled the other way round.
+        auto const distance = drawDistances[drawIndex] / app.drawErrorScales[drawIndex];
+
+        auto const level = SelectLevelOfDetail(&scene.levelsOfDetail.at(primitive.firstLevelOfDetail), primitive.levelOfDetailCount,
+                                               distance, projectionScale, app.levelOfDetailPixelError);
+
+        if (level == app.drawLevels[drawIndex])
+            continue;
+
+        app.drawLevels[drawIndex] = level;
+
+        auto &&levelOfDetail = scene.levelsOfDetail.at(primitive.firstLevelOfDetail + level);
+        auto &&indirectCommand = app.indirectCommands[drawIndex];
+
+        indirectCommand.firstIndex = levelOfDetail.firstIndex;
+        indirectCommand.indexCount = levelOfDetail.indexCount;
+
+        // The instance count is left as is, the draw may still wait for its buffers to be streamed.
+        auto const offset = drawIndex * sizeof(VkDrawIndexedIndirectCommand);
+
+        copies.Stage(app.indirectBuffer->handle(), &indirectCommand.indexCount, sizeof(indirectCommand.indexCount),
+                     offset + offsetof(VkDrawIndexedIndirectCommand, indexCount));
+
+        copies.Stage(app.indirectBuffer->handle(), &indirectCommand.firstIndex, sizeof(indirectCommand.firstIndex),
+                     offset + offsetof(VkDrawIndexedIndirectCommand, firstIndex));
+    }
+
+    if (!std::empty(copies.data))
+        UploadDrawInputs(app, copies);
+}
+
+// Uploads the nearest to the camera pending draws and the decoded textures within the per frame budget.
+// The draws become drawable as soon as their vertices and indices land, the textures replace the default one.
+void StreamScene(app_t &app)
+{
+    auto &&device = *app.vulkanDevice;
+
+    if (std::empty(app.vertexBuffers)) {
+        auto scene = app.sceneStreamer->TakeScene();
+
+        if (!scene) {
+            if (app.sceneStreamer->failed())
+                throw std::runtime_error("failed to load a mesh"s);
+
+            return;
+        }
+
+        app.scene = std::move(scene.value());
+
+        vkDeviceWaitIdle(device.handle());
+
+        // The pipelines are created per scene vertex stream layout.
+        for (auto graphicsPipeline : app.graphicsPipelines)
+            if (graphicsPipeline)
+                vkDestroyPipeline(device.handle(), graphicsPipeline, nullptr);
+
+        app.graphicsPipelines.clear();
+
+        vkDestroyPipelineLayout(device.handle(), app.pipelineLayout, nullptr);
+
+        CreateGraphicsPipeline(app, device.handle());
+
+        CreateSceneResources(app, device, true);
+
+        RecreateCommandBuffers(app);
+
+        auto const loadingTime = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - app.streamingStartTime);
+
+        std::cout << "scene loading time: "s << loadingTime.count() << " ms\n"s;
+
+        return;
+    }
+
+    auto &&scene = app.scene;
+
+    auto const drawDistances = ComputeDrawDistances(app);
+
+    std::vector<float> imageDistances(std::size(scene.images), std::numeric_limits<float>::max());
+
+    for (std::size_t drawIndex = 0; drawIndex < std::size(scene.drawCommands); ++drawIndex) {
+        auto const materialIndex = scene.drawCommands[drawIndex].materialIndex;
+
+        if (materialIndex < 0 || scene.materials.at(static_cast<std::size_t>(materialIndex)).baseColorTexture < 0)
+            continue;
+
+        auto &&texture = scene.textures.at(static_cast<std::size_t>(scene.materials[static_cast<std::size_t>(materialIndex)].baseColorTexture));
+
+        if (texture.image >= 0)
+            imageDistances.at(static_cast<std::size_t>(texture.image)) = std::min(imageDistances[static_cast<std::size_t>(texture.image)], drawDistances[drawIndex]);
+    }
+
+    if (app.sceneStreamer)
+        app.sceneStreamer->PrioritizeImages(imageDistances);
+
+    std::size_t uploadedBytes = 0;
+
+    if (!std::empty(app.pendingDraws)) {
+        std::sort(std::begin(app.pendingDraws), std::end(app.pendingDraws), [&drawDistances] (auto lhs, auto rhs)
+        {
+            return drawDistances[lhs] < drawDistances[rhs];
+        });
+
+        // All the ranges uploaded this frame share a single staging buffer.
+        staged_copies_t copies;
+
+        auto it_draw = std::begin(app.pendingDraws);
+
+        for (; it_draw != std::end(app.pendingDraws); ++it_draw) {
+            auto &&drawCommand = scene.drawCommands.at(*it_draw);
+            auto &&stream = scene.vertexStreams.at(drawCommand.streamIndex);
+            auto &&primitive = stream.primitives.at(drawCommand.primitiveIndex);
+
+            auto const stride = stream.layout.stride;
+
+            auto const vertexOffset = static_cast<std::size_t>(primitive.vertexOffset) * stride;
+            auto const vertexSize = GetPrimitiveVertexCount(stream, drawCommand.primitiveIndex) * stride;
+
+            // The levels of detail indices follow the primitive ones.
+            auto lastIndex = primitive.firstIndex + primitive.indexCount;
+
+            for (auto level = primitive.firstLevelOfDetail; level < primitive.firstLevelOfDetail + primitive.levelOfDetailCount; ++level)
+                lastIndex = std::max(lastIndex, scene.levelsOfDetail.at(level).firstIndex + scene.levelsOfDetail[level].indexCount);
+
+            auto const indexSize = primitive.indexType == VK_INDEX_TYPE_UINT16 ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+
+            auto const indexOffset = primitive.firstIndex * indexSize;
+            auto const indicesSize = (lastIndex - primitive.firstIndex) * indexSize;
+
+            if (uploadedBytes != 0 && uploadedBytes + vertexSize + indicesSize > app.streamingBudget)
+                break;
+
+            copies.Stage(app.vertexBuffers.at(drawCommand.streamIndex)->handle(), std::data(stream.buffer) + vertexOffset, vertexSize, vertexOffset);
+
+            if (primitive.indexType == VK_INDEX_TYPE_UINT16)
+                copies.Stage(app.indexBuffer16->handle(), reinterpret_cast<std::byte const *>(std::data(scene.indices16)) + indexOffset, indicesSize, indexOffset);
+
+            else copies.Stage(app.indexBuffer32->handle(), reinterpret_cast<std::byte const *>(std::data(scene.indices32)) + indexOffset, indicesSize, indexOffset);
+
+            uploadedBytes += vertexSize + indicesSize;
+        }
+
+        // The landed draws get their instances back, only their instance counts are patched in the indirect buffer.
+        for (auto it = std::begin(app.pendingDraws); it != it_draw; ++it) {
+            auto &&instanceCount = app.indirectCommands.at(*it).instanceCount;
+
+            auto const offset = *it * sizeof(VkDrawIndexedIndirectCommand) + offsetof(VkDrawIndexedIndirectCommand, instanceCount);
+
+            copies.Stage(app.indirectBuffer->handle(), &instanceCount, sizeof(instanceCount), offset);
+        }
+
+        app.pendingDraws.erase(std::begin(app.pendingDraws), it_draw);
+
+        UploadDrawInputs(app, copies);
+    }
+
+    if (app.sceneStreamer) {
+        for (auto &&[imageIndex, rawImage] : app.sceneStreamer->TakeDecodedImages()) {
+            if (rawImage)
+                app.pendingImages.emplace_back(imageIndex, std::move(*rawImage));
+
+            else std::cerr << "failed to load an image: "s << scene.images.at(imageIndex) << '\n';
+        }
+    }
+
+    if (!std::empty(app.pendingImages)) {
+        std::sort(std::begin(app.pendingImages), std::end(app.pendingImages), [&imageDistances] (auto &&lhs, auto &&rhs)
+        {
+            return imageDistances[lhs.first] < imageDistances[rhs.first];
+        });
+
+        std::optional<upload_t> upload;
+
+        auto it_image = std::begin(app.pendingImages);
+
+        for (; it_image != std::end(app.pendingImages); ++it_image) {
+            auto const imageSize = std::visit([] (auto &&data)
+            {
+                return std::size(data) * sizeof(typename std::decay_t<decltype(data)>::value_type);
+            }, it_image->second.data);
+
+            if (uploadedBytes != 0 && uploadedBytes + imageSize > app.streamingBudget)
+                break;
+
+            if (!upload)
+                upload = BeginUpload(app);
+
+            if (auto texture = UploadTexture(device, std::move(it_image->second), *upload); texture)
+                upload->textures.emplace_back(it_image->first, std::move(*texture));
+
+            else std::cerr << "failed to load an image: "s << scene.images.at(it_image->first) << '\n';
+
+            uploadedBytes += imageSize;
+        }
+
+        if (upload)
+            SubmitUpload(app, std::move(*upload));
+
+        app.pendingImages.erase(std::begin(app.pendingImages), it_image);
+    }
+
+    // The descriptor sets and the command buffers being replaced may be used by the frame in flight only,
+    // otherwise the landed textures wait for a later frame.
+    if (!std::empty(app.landedTextures) && vkGetFenceStatus(device.handle(), app.frameFence) == VK_SUCCESS) {
+        for (auto &&[imageIndex, texture] : app.landedTextures)
+            app.textures.at(imageIndex) = std::move(texture);
+
+        app.landedTextures.clear();
+
+        UpdateMaterialDescriptorSets(app, device.handle(), app.materialDescriptorSets);
+
+        RecreateCommandBuffers(app);
+    }
+
+    auto const texturesLanded = std::empty(app.landedTextures) && std::all_of(std::cbegin(app.uploads), std::cend(app.uploads), [] (auto &&upload)
+    {
+        return std::empty(upload.textures);
+    });
+
+    if (std::empty(app.pendingDraws) && std::empty(app.pendingImages) && texturesLanded && app.sceneStreamer && app.sceneStreamer->finished()) {
+        app.sceneStreamer.reset();
+
+        auto const streamingTime = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - app.streamingStartTime);
+
+        std::cout << "scene streaming time: "s << streamingTime.count() << " ms\n"s;
+    }
+}
+
+
+
+void RecreateSwapChain(app_t &app)
+{
+    if (app.width < 1 || app.height < 1) return;
+
+    vkDeviceWaitIdle(app.vulkanDevice->handle());
+
+    CleanupFrameData(app, *app.vulkanDevice, app.graphicsPipelines, app.pipelineLayout, app.renderPass);
+
+    auto swapchain = CreateSwapchain(*app.vulkanDevice, app.surface, app.width, app.height,
+                                     app.presentationQueue, app.graphicsQueue, app.transferQueue, app.transferCommandPool);
+
+    if (swapchain)
+        app.swapchain = std::move(swapchain.value());
+
+    else throw std::runtime_error("failed to create the swapchain"s);
 
     if (auto renderPass = CreateRenderPass(*app.vulkanDevice, app.swapchain); !renderPass)
         throw std::runtime_error("failed to create the render pass"s);
@@ -783,6 +1929,9 @@ void DrawFrame(VulkanDevice const &vulkanDevice, app_t &app)
 {
     vkQueueWaitIdle(app.presentationQueue.handle());
 
+    if (auto result = vkWaitForFences(vulkanDevice.handle(), 1, &app.frameFence, VK_TRUE, std::numeric_limits<std::uint64_t>::max()); result != VK_SUCCESS)
+        throw std::runtime_error("failed to wait for the frame fence: "s + std::to_string(result));
+
     std::uint32_t imageIndex;
 
     switch (auto result = vkAcquireNextImageKHR(vulkanDevice.handle(), app.swapchain.handle,
@@ -815,7 +1964,11 @@ void DrawFrame(VulkanDevice const &vulkanDevice, app_t &app)
         static_cast<std::uint32_t>(std::size(signalSemaphores)), std::data(signalSemaphores),
     };
 
-    if (auto result = vkQueueSubmit(app.graphicsQueue.handle(), 1, &submitInfo, VK_NULL_HANDLE); result != VK_SUCCESS)
+    // Reset right before the submission, so the fence remains signaled if the frame is skipped.
+    if (auto result = vkResetFences(vulkanDevice.handle(), 1, &app.frameFence); result != VK_SUCCESS)
+        throw std::runtime_error("failed to reset the frame fence: "s + std::to_string(result));
+
+    if (auto result = vkQueueSubmit(app.graphicsQueue.handle(), 1, &submitInfo, app.frameFence); result != VK_SUCCESS)
         throw std::runtime_error("failed to submit draw command buffer: "s + std::to_string(result));
 
     VkPresentInfoKHR const presentInfo{
@@ -882,70 +2035,121 @@ void InitVulkan(GLFWwindow *window, app_t &app)
     else throw std::runtime_error("failed to create the swapchain"s);
 
     CreateDescriptorSetLayout(app.vulkanDevice->handle(), app.descriptorSetLayout);
+    CreateMaterialDescriptorSetLayout(app.vulkanDevice->handle(), app.materialDescriptorSetLayout);
 
     if (auto renderPass = CreateRenderPass(*app.vulkanDevice, app.swapchain); !renderPass)
         throw std::runtime_error("failed to create the render pass"s);
 
     else app.renderPass = std::move(renderPass.value());
 
-    CreateGraphicsPipeline(app, app.vulkanDevice->handle());
+    glTF::import_options_t importOptions;
+    importOptions.optimizeOverdraw = true;
+    importOptions.quantizeVertices = true;
+    importOptions.buildMeshlets = true;
+    importOptions.levelOfDetailCount = 4;
+
+    if (app.uboBuffer = CreateUniformBuffer(*app.vulkanDevice, sizeof(transforms_t)); !app.uboBuffer)
+        throw std::runtime_error("failed to init uniform buffer"s);
 
     CreateFramebuffers(*app.vulkanDevice, app.renderPass, app.swapchain);
 
-    // "chalet/textures/chalet.tga"sv
-    // "Hebe/textures/HebehebemissinSG1_metallicRoughness.tga"sv
-    if (auto result = LoadTexture(app, *app.vulkanDevice, "sponza/textures/sponza_curtain_blue_diff.tga"sv); !result)
-        throw std::runtime_error("failed to load a texture"s);
+    CreateDefaultTexture(app, *app.vulkanDevice);
 
-    else app.texture = std::move(result.value());
+    if (app.defaultAttributesBuffer = InitDeviceBuffer(app, *app.vulkanDevice, std::vector<default_vertex_attributes_t>(1), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT); !app.defaultAttributesBuffer)
+        throw std::runtime_error("failed to init default vertex attributes buffer"s);
 
-    if (auto result = app.vulkanDevice->resourceManager().CreateImageSampler(app.texture.image->mipLevels()); !result)
-        throw std::runtime_error("failed to create a texture sampler"s);
+    CreateSemaphores(app, app.vulkanDevice->handle());
+    CreateFrameFence(app, app.vulkanDevice->handle());
 
-    else app.texture.sampler = result;
+    // The frames are presented right away, the scene content is filled in by StreamScene().
+    if (app.streamScene) {
+        app.streamingStartTime = std::chrono::high_resolution_clock::now();
+
+        app.sceneStreamer = std::make_unique<SceneStreamer>("sponza"sv, importOptions);
+
+        CreateGraphicsPipeline(app, app.vulkanDevice->handle());
+
+        CreateCommandBuffers(app, *app.vulkanDevice, app.renderPass, app.graphicsCommandPool, app.commandBuffers, app.swapchain.framebuffers);
+
+        return;
+    }
 
-    if (auto result = glTF::LoadScene("sponza"sv, app.vertices, app.indices); !result)
+    auto const loadingStartTime = std::chrono::high_resolution_clock::now();
+
+    if (auto result = glTF::LoadScene("sponza"sv, app.scene, importOptions); !result)
         throw std::runtime_error("failed to load a mesh"s);
 
-    if (app.vertexBuffer = InitVertexBuffer(app, *app.vulkanDevice); !app.vertexBuffer)
-        throw std::runtime_error("failed to init vertex buffer"s);
+    auto const loadingTime = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - loadingStartTime);
 
-    if (app.indexBuffer = InitIndexBuffer(app, *app.vulkanDevice); !app.indexBuffer)
-        throw std::runtime_error("failed to init index buffer"s);
+    std::cout << "scene loading time: "s << loadingTime.count() << " ms\n"s;
 
-    if (app.uboBuffer = CreateUniformBuffer(*app.vulkanDevice, sizeof(transforms_t)); !app.uboBuffer)
-        throw std::runtime_error("failed to init uniform buffer"s);
+    CreateGraphicsPipeline(app, app.vulkanDevice->handle());
 
-    CreateDescriptorPool(app.vulkanDevice->handle(), app.descriptorPool);
-    CreateDescriptorSet(app, app.vulkanDevice->handle(), app.descriptorSet);
+    auto const texturesLoadingStartTime = std::chrono::high_resolution_clock::now();
 
-    CreateCommandBuffers(app, *app.vulkanDevice, app.renderPass, app.graphicsCommandPool, app.commandBuffers, app.swapchain.framebuffers);
+    LoadSceneTextures(app, *app.vulkanDevice);
 
-    CreateSemaphores(app, app.vulkanDevice->handle());
+    auto const texturesLoadingTime = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - texturesLoadingStartTime);
+
+    std::cout << "textures loading time: "s << texturesLoadingTime.count() << " ms\n"s;
+
+    CreateSceneResources(app, *app.vulkanDevice, false);
+
+    CreateCommandBuffers(app, *app.vulkanDevice, app.renderPass, app.graphicsCommandPool, app.commandBuffers, app.swapchain.framebuffers);
 }
 
 void CleanUp(app_t &app)
 {
+    app.sceneStreamer.reset();
+
     vkDeviceWaitIdle(app.vulkanDevice->handle());
 
+    RetireUploads(app);
+
+    for (auto &&[imageIndex, texture] : app.landedTextures)
+        app.textures.at(imageIndex) = std::move(texture);
+
+    app.landedTextures.clear();
+
+    if (app.frameFence)
+        vkDestroyFence(app.vulkanDevice->handle(), app.frameFence, nullptr);
+
     if (app.renderFinishedSemaphore)
         vkDestroySemaphore(app.vulkanDevice->handle(), app.renderFinishedSemaphore, nullptr);
 
     if (app.imageAvailableSemaphore)
         vkDestroySemaphore(app.vulkanDevice->handle(), app.imageAvailableSemaphore, nullptr);
 
-    CleanupFrameData(app, *app.vulkanDevice, app.graphicsPipeline, app.pipelineLayout, app.renderPass);
+    CleanupFrameData(app, *app.vulkanDevice, app.graphicsPipelines, app.pipelineLayout, app.renderPass);
 
     vkDestroyDescriptorSetLayout(app.vulkanDevice->handle(), app.descriptorSetLayout, nullptr);
+    vkDestroyDescriptorSetLayout(app.vulkanDevice->handle(), app.materialDescriptorSetLayout, nullptr);
     vkDestroyDescriptorPool(app.vulkanDevice->handle(), app.descriptorPool, nullptr);
 
-    app.texture.sampler.reset();
-    vkDestroyImageView(app.vulkanDevice->handle(), app.texture.view.handle(), nullptr);
-    app.texture.image.reset();
+    app.samplers.clear();
+
+    for (auto &&texture : app.textures) {
+        if (texture) {
+            vkDestroyImageView(app.vulkanDevice->handle(), texture->view.handle(), nullptr);
+            texture->image.reset();
+        }
+    }
+
+    app.textures.clear();
+
+    vkDestroyImageView(app.vulkanDevice->handle(), app.defaultTexture.view.handle(), nullptr);
+    app.defaultTexture.image.reset();
 
     app.uboBuffer.reset();
-    app.indexBuffer.reset();
-    app.vertexBuffer.reset();
+    app.defaultAttributesBuffer.reset();
+    app.drawDataBuffer.reset();
+    app.instanceDataBuffer.reset();
+    app.worldMatricesBuffer.reset();
+    app.materialDataBuffer.reset();
+    app.indirectBuffer.reset();
+    app.indexBuffer16.reset();
+    app.indexBuffer32.reset();
+    app.vertexBuffers.clear();
 
     if (app.transferCommandPool)
         vkDestroyCommandPool(app.vulkanDevice->handle(), app.transferCommandPool, nullptr);
@@ -965,13 +2169,6 @@ void UpdateUniformBuffer(VulkanDevice const &device, app_t &app, VulkanBuffer co
     if (width * height < 1) return;
 
 #if !USE_GLM
-    app.transforms.model = mat4{
-        1, 0, 0, 0,
-        0, 1, 0, 0,
-        0, 0, 1, 0,
-        0, 0, 0, 1
-    };
-
     app.transforms.view = mat4(
         1, 0, 0, 0,
         0, 0.707106709, 0.707106709, 0,
@@ -988,23 +2185,12 @@ void UpdateUniformBuffer(VulkanDevice const &device, app_t &app, VulkanBuffer co
     auto currentTime = std::chrono::high_resolution_clock::now();
     [[maybe_unused]] auto time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
 
-    app.transforms.model = glm::mat4(1.f);
-    //app.transforms.model = glm::rotate(app.transforms.model, .24f * time * glm::radians(90.f), glm::vec3{0, 1, 0});
-    app.transforms.model = glm::rotate(app.transforms.model, glm::radians(90.f), glm::vec3{1, 0, 0});
-    app.transforms.model = glm::rotate(app.transforms.model, glm::radians(90.f), glm::vec3{0, 0, 1});
-    //app.transforms.model = glm::scale(app.transforms.model, glm::vec3{.1f, .1f, .1f});
-    //app.transforms.model = glm::translate(app.transforms.model, {0, 0, -250});
-    //app.transforms.model = glm::rotate(glm::mat4(1.f), .24f * time * glm::radians(90.f), glm::vec3{0, 1, 0});// *glm::scale(glm::mat4(1.f), {.0f, .0f, .0f});
-
     /*auto translate = glm::vec3{0.f, 4.f, 0.f + 0*std::sin(time) * 40.f};
 
     app.transforms.view = glm::mat4(1.f);
     app.transforms.view = glm::translate(app.transforms.view, translate);*/
     // app.transforms.view = glm::lookAt(glm::vec3{1.f, 2.f, 0.f}, glm::vec3{0, 1.f, 0}, glm::vec3{0, 1, 0});
     app.transforms.view = glm::lookAt(glm::vec3{10.f, 20.f, 0.f + std::sin(time * .4f) * 64.f}, glm::vec3{0, 10.f, 0}, glm::vec3{0, 1, 0});
-
-
-    app.transforms.modelView = app.transforms.view * app.transforms.model;
 #endif
     auto const aspect = static_cast<float>(width) / static_cast<float>(height);
 
@@ -1219,6 +2405,16 @@ try {
     while (!glfwWindowShouldClose(window) && glfwGetKey(window, GLFW_KEY_ESCAPE) != GLFW_PRESS) {
         glfwPollEvents();
         UpdateUniformBuffer(*app.vulkanDevice.get(), app, *app.uboBuffer, app.width, app.height);
+
+        RetireUploads(app);
+
+        if (app.sceneStreamer)
+            StreamScene(app);
+
+        UpdateWorldMatrices(app);
+
+        SelectLevelsOfDetail(app);
+
         DrawFrame(*app.vulkanDevice, app);
     }
 
@@ -18,6 +18,11 @@ struct vec {
     constexpr vec(Ts... values) noexcept : array{ static_cast<typename std::decay_t<decltype(array)>::value_type>(values)... } { }
 };
 
+// Storage of IEEE 754 half precision floating point number.
+struct float16_t {
+    std::uint16_t bits;
+};
+
 struct vec2 {
     std::array<float, 2> xy;
 
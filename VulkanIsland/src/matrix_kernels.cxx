@@ -0,0 +1,224 @@
+#include <cstddef>
+
+#if defined(__AVX__)
+#define USE_AVX_MATRIX_KERNEL
+#include <immintrin.h>
+
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define USE_SSE_MATRIX_KERNEL
+#include <xmmintrin.h>
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define USE_NEON_MATRIX_KERNEL
+#include <arm_neon.h>
+#endif
+
+#include "matrix_kernels.hxx"
+
+namespace {
+#if defined(USE_AVX_MATRIX_KERNEL)
+inline __m256 MultiplyAdd(__m256 a, __m256 b, __m256 c)
+{
+#ifdef __FMA__
+    return _mm256_fmadd_ps(a, b, c);
+#else
+    return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+
+// Each half of a vector holds one of the two consecutive columns of a right hand matrix,
+// so the left hand matrix columns are duplicated into both halves.
+void MultiplyMatricesAVX(float const *lhs, float const *rhs, float *result, std::size_t count)
+{
+    auto const column0 = _mm256_broadcast_ps(reinterpret_cast<__m128 const *>(lhs + 0));
+    auto const column1 = _mm256_broadcast_ps(reinterpret_cast<__m128 const *>(lhs + 4));
+    auto const column2 = _mm256_broadcast_ps(reinterpret_cast<__m128 const *>(lhs + 8));
+    auto const column3 = _mm256_broadcast_ps(reinterpret_cast<__m128 const *>(lhs + 12));
+
+    for (std::size_t i = 0; i < count * 2; ++i) {
+        auto const columns = _mm256_loadu_ps(rhs + i * 8);
+
+        auto vector = _mm256_mul_ps(column0, _mm256_shuffle_ps(columns, columns, _MM_SHUFFLE(0, 0, 0, 0)));
+        vector = MultiplyAdd(column1, _mm256_shuffle_ps(columns, columns, _MM_SHUFFLE(1, 1, 1, 1)), vector);
+        vector = MultiplyAdd(column2, _mm256_shuffle_ps(columns, columns, _MM_SHUFFLE(2, 2, 2, 2)), vector);
+        vector = MultiplyAdd(column3, _mm256_shuffle_ps(columns, columns, _MM_SHUFFLE(3, 3, 3, 3)), vector);
+
+        _mm256_storeu_ps(result + i * 8, vector);
+    }
+}
+
+#elif defined(USE_SSE_MATRIX_KERNEL)
+void MultiplyMatricesSSE(float const *lhs, float const *rhs, float *result, std::size_t count)
+{
+    auto const column0 = _mm_loadu_ps(lhs + 0);
+    auto const column1 = _mm_loadu_ps(lhs + 4);
+    auto const column2 = _mm_loadu_ps(lhs + 8);
+    auto const column3 = _mm_loadu_ps(lhs + 12);
+
+    for (std::size_t i = 0; i < count * 4; ++i) {
+        auto const column = _mm_loadu_ps(rhs + i * 4);
+
+        auto const xy = _mm_add_ps(_mm_mul_ps(column0, _mm_shuffle_ps(column, column, _MM_SHUFFLE(0, 0, 0, 0))),
+                                   _mm_mul_ps(column1, _mm_shuffle_ps(column, column, _MM_SHUFFLE(1, 1, 1, 1))));
+        auto const zw = _mm_add_ps(_mm_mul_ps(column2, _mm_shuffle_ps(column, column, _MM_SHUFFLE(2, 2, 2, 2))),
+                                   _mm_mul_ps(column3, _mm_shuffle_ps(column, column, _MM_SHUFFLE(3, 3, 3, 3))));
+
+        _mm_storeu_ps(result + i * 4, _mm_add_ps(xy, zw));
+    }
+}
+
+#elif defined(USE_NEON_MATRIX_KERNEL)
+void MultiplyMatricesNEON(float const *lhs, float const *rhs, float *result, std::size_t count)
+{
+    auto const column0 = vld1q_f32(lhs + 0);
+    auto const column1 = vld1q_f32(lhs + 4);
+    auto const column2 = vld1q_f32(lhs + 8);
+    auto const column3 = vld1q_f32(lhs + 12);
+
+    for (std::size_t i = 0; i < count * 4; ++i) {
+        auto const column = vld1q_f32(rhs + i * 4);
+
+        auto vector = vmulq_laneq_f32(column0, column, 0);
+        vector = vfmaq_laneq_f32(vector, column1, column, 1);
+        vector = vfmaq_laneq_f32(vector, column2, column, 2);
+        vector = vfmaq_laneq_f32(vector, column3, column, 3);
+
+        vst1q_f32(result + i * 4, vector);
+    }
+}
+#endif
+
+void ComposeMatrix(node_pose_t const &pose, glm::mat4 &result) noexcept
+{
+    auto &&[translation, rotation, scale] = pose;
+
+    auto const x2 = rotation.x + rotation.x, y2 = rotation.y + rotation.y, z2 = rotation.z + rotation.z;
+
+    auto const xx = rotation.x * x2, yy = rotation.y * y2, zz = rotation.z * z2;
+    auto const xy = rotation.x * y2, xz = rotation.x * z2, yz = rotation.y * z2;
+    auto const wx = rotation.w * x2, wy = rotation.w * y2, wz = rotation.w * z2;
+
+    result[0] = glm::vec4{(1.f - (yy + zz)) * scale.x, (xy + wz) * scale.x, (xz - wy) * scale.x, 0.f};
+    result[1] = glm::vec4{(xy - wz) * scale.y, (1.f - (xx + zz)) * scale.y, (yz + wx) * scale.y, 0.f};
+    result[2] = glm::vec4{(xz + wy) * scale.z, (yz - wx) * scale.z, (1.f - (xx + yy)) * scale.z, 0.f};
+    result[3] = glm::vec4{translation.x, translation.y, translation.z, 1.f};
+}
+
+#if defined(USE_AVX_MATRIX_KERNEL) || defined(USE_SSE_MATRIX_KERNEL)
+static_assert(sizeof(node_pose_t) == sizeof(float) * 10 && offsetof(node_pose_t, rotation) == sizeof(float) * 3 &&
+              offsetof(node_pose_t, scale) == sizeof(float) * 7, "poses are expected to be tightly packed");
+
+static_assert(offsetof(glm::quat, x) == 0 && offsetof(glm::quat, w) == sizeof(float) * 3, "quaternions are expected to be stored as xyzw");
+
+// Four poses are transposed into vectors of their components, so each lane computes the elements of one of the four matrices.
+// The columns are transposed back to be stored.
+std::size_t ComposeMatricesSSE(float const *poses, float *result, std::size_t count)
+{
+    auto constexpr kPOSE_SIZE = sizeof(node_pose_t) / sizeof(float);
+
+    auto const one = _mm_set1_ps(1.f);
+    auto const zero = _mm_setzero_ps();
+
+    std::size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        auto const pose = poses + i * kPOSE_SIZE;
+
+        auto tx = _mm_loadu_ps(pose + kPOSE_SIZE * 0);
+        auto ty = _mm_loadu_ps(pose + kPOSE_SIZE * 1);
+        auto tz = _mm_loadu_ps(pose + kPOSE_SIZE * 2);
+        auto qx = _mm_loadu_ps(pose + kPOSE_SIZE * 3);
+
+        _MM_TRANSPOSE4_PS(tx, ty, tz, qx);
+
+        auto qy = _mm_loadu_ps(pose + kPOSE_SIZE * 0 + 4);
+        auto qz = _mm_loadu_ps(pose + kPOSE_SIZE * 1 + 4);
+        auto qw = _mm_loadu_ps(pose + kPOSE_SIZE * 2 + 4);
+        auto sx = _mm_loadu_ps(pose + kPOSE_SIZE * 3 + 4);
+
+        _MM_TRANSPOSE4_PS(qy, qz, qw, sx);
+
+        // The last four floats of the poses, the first two of them have been read already.
+        auto unused0 = _mm_loadu_ps(pose + kPOSE_SIZE * 0 + 6);
+        auto unused1 = _mm_loadu_ps(pose + kPOSE_SIZE * 1 + 6);
+        auto sy = _mm_loadu_ps(pose + kPOSE_SIZE * 2 + 6);
+        auto sz = _mm_loadu_ps(pose + kPOSE_SIZE * 3 + 6);
+
+        _MM_TRANSPOSE4_PS(unused0, unused1, sy, sz);
+
+        auto const x2 = _mm_add_ps(qx, qx), y2 = _mm_add_ps(qy, qy), z2 = _mm_add_ps(qz, qz);
+
+        auto const xx = _mm_mul_ps(qx, x2), yy = _mm_mul_ps(qy, y2), zz = _mm_mul_ps(qz, z2);
+        auto const xy = _mm_mul_ps(qx, y2), xz = _mm_mul_ps(qx, z2), yz = _mm_mul_ps(qy, z2);
+        auto const wx = _mm_mul_ps(qw, x2), wy = _mm_mul_ps(qw, y2), wz = _mm_mul_ps(qw, z2);
+
+        __m128 columns[4][4]{
+            {
+                _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx),
+                _mm_mul_ps(_mm_add_ps(xy, wz), sx),
+                _mm_mul_ps(_mm_sub_ps(xz, wy), sx),
+                zero
+            },
+            {
+                _mm_mul_ps(_mm_sub_ps(xy, wz), sy),
+                _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy),
+                _mm_mul_ps(_mm_add_ps(yz, wx), sy),
+                zero
+            },
+            {
+                _mm_mul_ps(_mm_add_ps(xz, wy), sz),
+                _mm_mul_ps(_mm_sub_ps(yz, wx), sz),
+                _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz),
+                zero
+            },
+            {tx, ty, tz, one}
+        };
+
+        auto const matrices = result + i * 16;
+
+        for (std::size_t column = 0; column < 4; ++column) {
+            auto &&vectors = columns[column];
+
+            _MM_TRANSPOSE4_PS(vectors[0], vectors[1], vectors[2], vectors[3]);
+
+            for (std::size_t matrix = 0; matrix < 4; ++matrix)
+                _mm_storeu_ps(matrices + matrix * 16 + column * 4, vectors[matrix]);
+        }
+    }
+
+    return i;
+}
+#endif
+}
+
+void MultiplyMatrices(glm::mat4 const &lhs, glm::mat4 const *rhs, glm::mat4 *result, std::size_t count) noexcept
+{
+    if (count == 0)
+        return;
+
+#if defined(USE_AVX_MATRIX_KERNEL)
+    MultiplyMatricesAVX(glm::value_ptr(lhs), glm::value_ptr(*rhs), glm::value_ptr(*result), count);
+#elif defined(USE_SSE_MATRIX_KERNEL)
+    MultiplyMatricesSSE(glm::value_ptr(lhs), glm::value_ptr(*rhs), glm::value_ptr(*result), count);
+#elif defined(USE_NEON_MATRIX_KERNEL)
+    MultiplyMatricesNEON(glm::value_ptr(lhs), glm::value_ptr(*rhs), glm::value_ptr(*result), count);
+#else
+    for (std::size_t i = 0; i < count; ++i)
+        result[i] = lhs * rhs[i];
+#endif
+}
+
+void ComposeMatrices(node_pose_t const *poses, glm::mat4 *result, std::size_t count) noexcept
+{
+    if (count == 0)
+        return;
+
+    std::size_t composed = 0;
+
+#if defined(USE_AVX_MATRIX_KERNEL) || defined(USE_SSE_MATRIX_KERNEL)
+    composed = ComposeMatricesSSE(reinterpret_cast<float const *>(poses), glm::value_ptr(*result), count);
+#endif
+
+    for (auto i = composed; i < count; ++i)
+        ComposeMatrix(poses[i], result[i]);
+}
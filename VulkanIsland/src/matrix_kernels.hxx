@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+
+#include "main.hxx"
+#include "math.hxx"
+#include "transform.hxx"
+
+
+// result[i] = lhs * rhs[i] for 'count' matrices, e.g. world matrices of the siblings sharing the parent 'lhs'.
+// The columns of 'lhs' stay in registers for the whole batch. AVX builds compute a pair of the result columns per instruction,
+// AArch64 builds use NEON. 'result' must not overlap 'rhs'.
+void MultiplyMatrices(glm::mat4 const &lhs, glm::mat4 const *rhs, glm::mat4 *result, std::size_t count) noexcept;
+
+// result[i] = translate(poses[i].translation) * mat4_cast(poses[i].rotation) * scale(poses[i].scale) for 'count' poses.
+// x86 builds compose four matrices at once, the rotations aren't normalized.
+void ComposeMatrices(node_pose_t const *poses, glm::mat4 *result, std::size_t count) noexcept;
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <iomanip>
+#include <bitset>
+#include <cstring>
 
 #include "entityx/entityx.hh"
 namespace ex = entityx;
@@ -26,6 +28,8 @@ enum class eSEMANTIC_INDEX : std::size_t {
 
 template<eSEMANTIC_INDEX SI>
 struct attribute {
+    static auto constexpr index = SI;
+
     template<eSEMANTIC_INDEX si>
     auto constexpr operator< (attribute<si>) const noexcept
     {
@@ -80,6 +84,17 @@ using vertex_format_t = std::variant<
     std::pair<
         std::tuple<semantic::position, semantic::normal, semantic::tex_coord_0, semantic::tangent>,
         std::tuple<vec<3, std::float_t>, vec<3, std::float_t>, vec<2, std::float_t>, vec<4, std::float_t>>
+    >,
+
+    // Quantized formats: positions are normalized to the primitive bounds, normals and tangents
+    // are octahedral encoded (tangent handedness is stored in the last component) and texture coordinates are half floats.
+    std::pair<
+        std::tuple<semantic::position, semantic::normal, semantic::tex_coord_0>,
+        std::tuple<vec<4, std::int16_t>, vec<2, std::int16_t>, vec<2, float16_t>>
+    >,
+    std::pair<
+        std::tuple<semantic::position, semantic::normal, semantic::tex_coord_0, semantic::tangent>,
+        std::tuple<vec<4, std::int16_t>, vec<2, std::int16_t>, vec<2, float16_t>, vec<4, std::int8_t>>
     >
 >;
 
@@ -111,6 +126,297 @@ struct is_vertex_format<T, std::variant<Ts...>> {
 template<class T>
 constexpr bool is_vertex_format_v = is_vertex_format<T, vertex_format_t>::value;
 
+
+// Shader input location of a vertex attribute is its semantic index.
+template<class S>
+auto constexpr semantic_location_v = static_cast<std::uint32_t>(S::index);
+
+template<class... Ss>
+auto constexpr semantics_mask_v = ((1u << semantic_location_v<Ss>) | ... | 0u);
+
+// Signed integer components are treated as normalized ones.
+template<class T>
+VkFormat constexpr get_vertex_attribute_format()
+{
+    using type = typename T::value_type;
+
+    auto constexpr N = T::size;
+
+    if constexpr (std::is_same_v<type, std::float_t>) {
+        switch (N) {
+            case 1: return VK_FORMAT_R32_SFLOAT;
+            case 2: return VK_FORMAT_R32G32_SFLOAT;
+            case 3: return VK_FORMAT_R32G32B32_SFLOAT;
+            case 4: return VK_FORMAT_R32G32B32A32_SFLOAT;
+        }
+    }
+
+    else if constexpr (std::is_same_v<type, float16_t>) {
+        switch (N) {
+            case 1: return VK_FORMAT_R16_SFLOAT;
+            case 2: return VK_FORMAT_R16G16_SFLOAT;
+            case 3: return VK_FORMAT_R16G16B16_SFLOAT;
+            case 4: return VK_FORMAT_R16G16B16A16_SFLOAT;
+        }
+    }
+
+    else if constexpr (std::is_same_v<type, std::int16_t>) {
+        switch (N) {
+            case 1: return VK_FORMAT_R16_SNORM;
+            case 2: return VK_FORMAT_R16G16_SNORM;
+            case 3: return VK_FORMAT_R16G16B16_SNORM;
+            case 4: return VK_FORMAT_R16G16B16A16_SNORM;
+        }
+    }
+
+    else if constexpr (std::is_same_v<type, std::int8_t>) {
+        switch (N) {
+            case 1: return VK_FORMAT_R8_SNORM;
+            case 2: return VK_FORMAT_R8G8_SNORM;
+            case 3: return VK_FORMAT_R8G8B8_SNORM;
+            case 4: return VK_FORMAT_R8G8B8A8_SNORM;
+        }
+    }
+
+    return VK_FORMAT_UNDEFINED;
+}
+
+template<class VF>
+struct vertex_format_traits;
+
+template<class... Ss, class... Ts>
+struct vertex_format_traits<std::pair<std::tuple<Ss...>, std::tuple<Ts...>>> {
+    static auto constexpr attributes_number = sizeof...(Ts);
+
+    static auto constexpr mask = semantics_mask_v<Ss...>;
+
+    static auto constexpr quantized = !(std::is_same_v<typename Ts::value_type, std::float_t> && ...);
+
+    // Attribute offsets are aligned to the component size, the stride is padded to four bytes.
+    static auto constexpr offsets = [] ()
+    {
+        std::array<std::uint32_t, attributes_number> offsets{ };
+
+        auto constexpr sizes = make_array(static_cast<std::uint32_t>(sizeof(Ts))...);
+        auto constexpr alignments = make_array(static_cast<std::uint32_t>(alignof(typename Ts::value_type))...);
+
+        for (std::uint32_t i = 0, offset = 0; i < attributes_number; ++i) {
+            offset = (offset + alignments[i] - 1) / alignments[i] * alignments[i];
+
+            offsets[i] = offset;
+            offset += sizes[i];
+        }
+
+        return offsets;
+    } ();
+
+    static auto constexpr stride = (offsets.back() + static_cast<std::uint32_t>(sizeof(std::tuple_element_t<attributes_number - 1, std::tuple<Ts...>>)) + 3u) / 4u * 4u;
+
+    static auto attribute_descriptions(std::uint32_t binding)
+    {
+        return attribute_descriptions(binding, std::make_index_sequence<attributes_number>{});
+    }
+
+    template<std::size_t... I>
+    static auto attribute_descriptions(std::uint32_t binding, std::index_sequence<I...>)
+    {
+        return make_array(VkVertexInputAttributeDescription{
+            semantic_location_v<Ss>, binding, get_vertex_attribute_format<Ts>(), offsets[I]
+        }...);
+    }
+
+    // Interleaves per attribute arrays into the tightly packed 'dst' vertex stream.
+    template<class... Vs>
+    static void interleave(std::byte *dst, std::size_t count, Vs const *...src)
+    {
+        static_assert(sizeof...(Vs) == attributes_number, "attribute arrays number doesn't match vertex format");
+
+        interleave(dst, count, std::make_index_sequence<attributes_number>{}, src...);
+    }
+
+    template<std::size_t... I, class... Vs>
+    static void interleave(std::byte *dst, std::size_t count, std::index_sequence<I...>, Vs const *...src)
+    {
+        for (std::size_t i = 0; i < count; ++i, dst += stride)
+            (std::memcpy(dst + offsets[I], src + i, sizeof(Vs)), ...);
+    }
+};
+
+template<std::size_t I = 0>
+std::optional<vertex_format_t> instantiate_vertex_format(std::size_t index)
+{
+    if constexpr (I < std::variant_size_v<vertex_format_t>) {
+        if (index == I)
+            return vertex_format_t{std::in_place_index<I>};
+
+        return instantiate_vertex_format<I + 1>(index);
+    }
+
+    else return { };
+}
+
+template<class V>
+struct vertex_formats_masks;
+
+template<class... Ts>
+struct vertex_formats_masks<std::variant<Ts...>> {
+    static auto constexpr value = make_array(vertex_format_traits<Ts>::mask...);
+    static auto constexpr quantized = make_array(vertex_format_traits<Ts>::quantized...);
+};
+
+// Picks the non-quantized vertex format that consumes the largest subset of available semantics.
+inline std::optional<std::size_t> get_vertex_format_index(std::uint32_t semanticsMask)
+{
+    std::optional<std::size_t> index;
+    std::size_t attributesNumber = 0;
+
+    auto constexpr masks = vertex_formats_masks<vertex_format_t>::value;
+    auto constexpr quantized = vertex_formats_masks<vertex_format_t>::quantized;
+
+    for (std::size_t i = 0; i < std::size(masks); ++i) {
+        auto const mask = masks[i];
+
+        if ((mask & semanticsMask) != mask || quantized[i])
+            continue;
+
+        if (auto const number = std::bitset<32>{mask}.count(); number > attributesNumber) {
+            attributesNumber = number;
+            index = i;
+        }
+    }
+
+    return index;
+}
+
+// Returns the quantized vertex format having the same semantics as the 'formatIndex' one.
+inline std::optional<std::size_t> get_quantized_vertex_format_index(std::size_t formatIndex)
+{
+    auto constexpr masks = vertex_formats_masks<vertex_format_t>::value;
+    auto constexpr quantized = vertex_formats_masks<vertex_format_t>::quantized;
+
+    for (std::size_t i = 0; i < std::size(masks); ++i)
+        if (quantized[i] && masks[i] == masks.at(formatIndex))
+            return i;
+
+    return { };
+}
+
+struct vertex_layout_t {
+    std::size_t formatIndex{0};
+    std::uint32_t semanticsMask{0};
+    std::uint32_t stride{0};
+
+    bool quantized{false};
+
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+};
+
+template<class VF>
+vertex_layout_t make_vertex_layout(std::uint32_t binding = 0)
+{
+    using traits = vertex_format_traits<VF>;
+
+    auto const descriptions = traits::attribute_descriptions(binding);
+
+    return {
+        variant_index_v<VF, vertex_format_t>,
+        traits::mask,
+        traits::stride,
+        traits::quantized,
+        { std::cbegin(descriptions), std::cend(descriptions) }
+    };
+}
+
+inline vertex_layout_t make_vertex_layout(vertex_format_t const &format, std::uint32_t binding = 0)
+{
+    return std::visit([binding] (auto &&format)
+    {
+        return make_vertex_layout<std::decay_t<decltype(format)>>(binding);
+
+    }, format);
+}
+
+// Index range of a primitive's simplified level of detail, levels share the primitive vertices.
+// 'error' is the geometric deviation from the original primitive in object space units.
+struct level_of_detail_t {
+    std::uint32_t firstIndex{0}, indexCount{0};
+    float error{0.f};
+};
+
+// Picks the coarsest level which geometric error projects to at most 'pixelThreshold' pixels at 'distance'.
+// 'projectionScale' is the viewport height divided by '2 * tan(fovy / 2)'. Levels are ordered by increasing error.
+inline std::size_t
+SelectLevelOfDetail(level_of_detail_t const *levels, std::size_t levelCount, float distance, float projectionScale, float pixelThreshold) noexcept
+{
+    std::size_t level = 0;
+
+    for (std::size_t i = 1; i < levelCount; ++i)
+        if (levels[i].error * projectionScale <= pixelThreshold * distance)
+            level = i;
+
+    return level;
+}
+
+// Draw range of a single primitive. Indices are relative to the first primitive vertex,
+// 'firstIndex' points into the index buffer of the 'indexType' type.
+struct primitive_range_t {
+    VkIndexType indexType{VK_INDEX_TYPE_UINT32};
+
+    std::uint32_t firstIndex{0}, indexCount{0};
+    std::int32_t vertexOffset{0};
+
+    // Quantized positions are restored as 'position * positionScale + positionOffset'.
+    std::array<float, 3> positionScale{1.f, 1.f, 1.f};
+    std::array<float, 3> positionOffset{0.f, 0.f, 0.f};
+
+    // Local space bounds of the primitive vertices, not affected by the quantization.
+    std::array<float, 3> boundsMin{0.f, 0.f, 0.f};
+    std::array<float, 3> boundsMax{0.f, 0.f, 0.f};
+
+    // Range of the primitive meshlets, the meshlets index ranges share the primitive index buffer.
+    std::uint32_t firstMeshlet{0}, meshletCount{0};
+
+    // Range of the primitive levels of detail, the first level is the primitive itself.
+    // Index ranges of the levels follow each other in the index buffer.
+    std::uint32_t firstLevelOfDetail{0}, levelOfDetailCount{0};
+};
+
+// Vertices of all primitives sharing the same vertex format along with their draw ranges.
+struct vertex_stream_t {
+    vertex_layout_t layout;
+
+    std::vector<std::byte> buffer;
+    std::size_t count{0};
+
+    std::vector<primitive_range_t> primitives;
+};
+
+// Instanced primitive draw: the primitive range is drawn once per each mesh instance of the range
+// [firstInstance, firstInstance + instanceCount) of the scene instances, the primitives of the same mesh share the range.
+// Draws are sorted by the vertex stream, the index type and the material, so each run of them is a single indirect draw call.
+struct draw_command_t {
+    std::uint32_t streamIndex{0}, primitiveIndex{0};
+
+    VkIndexType indexType{VK_INDEX_TYPE_UINT32};
+
+    std::uint32_t firstIndex{0}, indexCount{0};
+    std::int32_t vertexOffset{0};
+
+    // Index of the primitive material or -1 if the default one is used.
+    std::int32_t materialIndex{-1};
+
+    std::uint32_t firstInstance{0}, instanceCount{0};
+};
+
+// Scene tree node component referencing the mesh instantiated by the node.
+struct Mesh final {
+    std::uint32_t index{0};
+
+    Mesh() = default;
+
+    explicit Mesh(std::uint32_t index) : index{index} { }
+};
+
 /*struct Mesh final {
     glm::mat4 localMatrix;
     glm::mat4 worldMatrix;
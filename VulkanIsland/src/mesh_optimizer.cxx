@@ -0,0 +1,776 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <string_view>
+#include <unordered_map>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define USE_SSE_BOUNDS_SCAN
+#include <xmmintrin.h>
+#endif
+
+#include "mesh_optimizer.hxx"
+
+namespace {
+auto constexpr kINVALID_VERTEX = std::numeric_limits<std::uint32_t>::max();
+auto constexpr kINVALID_TRIANGLE = std::numeric_limits<std::size_t>::max();
+
+using position_t = std::array<float, 3>;
+
+position_t GetPosition(std::byte const *positions, std::size_t stride, std::uint32_t index)
+{
+    position_t position;
+    std::memcpy(std::data(position), positions + index * stride, sizeof(position));
+
+    return position;
+}
+
+float Dot(position_t const &a, position_t const &b) noexcept
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+// Cross product of the triangle edges: its length is the doubled triangle area.
+position_t TriangleNormal(position_t const &a, position_t const &b, position_t const &c) noexcept
+{
+    position_t const ab{b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    position_t const ac{c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+
+    return {
+        ab[1] * ac[2] - ab[2] * ac[1],
+        ab[2] * ac[0] - ab[0] * ac[2],
+        ab[0] * ac[1] - ab[1] * ac[0]
+    };
+}
+
+namespace forsyth {
+auto constexpr kCACHE_SIZE = 32;
+
+auto constexpr kCACHE_DECAY_POWER = 1.5f;
+auto constexpr kLAST_TRIANGLE_SCORE = .75f;
+auto constexpr kVALENCE_BOOST_SCALE = 2.f;
+auto constexpr kVALENCE_BOOST_POWER = .5f;
+
+float VertexScore(std::int32_t cachePosition, std::uint32_t liveTriangles)
+{
+    // The vertex isn't used by any remaining triangle.
+    if (liveTriangles == 0)
+        return -1.f;
+
+    auto score = 0.f;
+
+    if (cachePosition >= 0) {
+        // The most recent triangle vertices get fixed score to avoid re-using them immediately.
+        if (cachePosition < 3)
+            score = kLAST_TRIANGLE_SCORE;
+
+        else {
+            auto constexpr scaler = 1.f / (kCACHE_SIZE - 3);
+
+            score = std::pow(1.f - (cachePosition - 3) * scaler, kCACHE_DECAY_POWER);
+        }
+    }
+
+    // Bonus points for having low valence: vertices with few triangles left are worth finishing.
+    score += kVALENCE_BOOST_SCALE * std::pow(static_cast<float>(liveTriangles), -kVALENCE_BOOST_POWER);
+
+    return score;
+}
+}
+
+namespace overdraw {
+auto constexpr kVIEWPORT_SIZE = 256;
+auto constexpr kCACHE_SIZE = 16;
+
+// FIFO post-transform cache simulation which can be flushed in constant time.
+class FIFOCache final {
+public:
+
+    explicit FIFOCache(std::size_t vertexCount) : timestamps_(vertexCount, 0) { }
+
+    std::uint32_t Access(std::uint32_t const *triangle)
+    {
+        std::uint32_t misses = 0;
+
+        for (std::size_t i = 0; i < 3; ++i) {
+            auto const index = triangle[i];
+
+            if (timestamp_ - timestamps_.at(index) > kCACHE_SIZE) {
+                timestamps_[index] = timestamp_++;
+                ++misses;
+            }
+        }
+
+        return misses;
+    }
+
+    void Flush() noexcept { timestamp_ += kCACHE_SIZE + 1; }
+
+private:
+    std::vector<std::size_t> timestamps_;
+    std::size_t timestamp_{kCACHE_SIZE + 1};
+};
+
+float EdgeFunction(position_t const &a, position_t const &b, float x, float y) noexcept
+{
+    return (b[0] - a[0]) * (y - a[1]) - (b[1] - a[1]) * (x - a[0]);
+}
+
+// Rasterizes a screen space triangle with back-face culling and 'less' depth test,
+// returns the number of fragments that passed the depth test.
+std::size_t Rasterize(std::vector<float> &depthBuffer, position_t const &a, position_t const &b, position_t const &c)
+{
+    auto const area = EdgeFunction(a, b, c[0], c[1]);
+
+    // Back facing or degenerate triangle.
+    if (area <= 0.f)
+        return 0;
+
+    auto const minX = std::max(static_cast<int>(std::floor(std::min({a[0], b[0], c[0]}))), 0);
+    auto const minY = std::max(static_cast<int>(std::floor(std::min({a[1], b[1], c[1]}))), 0);
+    auto const maxX = std::min(static_cast<int>(std::ceil(std::max({a[0], b[0], c[0]}))), kVIEWPORT_SIZE - 1);
+    auto const maxY = std::min(static_cast<int>(std::ceil(std::max({a[1], b[1], c[1]}))), kVIEWPORT_SIZE - 1);
+
+    std::size_t shaded = 0;
+
+    for (auto y = minY; y <= maxY; ++y) {
+        for (auto x = minX; x <= maxX; ++x) {
+            auto const px = x + .5f, py = y + .5f;
+
+            auto const wa = EdgeFunction(b, c, px, py);
+            auto const wb = EdgeFunction(c, a, px, py);
+            auto const wc = EdgeFunction(a, b, px, py);
+
+            if (wa < 0.f || wb < 0.f || wc < 0.f)
+                continue;
+
+            auto const depth = (wa * a[2] + wb * b[2] + wc * c[2]) / area;
+
+            auto &&sample = depthBuffer[y * kVIEWPORT_SIZE + x];
+
+            if (depth < sample) {
+                sample = depth;
+                ++shaded;
+            }
+        }
+    }
+
+    return shaded;
+}
+}
+
+namespace meshlet {
+// Bounding sphere and normal cone of the meshlet triangles.
+void ComputeBounds(meshlet_t &meshlet, std::vector<std::uint32_t> const &indices, std::vector<std::uint32_t> const &vertices,
+                   std::byte const *positions, std::size_t stride)
+{
+    position_t minBound, maxBound;
+    minBound.fill(std::numeric_limits<float>::max());
+    maxBound.fill(std::numeric_limits<float>::lowest());
+
+    for (auto vertex : vertices) {
+        auto const position = GetPosition(positions, stride, vertex);
+
+        for (std::size_t i = 0; i < 3; ++i) {
+            minBound[i] = std::min(minBound[i], position[i]);
+            maxBound[i] = std::max(maxBound[i], position[i]);
+        }
+    }
+
+    for (std::size_t i = 0; i < 3; ++i)
+        meshlet.center[i] = (minBound[i] + maxBound[i]) * .5f;
+
+    meshlet.radius = 0.f;
+
+    for (auto vertex : vertices) {
+        auto const position = GetPosition(positions, stride, vertex);
+
+        position_t const offset{position[0] - meshlet.center[0], position[1] - meshlet.center[1], position[2] - meshlet.center[2]};
+
+        meshlet.radius = std::max(meshlet.radius, std::sqrt(Dot(offset, offset)));
+    }
+
+    std::vector<position_t> normals;
+    normals.reserve(meshlet.indexCount / 3);
+
+    position_t axis{0.f, 0.f, 0.f};
+
+    for (auto i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.indexCount; i += 3) {
+        auto normal = TriangleNormal(GetPosition(positions, stride, indices[i + 0]),
+                                     GetPosition(positions, stride, indices[i + 1]),
+                                     GetPosition(positions, stride, indices[i + 2]));
+
+        auto const length = std::sqrt(Dot(normal, normal));
+
+        // Degenerate triangles are never rasterized.
+        if (length <= 0.f)
+            continue;
+
+        for (std::size_t j = 0; j < 3; ++j) {
+            normal[j] /= length;
+            axis[j] += normal[j];
+        }
+
+        normals.push_back(normal);
+    }
+
+    // Conservative cone: the meshlet can't be culled unless all normals fit a cone narrower than a hemisphere.
+    meshlet.coneAxis = {0.f, 0.f, 0.f};
+    meshlet.coneCutoff = 1.f;
+
+    if (auto const length = std::sqrt(Dot(axis, axis)); length > 0.f) {
+        for (auto &&coordinate : axis)
+            coordinate /= length;
+
+        auto minDot = 1.f;
+
+        for (auto &&normal : normals)
+            minDot = std::min(minDot, Dot(axis, normal));
+
+        meshlet.coneAxis = axis;
+
+        if (minDot > 0.f)
+            meshlet.coneCutoff = std::sqrt(1.f - minDot * minDot);
+    }
+}
+}
+}
+
+
+vertex_cache_statistics_t
+AnalyzeVertexCache(std::vector<std::uint32_t> const &indices, std::size_t vertexCount, std::size_t cacheSize)
+{
+    vertex_cache_statistics_t statistics;
+
+    statistics.triangles = std::size(indices) / 3;
+
+    std::vector<std::size_t> timestamps(vertexCount, 0);
+    std::vector<bool> referenced(vertexCount, false);
+
+    // Timestamps start from 'cacheSize + 1' so that the zeroed ones are always treated as misses.
+    auto timestamp = cacheSize + 1;
+
+    for (auto index : indices) {
+        if (timestamp - timestamps.at(index) > cacheSize) {
+            timestamps[index] = timestamp++;
+            ++statistics.transformedVertices;
+        }
+
+        if (!referenced[index]) {
+            referenced[index] = true;
+            ++statistics.vertices;
+        }
+    }
+
+    return statistics;
+}
+
+std::size_t
+WeldVertices(std::byte *vertices, std::size_t vertexCount, std::size_t stride, std::vector<std::uint32_t> &indices)
+{
+    std::unordered_map<std::string_view, std::uint32_t> uniqueVertices;
+    uniqueVertices.reserve(vertexCount);
+
+    std::vector<std::uint32_t> remap(vertexCount);
+
+    std::uint32_t uniqueVerticesCount = 0;
+
+    for (std::size_t i = 0; i < vertexCount; ++i) {
+        std::string_view const key{reinterpret_cast<char const *>(vertices + i * stride), stride};
+
+        auto [it, inserted] = uniqueVertices.try_emplace(key, uniqueVerticesCount);
+
+        if (inserted)
+            ++uniqueVerticesCount;
+
+        remap[i] = it->second;
+    }
+
+    // The first occurrence of each unique vertex is never placed after its source position,
+    // so vertices can be compacted in place in one forward pass.
+    std::size_t writtenVerticesCount = 0;
+
+    for (std::size_t i = 0; i < vertexCount; ++i) {
+        if (remap[i] != writtenVerticesCount)
+            continue;
+
+        if (writtenVerticesCount != i)
+            std::memmove(vertices + writtenVerticesCount * stride, vertices + i * stride, stride);
+
+        ++writtenVerticesCount;
+    }
+
+    for (auto &&index : indices)
+        index = remap.at(index);
+
+    return uniqueVerticesCount;
+}
+
+void OptimizeVertexCache(std::vector<std::uint32_t> &indices, std::size_t vertexCount)
+{
+    using namespace forsyth;
+
+    auto const trianglesCount = std::size(indices) / 3;
+
+    if (trianglesCount == 0)
+        return;
+
+    std::vector<std::uint32_t> liveTriangles(vertexCount, 0);
+
+    for (auto index : indices)
+        ++liveTriangles.at(index);
+
+    // Vertex to triangles adjacency stored as ranges of a single array.
+    std::vector<std::uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    std::partial_sum(std::cbegin(liveTriangles), std::cend(liveTriangles), std::next(std::begin(adjacencyOffsets)));
+
+    std::vector<std::uint32_t> adjacency(trianglesCount * 3);
+
+    {
+        std::vector<std::uint32_t> adjacencyCounts(vertexCount, 0);
+
+        for (std::size_t i = 0; i < trianglesCount * 3; ++i) {
+            auto const vertex = indices[i];
+
+            adjacency[adjacencyOffsets[vertex] + adjacencyCounts[vertex]++] = static_cast<std::uint32_t>(i / 3);
+        }
+    }
+
+    std::vector<std::int32_t> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+
+    for (std::size_t i = 0; i < vertexCount; ++i)
+        vertexScores[i] = VertexScore(-1, liveTriangles[i]);
+
+    std::vector<float> triangleScores(trianglesCount);
+    std::vector<bool> emitted(trianglesCount, false);
+
+    auto bestTriangle = kINVALID_TRIANGLE;
+    auto bestScore = std::numeric_limits<float>::lowest();
+
+    for (std::size_t i = 0; i < trianglesCount; ++i) {
+        triangleScores[i] = vertexScores[indices[i * 3 + 0]] + vertexScores[indices[i * 3 + 1]] + vertexScores[indices[i * 3 + 2]];
+
+        if (triangleScores[i] > bestScore) {
+            bestScore = triangleScores[i];
+            bestTriangle = i;
+        }
+    }
+
+    std::array<std::uint32_t, kCACHE_SIZE + 3> cache, updatedCache;
+    std::size_t cacheSize = 0;
+
+    std::vector<std::uint32_t> optimizedIndices;
+    optimizedIndices.reserve(std::size(indices));
+
+    std::size_t cursor = 0;
+
+    while (bestTriangle != kINVALID_TRIANGLE) {
+        emitted[bestTriangle] = true;
+
+        auto const triangle = make_array(indices[bestTriangle * 3 + 0], indices[bestTriangle * 3 + 1], indices[bestTriangle * 3 + 2]);
+
+        optimizedIndices.insert(std::end(optimizedIndices), std::cbegin(triangle), std::cend(triangle));
+
+        std::size_t updatedCacheSize = 0;
+
+        for (auto vertex : triangle) {
+            auto const begin = std::next(std::begin(adjacency), adjacencyOffsets[vertex]);
+            auto const end = std::next(begin, liveTriangles[vertex]);
+
+            // Swap the emitted triangle out of the vertex live triangles range.
+            if (auto it = std::find(begin, end, static_cast<std::uint32_t>(bestTriangle)); it != end)
+                std::iter_swap(it, std::prev(end));
+
+            --liveTriangles[vertex];
+
+            updatedCache[updatedCacheSize++] = vertex;
+        }
+
+        for (std::size_t i = 0; i < cacheSize; ++i) {
+            auto const vertex = cache[i];
+
+            if (std::find(std::cbegin(triangle), std::cend(triangle), vertex) == std::cend(triangle))
+                updatedCache[updatedCacheSize++] = vertex;
+        }
+
+        for (std::size_t i = 0; i < updatedCacheSize; ++i) {
+            auto const vertex = updatedCache[i];
+
+            cachePositions[vertex] = i < kCACHE_SIZE ? static_cast<std::int32_t>(i) : -1;
+            vertexScores[vertex] = VertexScore(cachePositions[vertex], liveTriangles[vertex]);
+        }
+
+        bestTriangle = kINVALID_TRIANGLE;
+        bestScore = std::numeric_limits<float>::lowest();
+
+        for (std::size_t i = 0; i < updatedCacheSize; ++i) {
+            auto const vertex = updatedCache[i];
+
+            for (auto j = adjacencyOffsets[vertex]; j < adjacencyOffsets[vertex] + liveTriangles[vertex]; ++j) {
+                auto const t = adjacency[j];
+
+                auto const score = vertexScores[indices[t * 3 + 0]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+
+                triangleScores[t] = score;
+
+                if (score > bestScore) {
+                    bestScore = score;
+                    bestTriangle = t;
+                }
+            }
+        }
+
+        cacheSize = std::min(updatedCacheSize, static_cast<std::size_t>(kCACHE_SIZE));
+        std::copy_n(std::cbegin(updatedCache), cacheSize, std::begin(cache));
+
+        // None of the cached vertices have live triangles: restart from the first unprocessed triangle.
+        if (bestTriangle == kINVALID_TRIANGLE) {
+            while (cursor < trianglesCount && emitted[cursor])
+                ++cursor;
+
+            if (cursor < trianglesCount)
+                bestTriangle = cursor;
+        }
+    }
+
+    indices = std::move(optimizedIndices);
+}
+
+std::size_t
+OptimizeVertexFetch(std::byte *vertices, std::size_t vertexCount, std::size_t stride, std::vector<std::uint32_t> &indices)
+{
+    std::vector<std::uint32_t> remap(vertexCount, kINVALID_VERTEX);
+
+    std::uint32_t fetchedVerticesCount = 0;
+
+    for (auto &&index : indices) {
+        auto &&newIndex = remap.at(index);
+
+        if (newIndex == kINVALID_VERTEX)
+            newIndex = fetchedVerticesCount++;
+
+        index = newIndex;
+    }
+
+    std::vector<std::byte> reordered(fetchedVerticesCount * stride);
+
+    for (std::size_t i = 0; i < vertexCount; ++i)
+        if (remap[i] != kINVALID_VERTEX)
+            std::memcpy(std::data(reordered) + remap[i] * stride, vertices + i * stride, stride);
+
+    std::copy(std::cbegin(reordered), std::cend(reordered), vertices);
+
+    return fetchedVerticesCount;
+}
+
+overdraw_statistics_t
+AnalyzeOverdraw(std::vector<std::uint32_t> const &indices, std::byte const *positions, std::size_t vertexCount, std::size_t stride)
+{
+    using namespace overdraw;
+
+    overdraw_statistics_t statistics;
+
+    if (std::size(indices) < 3)
+        return statistics;
+
+    position_t minBound, maxBound;
+    minBound.fill(std::numeric_limits<float>::max());
+    maxBound.fill(std::numeric_limits<float>::lowest());
+
+    for (auto index : indices) {
+        auto const position = GetPosition(positions, stride, index);
+
+        for (std::size_t i = 0; i < 3; ++i) {
+            minBound[i] = std::min(minBound[i], position[i]);
+            maxBound[i] = std::max(maxBound[i], position[i]);
+        }
+    }
+
+    auto const extent = std::max({maxBound[0] - minBound[0], maxBound[1] - minBound[1], maxBound[2] - minBound[2]});
+
+    if (extent <= 0.f)
+        return statistics;
+
+    auto const scale = (kVIEWPORT_SIZE - 1) / extent;
+
+    std::vector<float> depthBuffer(kVIEWPORT_SIZE * kVIEWPORT_SIZE);
+    std::vector<position_t> screenPositions(vertexCount);
+
+    // Looking down each axis from both directions, the 'u' axis is mirrored for the negative
+    // direction to keep front faces counter-clockwise.
+    for (std::size_t axis = 0; axis < 3; ++axis) {
+        auto const u = (axis + 1) % 3, v = (axis + 2) % 3;
+
+        for (auto direction : {1.f, -1.f}) {
+            for (auto index : indices) {
+                auto const position = GetPosition(positions, stride, index);
+
+                screenPositions.at(index) = position_t{
+                    (direction > 0.f ? position[u] - minBound[u] : maxBound[u] - position[u]) * scale,
+                    (position[v] - minBound[v]) * scale,
+                    -direction * position[axis]
+                };
+            }
+
+            std::fill(std::begin(depthBuffer), std::end(depthBuffer), std::numeric_limits<float>::max());
+
+            for (std::size_t i = 0; i + 2 < std::size(indices); i += 3) {
+                statistics.pixelsShaded += Rasterize(depthBuffer, screenPositions[indices[i + 0]],
+                                                     screenPositions[indices[i + 1]], screenPositions[indices[i + 2]]);
+            }
+
+            statistics.pixelsCovered += std::count_if(std::cbegin(depthBuffer), std::cend(depthBuffer), [] (auto depth)
+            {
+                return depth < std::numeric_limits<float>::max();
+            });
+        }
+    }
+
+    return statistics;
+}
+
+void OptimizeOverdraw(std::vector<std::uint32_t> &indices, std::byte const *positions, std::size_t vertexCount, std::size_t stride, float threshold)
+{
+    using namespace overdraw;
+
+    auto const trianglesCount = std::size(indices) / 3;
+
+    if (trianglesCount == 0)
+        return;
+
+    FIFOCache cache{vertexCount};
+
+    // Hard boundaries are placed where the cache is effectively flushed: all three vertices of a triangle miss.
+    std::vector<std::size_t> hardClusters;
+
+    for (std::size_t i = 0; i < trianglesCount; ++i)
+        if (cache.Access(&indices[i * 3]) == 3 || i == 0)
+            hardClusters.push_back(i);
+
+    // Soft boundaries split hard clusters further as soon as the cluster ACMR gets within the threshold.
+    std::vector<std::size_t> clusters;
+
+    for (std::size_t k = 0; k < std::size(hardClusters); ++k) {
+        auto const begin = hardClusters[k];
+        auto const end = k + 1 < std::size(hardClusters) ? hardClusters[k + 1] : trianglesCount;
+
+        std::size_t misses = 0;
+
+        cache.Flush();
+
+        for (auto i = begin; i < end; ++i)
+            misses += cache.Access(&indices[i * 3]);
+
+        auto const maxACMR = threshold * static_cast<float>(misses) / (end - begin);
+
+        clusters.push_back(begin);
+
+        std::size_t clusterMisses = 0, clusterSize = 0;
+
+        cache.Flush();
+
+        for (auto i = begin; i < end; ++i) {
+            clusterMisses += cache.Access(&indices[i * 3]);
+            ++clusterSize;
+
+            if (i + 1 < end && clusterMisses <= maxACMR * clusterSize) {
+                clusters.push_back(i + 1);
+
+                clusterMisses = clusterSize = 0;
+                cache.Flush();
+            }
+        }
+    }
+
+    auto const clustersCount = std::size(clusters);
+
+    // Area weighted centroid and normal of each cluster.
+    std::vector<position_t> centroids(clustersCount, position_t{0.f, 0.f, 0.f});
+    std::vector<position_t> normals(clustersCount, position_t{0.f, 0.f, 0.f});
+
+    position_t meshCentroid{0.f, 0.f, 0.f};
+    auto meshArea = 0.f;
+
+    for (std::size_t k = 0; k < clustersCount; ++k) {
+        auto const end = k + 1 < clustersCount ? clusters[k + 1] : trianglesCount;
+
+        auto &&centroid = centroids[k];
+        auto &&normal = normals[k];
+
+        auto clusterArea = 0.f;
+
+        for (auto i = clusters[k]; i < end; ++i) {
+            auto const a = GetPosition(positions, stride, indices[i * 3 + 0]);
+            auto const b = GetPosition(positions, stride, indices[i * 3 + 1]);
+            auto const c = GetPosition(positions, stride, indices[i * 3 + 2]);
+
+            auto const cross = TriangleNormal(a, b, c);
+
+            auto const area = std::sqrt(Dot(cross, cross));
+
+            for (std::size_t j = 0; j < 3; ++j) {
+                centroid[j] += (a[j] + b[j] + c[j]) / 3.f * area;
+                normal[j] += cross[j];
+            }
+
+            clusterArea += area;
+        }
+
+        for (std::size_t j = 0; j < 3; ++j)
+            meshCentroid[j] += centroid[j];
+
+        meshArea += clusterArea;
+
+        if (clusterArea > 0.f)
+            for (auto &&coordinate : centroid)
+                coordinate /= clusterArea;
+
+        auto const length = std::sqrt(Dot(normal, normal));
+
+        if (length > 0.f)
+            for (auto &&coordinate : normal)
+                coordinate /= length;
+    }
+
+    if (meshArea > 0.f)
+        for (auto &&coordinate : meshCentroid)
+            coordinate /= meshArea;
+
+    // Clusters facing outwards and lying far from the mesh center are likely to occlude the rest,
+    // so they are drawn first.
+    std::vector<float> sortKeys(clustersCount);
+
+    for (std::size_t k = 0; k < clustersCount; ++k) {
+        position_t const offset{centroids[k][0] - meshCentroid[0], centroids[k][1] - meshCentroid[1], centroids[k][2] - meshCentroid[2]};
+
+        sortKeys[k] = Dot(offset, normals[k]);
+    }
+
+    std::vector<std::size_t> order(clustersCount);
+    std::iota(std::begin(order), std::end(order), 0);
+
+    std::stable_sort(std::begin(order), std::end(order), [&sortKeys] (auto lhs, auto rhs)
+    {
+        return sortKeys[lhs] > sortKeys[rhs];
+    });
+
+    std::vector<std::uint32_t> sortedIndices;
+    sortedIndices.reserve(std::size(indices));
+
+    for (auto k : order) {
+        auto const begin = std::next(std::cbegin(indices), clusters[k] * 3);
+        auto const end = std::next(std::cbegin(indices), (k + 1 < clustersCount ? clusters[k + 1] : trianglesCount) * 3);
+
+        sortedIndices.insert(std::end(sortedIndices), begin, end);
+    }
+
+    indices = std::move(sortedIndices);
+}
+
+std::vector<meshlet_t>
+BuildMeshlets(std::vector<std::uint32_t> const &indices, std::byte const *positions, std::size_t vertexCount, std::size_t stride,
+              std::size_t maxVertices, std::size_t maxTriangles)
+{
+    std::vector<meshlet_t> meshlets;
+
+    auto const trianglesCount = std::size(indices) / 3;
+
+    if (trianglesCount == 0)
+        return meshlets;
+
+    // Index of the last meshlet that references the vertex.
+    std::vector<std::size_t> vertexMeshlets(vertexCount, std::numeric_limits<std::size_t>::max());
+
+    std::vector<std::uint32_t> meshletVertices;
+    meshletVertices.reserve(maxVertices);
+
+    meshlet_t meshlet;
+
+    auto const flush = [&] ()
+    {
+        meshlet::ComputeBounds(meshlet, indices, meshletVertices, positions, stride);
+
+        meshlets.push_back(meshlet);
+
+        meshlet.firstIndex += meshlet.indexCount;
+        meshlet.indexCount = 0;
+
+        meshletVertices.clear();
+    };
+
+    for (std::size_t i = 0; i < trianglesCount; ++i) {
+        auto const triangle = &indices[i * 3];
+
+        auto const newVertices = std::count_if(triangle, triangle + 3, [&vertexMeshlets, &meshlets] (auto vertex)
+        {
+            return vertexMeshlets.at(vertex) != std::size(meshlets);
+        });
+
+        auto const full = std::size(meshletVertices) + static_cast<std::size_t>(newVertices) > maxVertices || meshlet.indexCount / 3 + 1 > maxTriangles;
+
+        if (full)
+            flush();
+
+        for (auto vertex : make_array(triangle[0], triangle[1], triangle[2])) {
+            if (vertexMeshlets[vertex] != std::size(meshlets)) {
+                vertexMeshlets[vertex] = std::size(meshlets);
+                meshletVertices.push_back(vertex);
+            }
+        }
+
+        meshlet.indexCount += 3;
+    }
+
+    if (meshlet.indexCount != 0)
+        flush();
+
+    return meshlets;
+}
+
+std::pair<std::array<float, 3>, std::array<float, 3>>
+ComputePositionBounds(std::byte const *positions, std::size_t vertexCount, std::size_t stride)
+{
+    auto constexpr kMAX = std::numeric_limits<float>::max();
+
+    position_t minBound{kMAX, kMAX, kMAX}, maxBound{-kMAX, -kMAX, -kMAX};
+
+    std::size_t vertexIndex = 0;
+
+#ifdef USE_SSE_BOUNDS_SCAN
+    // Each position is loaded as four floats, so the last one is left to the scalar loop to not read past the vertices.
+    if (vertexCount > 1) {
+        auto minVector = _mm_set1_ps(kMAX);
+        auto maxVector = _mm_set1_ps(-kMAX);
+
+        for (; vertexIndex < vertexCount - 1; ++vertexIndex) {
+            auto const position = _mm_loadu_ps(reinterpret_cast<float const *>(positions + vertexIndex * stride));
+
+            minVector = _mm_min_ps(minVector, position);
+            maxVector = _mm_max_ps(maxVector, position);
+        }
+
+        alignas(16) std::array<float, 4> minLanes, maxLanes;
+
+        _mm_store_ps(std::data(minLanes), minVector);
+        _mm_store_ps(std::data(maxLanes), maxVector);
+
+        std::copy_n(std::cbegin(minLanes), 3, std::begin(minBound));
+        std::copy_n(std::cbegin(maxLanes), 3, std::begin(maxBound));
+    }
+#endif
+
+    for (; vertexIndex < vertexCount; ++vertexIndex) {
+        auto const position = GetPosition(positions, stride, static_cast<std::uint32_t>(vertexIndex));
+
+        for (auto i = 0u; i < 3u; ++i) {
+            minBound[i] = std::min(minBound[i], position[i]);
+            maxBound[i] = std::max(maxBound[i], position[i]);
+        }
+    }
+
+    return {minBound, maxBound};
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <utility>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "helpers.hxx"
+
+
+struct vertex_cache_statistics_t {
+    std::size_t transformedVertices{0};
+    std::size_t vertices{0};
+    std::size_t triangles{0};
+
+    // Average cache miss ratio: transformed vertices per triangle.
+    float ACMR() const noexcept { return triangles ? static_cast<float>(transformedVertices) / triangles : 0.f; }
+
+    // Average transform to vertex ratio: 1.0 is the best possible value.
+    float ATVR() const noexcept { return vertices ? static_cast<float>(transformedVertices) / vertices : 0.f; }
+
+    vertex_cache_statistics_t &operator+= (vertex_cache_statistics_t const &rhs) noexcept
+    {
+        transformedVertices += rhs.transformedVertices;
+        vertices += rhs.vertices;
+        triangles += rhs.triangles;
+
+        return *this;
+    }
+};
+
+// Simulates a FIFO post-transform cache of 'cacheSize' entries over the triangle list.
+[[nodiscard]] vertex_cache_statistics_t
+AnalyzeVertexCache(std::vector<std::uint32_t> const &indices, std::size_t vertexCount, std::size_t cacheSize = 16);
+
+// Merges bitwise identical vertices, returns the number of unique vertices.
+// Unique vertices are compacted to the beginning of 'vertices' keeping their order.
+[[nodiscard]] std::size_t
+WeldVertices(std::byte *vertices, std::size_t vertexCount, std::size_t stride, std::vector<std::uint32_t> &indices);
+
+// Reorders triangles for the post-transform vertex cache (Tom Forsyth's linear-speed algorithm).
+void OptimizeVertexCache(std::vector<std::uint32_t> &indices, std::size_t vertexCount);
+
+// Reorders vertices in the order of the first reference by the index buffer,
+// unreferenced vertices are dropped. Returns the number of remaining vertices.
+[[nodiscard]] std::size_t
+OptimizeVertexFetch(std::byte *vertices, std::size_t vertexCount, std::size_t stride, std::vector<std::uint32_t> &indices);
+
+
+struct overdraw_statistics_t {
+    std::size_t pixelsCovered{0};
+    std::size_t pixelsShaded{0};
+
+    // Number of fragments shaded per covered pixel: 1.0 means there is no overdraw at all.
+    float overdraw() const noexcept { return pixelsCovered ? static_cast<float>(pixelsShaded) / pixelsCovered : 0.f; }
+
+    overdraw_statistics_t &operator+= (overdraw_statistics_t const &rhs) noexcept
+    {
+        pixelsCovered += rhs.pixelsCovered;
+        pixelsShaded += rhs.pixelsShaded;
+
+        return *this;
+    }
+};
+
+// Estimates overdraw by rasterizing the triangle list with depth test and back-face culling
+// from six axis aligned orthographic views. 'positions' points to the first vertex position,
+// positions are three floats each and are 'stride' bytes apart.
+[[nodiscard]] overdraw_statistics_t
+AnalyzeOverdraw(std::vector<std::uint32_t> const &indices, std::byte const *positions, std::size_t vertexCount, std::size_t stride);
+
+// Splits the cache optimized triangle list into clusters and sorts them front to back using
+// a view independent heuristic. The vertex cache efficiency of each cluster is kept within
+// 'threshold' of the original one (1.05 allows 5% worse ACMR).
+void OptimizeOverdraw(std::vector<std::uint32_t> &indices, std::byte const *positions, std::size_t vertexCount, std::size_t stride, float threshold);
+
+
+auto constexpr kMAX_MESHLET_VERTICES = 64u;
+auto constexpr kMAX_MESHLET_TRIANGLES = 124u;
+
+// Contiguous range of a primitive's triangles with culling bounds. The meshlet is entirely back facing
+// and can be skipped if 'dot(center - eye, coneAxis) >= coneCutoff * length(center - eye) + radius'.
+struct meshlet_t {
+    std::uint32_t firstIndex{0}, indexCount{0};
+
+    std::array<float, 3> center{0.f, 0.f, 0.f};
+    float radius{0.f};
+
+    std::array<float, 3> coneAxis{0.f, 0.f, 0.f};
+    float coneCutoff{1.f};
+};
+
+// Greedily splits the triangle list into meshlets keeping the triangle order, so the input should be vertex cache optimized.
+// Meshlet index ranges are relative to the beginning of 'indices'.
+[[nodiscard]] std::vector<meshlet_t>
+BuildMeshlets(std::vector<std::uint32_t> const &indices, std::byte const *positions, std::size_t vertexCount, std::size_t stride,
+              std::size_t maxVertices = kMAX_MESHLET_VERTICES, std::size_t maxTriangles = kMAX_MESHLET_TRIANGLES);
+
+
+// Minimal and maximal vertex positions, the bounds are inverted (min > max) if there are no vertices.
+[[nodiscard]] std::pair<std::array<float, 3>, std::array<float, 3>>
+ComputePositionBounds(std::byte const *positions, std::size_t vertexCount, std::size_t stride);
@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "mesh_quantizer.hxx"
+
+namespace {
+template<class T>
+T ToNormalized(float value) noexcept
+{
+    auto constexpr maxValue = static_cast<float>(std::numeric_limits<T>::max());
+
+    return static_cast<T>(std::round(std::clamp(value, -1.f, 1.f) * maxValue));
+}
+
+std::uint16_t ToHalf(float value) noexcept
+{
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    auto const sign = static_cast<std::uint16_t>((bits >> 16) & 0x8000);
+    auto const exponent = static_cast<std::int32_t>((bits >> 23) & 0xFF) - 127 + 15;
+    auto mantissa = bits & 0x7FFFFF;
+
+    // Infinity or NaN.
+    if (((bits >> 23) & 0xFF) == 0xFF)
+        return sign | 0x7C00 | (mantissa ? 0x200 : 0);
+
+    // Overflow is clamped to infinity.
+    if (exponent >= 31)
+        return sign | 0x7C00;
+
+    // Denormalized half or zero.
+    if (exponent <= 0) {
+        if (exponent < -10)
+            return sign;
+
+        mantissa |= 0x800000;
+
+        auto const shift = static_cast<std::uint32_t>(14 - exponent);
+        auto half = static_cast<std::uint16_t>(mantissa >> shift);
+
+        if ((mantissa >> (shift - 1)) & 1)
+            ++half;
+
+        return sign | half;
+    }
+
+    auto half = static_cast<std::uint16_t>(sign | (exponent << 10) | (mantissa >> 13));
+
+    // Rounding carry correctly propagates into the exponent.
+    if (mantissa & 0x1000)
+        ++half;
+
+    return half;
+}
+
+// Projects the unit vector onto the octahedron and unfolds the lower hemisphere onto the outer triangles.
+std::array<float, 2> ToOctahedral(std::array<float, 3> const &v) noexcept
+{
+    auto const length = std::abs(v[0]) + std::abs(v[1]) + std::abs(v[2]);
+
+    if (length <= 0.f)
+        return {0.f, 0.f};
+
+    auto const x = v[0] / length, y = v[1] / length;
+
+    if (v[2] >= 0.f)
+        return {x, y};
+
+    return {
+        (1.f - std::abs(y)) * (x >= 0.f ? 1.f : -1.f),
+        (1.f - std::abs(x)) * (y >= 0.f ? 1.f : -1.f)
+    };
+}
+
+template<class T, std::size_t N>
+void Store(std::byte *dst, std::array<T, N> const &values) noexcept
+{
+    std::memcpy(dst, std::data(values), sizeof(values));
+}
+}
+
+
+std::pair<std::array<float, 3>, std::array<float, 3>>
+GetPositionDequantization(std::array<float, 3> const &minBound, std::array<float, 3> const &maxBound)
+{
+    std::array<float, 3> scale, offset;
+
+    for (std::size_t i = 0; i < 3; ++i) {
+        scale[i] = (maxBound[i] - minBound[i]) * .5f;
+        offset[i] = (maxBound[i] + minBound[i]) * .5f;
+    }
+
+    return {scale, offset};
+}
+
+bool QuantizeVertices(std::byte *dst, vertex_layout_t const &dstLayout, std::byte const *src, vertex_layout_t const &srcLayout, std::size_t count,
+                      std::array<float, 3> const &minBound, std::array<float, 3> const &maxBound)
+{
+    auto const [scale, offset] = GetPositionDequantization(minBound, maxBound);
+
+    for (auto &&dstAttribute : dstLayout.attributeDescriptions) {
+        auto srcAttribute = std::find_if(std::cbegin(srcLayout.attributeDescriptions), std::cend(srcLayout.attributeDescriptions), [&dstAttribute] (auto &&attribute)
+        {
+            return attribute.location == dstAttribute.location;
+        });
+
+        if (srcAttribute == std::cend(srcLayout.attributeDescriptions))
+            return false;
+
+        std::size_t srcComponents = 0;
+
+        switch (srcAttribute->format) {
+            case VK_FORMAT_R32G32_SFLOAT: srcComponents = 2; break;
+            case VK_FORMAT_R32G32B32_SFLOAT: srcComponents = 3; break;
+            case VK_FORMAT_R32G32B32A32_SFLOAT: srcComponents = 4; break;
+            default: return false;
+        }
+
+        auto const location = dstAttribute.location;
+
+        for (std::size_t i = 0; i < count; ++i) {
+            std::array<float, 4> value{0.f, 0.f, 0.f, 1.f};
+            std::memcpy(std::data(value), src + i * srcLayout.stride + srcAttribute->offset, srcComponents * sizeof(float));
+
+            auto const output = dst + i * dstLayout.stride + dstAttribute.offset;
+
+            if (location == semantic_location_v<semantic::position> && dstAttribute.format == VK_FORMAT_R16G16B16A16_SNORM) {
+                std::array<std::int16_t, 4> position{0, 0, 0, 0};
+
+                for (std::size_t j = 0; j < 3; ++j)
+                    position[j] = ToNormalized<std::int16_t>(scale[j] > 0.f ? (value[j] - offset[j]) / scale[j] : 0.f);
+
+                Store(output, position);
+            }
+
+            else if (location == semantic_location_v<semantic::normal> && dstAttribute.format == VK_FORMAT_R16G16_SNORM) {
+                auto const octahedral = ToOctahedral({value[0], value[1], value[2]});
+
+                Store(output, std::array<std::int16_t, 2>{
+                    ToNormalized<std::int16_t>(octahedral[0]), ToNormalized<std::int16_t>(octahedral[1])
+                });
+            }
+
+            else if (location == semantic_location_v<semantic::tangent> && dstAttribute.format == VK_FORMAT_R8G8B8A8_SNORM) {
+                auto const octahedral = ToOctahedral({value[0], value[1], value[2]});
+
+                Store(output, std::array<std::int8_t, 4>{
+                    ToNormalized<std::int8_t>(octahedral[0]), ToNormalized<std::int8_t>(octahedral[1]),
+                    0, ToNormalized<std::int8_t>(value[3] < 0.f ? -1.f : 1.f)
+                });
+            }
+
+            else if (dstAttribute.format == VK_FORMAT_R16G16_SFLOAT && srcComponents == 2)
+                Store(output, std::array<std::uint16_t, 2>{ToHalf(value[0]), ToHalf(value[1])});
+
+            else if (dstAttribute.format == srcAttribute->format)
+                std::memcpy(output, std::data(value), srcComponents * sizeof(float));
+
+            else return false;
+        }
+    }
+
+    return true;
+}
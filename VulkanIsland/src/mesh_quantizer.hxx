@@ -0,0 +1,20 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "mesh.hxx"
+
+
+// Encodes 'count' float vertices of 'srcLayout' into the quantized 'dstLayout' vertices.
+// Positions are normalized to the [minBound, maxBound] box, normals and tangents are octahedral encoded
+// and texture coordinates are converted to half floats. Returns false on unsupported attribute formats.
+[[nodiscard]] bool
+QuantizeVertices(std::byte *dst, vertex_layout_t const &dstLayout, std::byte const *src, vertex_layout_t const &srcLayout, std::size_t count,
+                 std::array<float, 3> const &minBound, std::array<float, 3> const &maxBound);
+
+// Scale and offset restoring positions quantized to the [minBound, maxBound] box.
+[[nodiscard]] std::pair<std::array<float, 3>, std::array<float, 3>>
+GetPositionDequantization(std::array<float, 3> const &minBound, std::array<float, 3> const &maxBound);
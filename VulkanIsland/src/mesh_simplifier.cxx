@@ -0,0 +1,410 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "mesh_simplifier.hxx"
+
+namespace {
+// Penalty of moving a border vertex away from the border relative to moving it away from the surface.
+auto constexpr kBORDER_WEIGHT = 10.f;
+
+// Attribute differences are scaled by the squared mesh extent to be comparable with the mean squared distances.
+auto constexpr kNORMAL_WEIGHT = .05f;
+auto constexpr kTEX_COORD_WEIGHT = .05f;
+
+using position_t = std::array<float, 3>;
+
+position_t Subtract(position_t const &a, position_t const &b) noexcept
+{
+    return {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+}
+
+float Dot(position_t const &a, position_t const &b) noexcept
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+position_t Cross(position_t const &a, position_t const &b) noexcept
+{
+    return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+}
+
+// Symmetric 4x4 matrix of the plane distance quadric along with the total weight of its planes.
+struct Quadric final {
+    double a2{0}, ab{0}, ac{0}, ad{0};
+    double b2{0}, bc{0}, bd{0};
+    double c2{0}, cd{0};
+    double d2{0};
+
+    double weight{0};
+
+    Quadric() = default;
+
+    Quadric(position_t const &normal, float distance, float weight) noexcept
+    {
+        double const a = normal[0], b = normal[1], c = normal[2], d = distance;
+
+        a2 = weight * a * a; ab = weight * a * b; ac = weight * a * c; ad = weight * a * d;
+        b2 = weight * b * b; bc = weight * b * c; bd = weight * b * d;
+        c2 = weight * c * c; cd = weight * c * d;
+        d2 = weight * d * d;
+
+        this->weight = weight;
+    }
+
+    Quadric &operator+= (Quadric const &rhs) noexcept
+    {
+        a2 += rhs.a2; ab += rhs.ab; ac += rhs.ac; ad += rhs.ad;
+        b2 += rhs.b2; bc += rhs.bc; bd += rhs.bd;
+        c2 += rhs.c2; cd += rhs.cd;
+        d2 += rhs.d2;
+
+        weight += rhs.weight;
+
+        return *this;
+    }
+
+    // Weighted mean of the squared distances from the point to the quadric planes,
+    // so the error is in squared object space units whatever the plane areas are.
+    double Error(position_t const &p) const noexcept
+    {
+        if (weight <= 0)
+            return 0.;
+
+        double const x = p[0], y = p[1], z = p[2];
+
+        auto const error = x * x * a2 + y * y * b2 + z * z * c2 +
+                           2 * (x * y * ab + x * z * ac + y * z * bc) +
+                           2 * (x * ad + y * bd + z * cd) + d2;
+
+        return std::max(error / weight, 0.);
+    }
+};
+
+std::uint64_t EdgeKey(std::uint32_t a, std::uint32_t b) noexcept
+{
+    return a < b ? (static_cast<std::uint64_t>(a) << 32) | b : (static_cast<std::uint64_t>(b) << 32) | a;
+}
+
+struct collapse_t {
+    std::uint32_t source, target;
+    float cost, error;
+};
+
+template<std::size_t N>
+std::vector<std::array<float, N>> ReadAttribute(std::byte const *vertices, std::size_t vertexCount, std::size_t stride, std::uint32_t offset)
+{
+    std::vector<std::array<float, N>> values(vertexCount);
+
+    for (std::size_t i = 0; i < vertexCount; ++i)
+        std::memcpy(std::data(values[i]), vertices + i * stride + offset, sizeof(float) * N);
+
+    return values;
+}
+
+template<std::size_t N>
+float SquaredDistance(std::array<float, N> const &a, std::array<float, N> const &b) noexcept
+{
+    auto distance = 0.f;
+
+    for (std::size_t i = 0; i < N; ++i)
+        distance += (a[i] - b[i]) * (a[i] - b[i]);
+
+    return distance;
+}
+}
+
+
+float SimplifyMesh(std::vector<std::uint32_t> &indices, std::byte const *vertices, std::size_t vertexCount, vertex_layout_t const &layout,
+                   std::size_t targetIndexCount)
+{
+    auto const &descriptions = layout.attributeDescriptions;
+
+    auto const find_attribute = [&descriptions] (std::uint32_t location, VkFormat format)
+    {
+        auto it = std::find_if(std::cbegin(descriptions), std::cend(descriptions), [location, format] (auto &&description)
+        {
+            return description.location == location && description.format == format;
+        });
+
+        return it != std::cend(descriptions) ? &*it : nullptr;
+    };
+
+    auto const positionAttribute = find_attribute(semantic_location_v<semantic::position>, VK_FORMAT_R32G32B32_SFLOAT);
+
+    if (positionAttribute == nullptr || std::size(indices) <= targetIndexCount)
+        return 0.f;
+
+    auto const stride = layout.stride;
+
+    auto const positions = ReadAttribute<3>(vertices, vertexCount, stride, positionAttribute->offset);
+
+    std::vector<std::array<float, 3>> normals;
+    std::vector<std::array<float, 2>> texCoords;
+
+    if (auto attribute = find_attribute(semantic_location_v<semantic::normal>, VK_FORMAT_R32G32B32_SFLOAT); attribute)
+        normals = ReadAttribute<3>(vertices, vertexCount, stride, attribute->offset);
+
+    if (auto attribute = find_attribute(semantic_location_v<semantic::tex_coord_0>, VK_FORMAT_R32G32_SFLOAT); attribute)
+        texCoords = ReadAttribute<2>(vertices, vertexCount, stride, attribute->offset);
+
+    // Vertices sharing the same position form a wedge, the first wedge vertex is its representative.
+    std::vector<std::uint32_t> wedges(vertexCount);
+    std::vector<std::uint32_t> wedgeSizes(vertexCount, 0);
+
+    {
+        std::unordered_map<std::string_view, std::uint32_t> uniquePositions;
+        uniquePositions.reserve(vertexCount);
+
+        for (std::uint32_t i = 0; i < vertexCount; ++i) {
+            std::string_view const key{reinterpret_cast<char const *>(std::data(positions[i])), sizeof(position_t)};
+
+            wedges[i] = uniquePositions.try_emplace(key, i).first->second;
+        }
+    }
+
+    std::vector<bool> referenced(vertexCount, false);
+
+    for (auto index : indices)
+        referenced.at(index) = true;
+
+    for (std::uint32_t i = 0; i < vertexCount; ++i)
+        if (referenced[i])
+            ++wedgeSizes[wedges[i]];
+
+    // Edges are counted in the position space to find borders and non-manifold edges.
+    std::unordered_map<std::uint64_t, std::uint32_t> edgeCounts;
+
+    for (std::size_t i = 0; i < std::size(indices); i += 3) {
+        for (std::size_t j = 0; j < 3; ++j) {
+            auto const a = wedges[indices[i + j]], b = wedges[indices[i + (j + 1) % 3]];
+
+            if (a != b)
+                ++edgeCounts[EdgeKey(a, b)];
+        }
+    }
+
+    auto const is_border_edge = [&edgeCounts, &wedges] (std::uint32_t a, std::uint32_t b)
+    {
+        auto it = edgeCounts.find(EdgeKey(wedges[a], wedges[b]));
+
+        return it != std::cend(edgeCounts) && it->second == 1;
+    };
+
+    std::vector<bool> locked(vertexCount, false), border(vertexCount, false);
+
+    // Attribute seams are locked as well as non-manifold vertices.
+    for (std::uint32_t i = 0; i < vertexCount; ++i)
+        locked[i] = wedgeSizes[wedges[i]] > 1;
+
+    std::vector<Quadric> quadrics(vertexCount);
+
+    for (std::size_t i = 0; i < std::size(indices); i += 3) {
+        auto const &p0 = positions[indices[i + 0]], &p1 = positions[indices[i + 1]], &p2 = positions[indices[i + 2]];
+
+        auto normal = Cross(Subtract(p1, p0), Subtract(p2, p0));
+
+        auto const area = std::sqrt(Dot(normal, normal));
+
+        if (area <= 0.f)
+            continue;
+
+        for (auto &&coordinate : normal)
+            coordinate /= area;
+
+        Quadric const quadric{normal, -Dot(normal, p0), area};
+
+        for (std::size_t j = 0; j < 3; ++j) {
+            auto const a = indices[i + j], b = indices[i + (j + 1) % 3];
+
+            quadrics[wedges[a]] += quadric;
+
+            if (auto it = edgeCounts.find(EdgeKey(wedges[a], wedges[b])); it != std::cend(edgeCounts) && it->second > 2)
+                locked[a] = locked[b] = true;
+
+            if (!is_border_edge(a, b))
+                continue;
+
+            border[a] = border[b] = true;
+
+            // The plane containing the border edge and perpendicular to the triangle.
+            auto const edge = Subtract(positions[b], positions[a]);
+
+            auto borderNormal = Cross(edge, normal);
+
+            if (auto const length = std::sqrt(Dot(borderNormal, borderNormal)); length > 0.f) {
+                for (auto &&coordinate : borderNormal)
+                    coordinate /= length;
+
+                Quadric const borderQuadric{borderNormal, -Dot(borderNormal, positions[a]), Dot(edge, edge) * kBORDER_WEIGHT};
+
+                quadrics[wedges[a]] += borderQuadric;
+                quadrics[wedges[b]] += borderQuadric;
+            }
+        }
+    }
+
+    position_t minBound, maxBound;
+    minBound.fill(std::numeric_limits<float>::max());
+    maxBound.fill(std::numeric_limits<float>::lowest());
+
+    for (auto index : indices) {
+        for (std::size_t i = 0; i < 3; ++i) {
+            minBound[i] = std::min(minBound[i], positions[index][i]);
+            maxBound[i] = std::max(maxBound[i], positions[index][i]);
+        }
+    }
+
+    auto const extent = Subtract(maxBound, minBound);
+    auto const attributeScale = Dot(extent, extent);
+
+    std::vector<std::uint32_t> remap(vertexCount);
+    std::vector<bool> touched(vertexCount);
+
+    std::vector<std::uint32_t> adjacencyOffsets(vertexCount + 1), adjacency;
+
+    std::vector<collapse_t> collapses;
+
+    auto error = 0.f;
+
+    while (std::size(indices) > targetIndexCount) {
+        collapses.clear();
+
+        for (std::size_t i = 0; i < std::size(indices); i += 3) {
+            for (std::size_t j = 0; j < 3; ++j) {
+                auto const source = indices[i + j], target = indices[i + (j + 1) % 3];
+
+                for (auto [a, b] : make_array(std::make_pair(source, target), std::make_pair(target, source))) {
+                    if (locked[a] || a == b)
+                        continue;
+
+                    // Border vertices may only slide along the border.
+                    if (border[a] && !is_border_edge(a, b))
+                        continue;
+
+                    Quadric quadric = quadrics[wedges[a]];
+                    quadric += quadrics[wedges[b]];
+
+                    auto const geometricError = static_cast<float>(quadric.Error(positions[b]));
+
+                    auto cost = geometricError;
+
+                    if (!std::empty(normals))
+                        cost += kNORMAL_WEIGHT * attributeScale * SquaredDistance(normals[a], normals[b]);
+
+                    if (!std::empty(texCoords))
+                        cost += kTEX_COORD_WEIGHT * attributeScale * SquaredDistance(texCoords[a], texCoords[b]);
+
+                    collapses.push_back(collapse_t{a, b, cost, geometricError});
+                }
+            }
+        }
+
+        if (std::empty(collapses))
+            break;
+
+        std::sort(std::begin(collapses), std::end(collapses), [] (auto &&lhs, auto &&rhs)
+        {
+            return lhs.cost < rhs.cost;
+        });
+
+        // Vertex to triangles adjacency of the current triangle list.
+        std::fill(std::begin(adjacencyOffsets), std::end(adjacencyOffsets), 0);
+
+        for (auto index : indices)
+            ++adjacencyOffsets[index + 1];
+
+        std::partial_sum(std::cbegin(adjacencyOffsets), std::cend(adjacencyOffsets), std::begin(adjacencyOffsets));
+
+        adjacency.resize(std::size(indices));
+
+        {
+            auto offsets = adjacencyOffsets;
+
+            for (std::size_t i = 0; i < std::size(indices); ++i)
+                adjacency[offsets[indices[i]]++] = static_cast<std::uint32_t>(i / 3);
+        }
+
+        std::iota(std::begin(remap), std::end(remap), 0);
+        std::fill(std::begin(touched), std::end(touched), false);
+
+        auto const trianglesToRemove = (std::size(indices) - targetIndexCount) / 3;
+        std::size_t removedTriangles = 0;
+
+        for (auto &&[source, target, cost, geometricError] : collapses) {
+            if (touched[source] || touched[target])
+                continue;
+
+            auto flipped = false;
+            std::size_t collapsedTriangles = 0;
+
+            for (auto i = adjacencyOffsets[source]; i < adjacencyOffsets[source + 1] && !flipped; ++i) {
+                auto const triangle = &indices[adjacency[i] * 3];
+
+                if (std::find(triangle, triangle + 3, target) != triangle + 3) {
+                    ++collapsedTriangles;
+                    continue;
+                }
+
+                auto const &p0 = positions[triangle[0]], &p1 = positions[triangle[1]], &p2 = positions[triangle[2]];
+
+                auto const before = Cross(Subtract(p1, p0), Subtract(p2, p0));
+
+                auto const &q0 = positions[triangle[0] == source ? target : triangle[0]];
+                auto const &q1 = positions[triangle[1] == source ? target : triangle[1]];
+                auto const &q2 = positions[triangle[2] == source ? target : triangle[2]];
+
+                auto const after = Cross(Subtract(q1, q0), Subtract(q2, q0));
+
+                flipped = Dot(before, after) <= 0.f;
+            }
+
+            if (flipped)
+                continue;
+
+            remap[source] = target;
+            quadrics[wedges[target]] += quadrics[wedges[source]];
+
+            error = std::max(error, geometricError);
+
+            // Neighbours can't be collapsed during the same pass as their triangles have been changed.
+            for (auto i = adjacencyOffsets[source]; i < adjacencyOffsets[source + 1]; ++i) {
+                auto const triangle = &indices[adjacency[i] * 3];
+
+                for (std::size_t j = 0; j < 3; ++j)
+                    touched[triangle[j]] = true;
+            }
+
+            removedTriangles += collapsedTriangles;
+
+            if (removedTriangles >= trianglesToRemove)
+                break;
+        }
+
+        if (removedTriangles == 0)
+            break;
+
+        std::size_t writtenIndices = 0;
+
+        for (std::size_t i = 0; i < std::size(indices); i += 3) {
+            auto const a = remap[indices[i + 0]], b = remap[indices[i + 1]], c = remap[indices[i + 2]];
+
+            if (a == b || b == c || c == a)
+                continue;
+
+            indices[writtenIndices++] = a;
+            indices[writtenIndices++] = b;
+            indices[writtenIndices++] = c;
+        }
+
+        indices.resize(writtenIndices);
+    }
+
+    return std::sqrt(error);
+}
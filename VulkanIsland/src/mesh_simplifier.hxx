@@ -0,0 +1,18 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "mesh.hxx"
+
+
+// Simplifies the triangle list down to 'targetIndexCount' indices (if possible) by quadric error metric
+// driven edge collapses. Vertices only collapse into the existing ones, so the result references the same
+// vertex buffer. Normal and texture coordinate differences are added to the collapse costs,
+// border edges are preserved by the border quadrics and attribute seams are locked.
+// Returns the geometric error in object space units, the root of the area weighted mean squared distance
+// of the collapsed vertices to the planes of the original triangles.
+[[nodiscard]] float
+SimplifyMesh(std::vector<std::uint32_t> &indices, std::byte const *vertices, std::size_t vertexCount, vertex_layout_t const &layout,
+             std::size_t targetIndexCount);
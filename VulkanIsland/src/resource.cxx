@@ -59,21 +59,29 @@ ResourceManager::CreateImageView(VulkanImage const &image, VkImageViewType type,
 
 std::shared_ptr<VulkanSampler>
 ResourceManager::CreateImageSampler(std::uint32_t mipLevels) noexcept
+{
+    return CreateImageSampler(VK_FILTER_LINEAR, VK_FILTER_LINEAR, VK_SAMPLER_MIPMAP_MODE_LINEAR,
+                              VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, static_cast<float>(mipLevels));
+}
+
+std::shared_ptr<VulkanSampler>
+ResourceManager::CreateImageSampler(VkFilter minFilter, VkFilter magFilter, VkSamplerMipmapMode mipmapMode,
+                                    VkSamplerAddressMode addressModeU, VkSamplerAddressMode addressModeV, float maxLod) noexcept
 {
     std::shared_ptr<VulkanSampler> sampler;
 
     VkSamplerCreateInfo const createInfo{
         VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
         nullptr, 0,
-        VK_FILTER_LINEAR, VK_FILTER_LINEAR,
-        VK_SAMPLER_MIPMAP_MODE_LINEAR,
-        VK_SAMPLER_ADDRESS_MODE_REPEAT,
-        VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        magFilter, minFilter,
+        mipmapMode,
+        addressModeU,
+        addressModeV,
         VK_SAMPLER_ADDRESS_MODE_REPEAT,
         0.f,
         VK_TRUE, 16.f,
         VK_FALSE, VK_COMPARE_OP_ALWAYS,
-        0.f, static_cast<float>(mipLevels),
+        0.f, maxLod,
         VK_BORDER_COLOR_INT_OPAQUE_BLACK,
         VK_FALSE
     };
@@ -27,6 +27,10 @@ public:
     [[nodiscard]] std::shared_ptr<VulkanSampler>
     CreateImageSampler(std::uint32_t mipLevels) noexcept;
 
+    [[nodiscard]] std::shared_ptr<VulkanSampler>
+    CreateImageSampler(VkFilter minFilter, VkFilter magFilter, VkSamplerMipmapMode mipmapMode,
+                       VkSamplerAddressMode addressModeU, VkSamplerAddressMode addressModeV, float maxLod) noexcept;
+
     [[nodiscard]] std::shared_ptr<VulkanBuffer>
     CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties) noexcept;
 
@@ -0,0 +1,694 @@
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+#ifdef _MSC_VER
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "scene_cache.hxx"
+
+namespace {
+auto constexpr kCOOKED_SCENE_MAGIC = 0x53434956u;   // 'VICS'
+auto constexpr kCOOKED_SCENE_VERSION = 10u;
+
+auto constexpr kHASH_PRIME = 1099511628211ull;
+
+// Read only file memory mapping.
+class MappedFile final {
+public:
+
+    explicit MappedFile(fs::path const &path)
+    {
+#ifdef _MSC_VER
+        file_ = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+        if (file_ == INVALID_HANDLE_VALUE)
+            return;
+
+        if (LARGE_INTEGER size; GetFileSizeEx(file_, &size) && size.QuadPart > 0)
+            size_ = static_cast<std::size_t>(size.QuadPart);
+
+        else return;
+
+        if (mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr); mapping_ == nullptr)
+            return;
+
+        data_ = static_cast<std::byte const *>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+#else
+        if (file_ = open(path.c_str(), O_RDONLY); file_ == -1)
+            return;
+
+        if (struct stat status; fstat(file_, &status) == 0 && status.st_size > 0)
+            size_ = static_cast<std::size_t>(status.st_size);
+
+        else return;
+
+        if (auto data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file_, 0); data != MAP_FAILED)
+            data_ = static_cast<std::byte const *>(data);
+#endif
+    }
+
+    ~MappedFile()
+    {
+#ifdef _MSC_VER
+        if (data_ != nullptr)
+            UnmapViewOfFile(data_);
+
+        if (mapping_ != nullptr)
+            CloseHandle(mapping_);
+
+        if (file_ != INVALID_HANDLE_VALUE)
+            CloseHandle(file_);
+#else
+        if (data_ != nullptr)
+            munmap(const_cast<std::byte *>(data_), size_);
+
+        if (file_ != -1)
+            close(file_);
+#endif
+    }
+
+    MappedFile(MappedFile const &) = delete;
+    MappedFile &operator= (MappedFile const &) = delete;
+
+    std::byte const *data() const noexcept { return data_; }
+    std::size_t size() const noexcept { return data_ != nullptr ? size_ : 0; }
+
+private:
+    std::byte const *data_{nullptr};
+    std::size_t size_{0};
+
+#ifdef _MSC_VER
+    HANDLE file_{INVALID_HANDLE_VALUE};
+    HANDLE mapping_{nullptr};
+#else
+    int file_{-1};
+#endif
+};
+
+class CookedSceneWriter final {
+public:
+
+    template<class T>
+    void Write(T const &value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "value has to be trivially copyable");
+
+        auto const bytes = reinterpret_cast<std::byte const *>(&value);
+        buffer_.insert(std::end(buffer_), bytes, bytes + sizeof(T));
+    }
+
+    template<class T>
+    void Write(std::vector<T> const &values)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "value has to be trivially copyable");
+
+        Write(static_cast<std::uint64_t>(std::size(values)));
+
+        auto const bytes = reinterpret_cast<std::byte const *>(std::data(values));
+        buffer_.insert(std::end(buffer_), bytes, bytes + std::size(values) * sizeof(T));
+    }
+
+    void Write(std::string const &string)
+    {
+        Write(static_cast<std::uint64_t>(std::size(string)));
+
+        auto const bytes = reinterpret_cast<std::byte const *>(std::data(string));
+        buffer_.insert(std::end(buffer_), bytes, bytes + std::size(string));
+    }
+
+    std::vector<std::byte> const &buffer() const noexcept { return buffer_; }
+
+private:
+    std::vector<std::byte> buffer_;
+};
+
+// Bounds checked reading from the mapped cooked scene.
+class CookedSceneReader final {
+public:
+
+    CookedSceneReader(std::byte const *data, std::size_t size) noexcept : data_{data}, size_{size} { }
+
+    template<class T>
+    [[nodiscard]] bool Read(T &value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "value has to be trivially copyable");
+
+        return ReadBytes(&value, sizeof(T));
+    }
+
+    template<class T>
+    [[nodiscard]] bool Read(std::vector<T> &values)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "value has to be trivially copyable");
+
+        std::uint64_t count = 0;
+
+        if (!Read(count) || count > (size_ - offset_) / sizeof(T))
+            return false;
+
+        values.resize(static_cast<std::size_t>(count));
+
+        return ReadBytes(std::data(values), std::size(values) * sizeof(T));
+    }
+
+    [[nodiscard]] bool Read(std::string &string)
+    {
+        std::uint64_t length = 0;
+
+        if (!Read(length) || length > size_ - offset_)
+            return false;
+
+        string.resize(static_cast<std::size_t>(length));
+
+        return ReadBytes(std::data(string), std::size(string));
+    }
+
+private:
+    std::byte const *data_;
+    std::size_t size_;
+    std::size_t offset_{0};
+
+    bool ReadBytes(void *dst, std::size_t size)
+    {
+        if (size > size_ - offset_)
+            return false;
+
+        if (size != 0)
+            std::memcpy(dst, data_ + offset_, size);
+
+        offset_ += size;
+
+        return true;
+    }
+};
+
+bool ReadStreams(CookedSceneReader &reader, std::vector<vertex_stream_t> &vertexStreams)
+{
+    std::uint64_t streamsNumber = 0;
+
+    if (!reader.Read(streamsNumber))
+        return false;
+
+    for (std::uint64_t i = 0; i < streamsNumber; ++i) {
+        std::uint64_t formatIndex = 0, count = 0;
+
+        if (!reader.Read(formatIndex) || !reader.Read(count))
+            return false;
+
+        auto format = instantiate_vertex_format(static_cast<std::size_t>(formatIndex));
+
+        if (!format)
+            return false;
+
+        vertex_stream_t stream;
+
+        stream.layout = make_vertex_layout(*format);
+        stream.count = static_cast<std::size_t>(count);
+
+        if (!reader.Read(stream.buffer) || !reader.Read(stream.primitives))
+            return false;
+
+        if (std::size(stream.buffer) != stream.count * stream.layout.stride)
+            return false;
+
+        vertexStreams.push_back(std::move(stream));
+    }
+
+    return true;
+}
+
+bool ReadStrings(CookedSceneReader &reader, std::vector<std::string> &strings)
+{
+    std::uint64_t stringsNumber = 0;
+
+    if (!reader.Read(stringsNumber))
+        return false;
+
+    for (std::uint64_t i = 0; i < stringsNumber; ++i) {
+        if (std::string string; reader.Read(string))
+            strings.push_back(std::move(string));
+
+        else return false;
+    }
+
+    return true;
+}
+
+bool ReadNodes(CookedSceneReader &reader, std::vector<scene_node_t> &nodes)
+{
+    std::uint64_t nodesNumber = 0;
+
+    if (!reader.Read(nodesNumber))
+        return false;
+
+    for (std::uint64_t i = 0; i < nodesNumber; ++i) {
+        scene_node_t node;
+        std::array<float, 16> localMatrix;
+        std::array<float, 3> translation, scale;
+        std::array<float, 4> rotation;
+        std::uint8_t posed;
+
+        if (!reader.Read(node.name) || !reader.Read(node.parent) || !reader.Read(localMatrix) || !reader.Read(translation) ||
+            !reader.Read(rotation) || !reader.Read(scale) || !reader.Read(posed) || !reader.Read(node.mesh) || !reader.Read(node.skin))
+            return false;
+
+        node.posed = posed != 0;
+
+        node.localMatrix = glm::make_mat4(std::data(localMatrix));
+
+        node.translation = glm::vec3{translation[0], translation[1], translation[2]};
+        node.rotation = glm::quat{rotation[3], rotation[0], rotation[1], rotation[2]};
+        node.scale = glm::vec3{scale[0], scale[1], scale[2]};
+
+        if (node.parent >= static_cast<std::int32_t>(std::size(nodes)))
+            return false;
+
+        nodes.push_back(std::move(node));
+    }
+
+    return true;
+}
+
+bool ReadSkins(CookedSceneReader &reader, std::vector<scene_skin_t> &skins)
+{
+    std::uint64_t skinsNumber = 0;
+
+    if (!reader.Read(skinsNumber))
+        return false;
+
+    for (std::uint64_t i = 0; i < skinsNumber; ++i) {
+        scene_skin_t skin;
+        std::vector<std::array<float, 16>> inverseBindMatrices;
+
+        if (!reader.Read(skin.joints) || !reader.Read(inverseBindMatrices) || std::size(inverseBindMatrices) != std::size(skin.joints))
+            return false;
+
+        std::transform(std::cbegin(inverseBindMatrices), std::cend(inverseBindMatrices), std::back_inserter(skin.inverseBindMatrices), [] (auto &&matrix)
+        {
+            return glm::make_mat4(std::data(matrix));
+        });
+
+        skins.push_back(std::move(skin));
+    }
+
+    return true;
+}
+
+bool ReadAnimations(CookedSceneReader &reader, std::vector<scene_animation_t> &animations)
+{
+    std::uint64_t animationsNumber = 0;
+
+    if (!reader.Read(animationsNumber))
+        return false;
+
+    for (std::uint64_t i = 0; i < animationsNumber; ++i) {
+        scene_animation_t animation;
+        std::uint64_t samplersNumber = 0;
+
+        if (!reader.Read(animation.name) || !reader.Read(animation.duration) || !reader.Read(samplersNumber))
+            return false;
+
+        for (std::uint64_t j = 0; j < samplersNumber; ++j) {
+            auto &&sampler = animation.samplers.emplace_back();
+
+            if (!reader.Read(sampler.times) || !reader.Read(sampler.values) || !reader.Read(sampler.components) || !reader.Read(sampler.interpolation))
+                return false;
+        }
+
+        if (!reader.Read(animation.channels))
+            return false;
+
+        auto const valid = std::all_of(std::cbegin(animation.channels), std::cend(animation.channels), [&animation] (auto &&channel)
+        {
+            return channel.sampler < std::size(animation.samplers);
+        });
+
+        if (!valid)
+            return false;
+
+        animations.push_back(std::move(animation));
+    }
+
+    return true;
+}
+
+// Index range lies within the index buffer and refers to the 'vertexCount' primitive vertices only.
+template<class T>
+bool IsIndexRangeValid(std::vector<T> const &indices, std::uint32_t firstIndex, std::uint32_t indexCount, std::uint64_t vertexCount)
+{
+    if (std::uint64_t{firstIndex} + indexCount > std::size(indices))
+        return false;
+
+    auto const begin = std::next(std::cbegin(indices), firstIndex);
+
+    return std::all_of(begin, std::next(begin, indexCount), [vertexCount] (auto index) { return index < vertexCount; });
+}
+
+bool IsPrimitiveValid(scene_data_t const &scene, primitive_range_t const &primitive, std::uint64_t vertexCount)
+{
+    auto const isIndexRangeValid = [&scene, &primitive, vertexCount] (std::uint32_t firstIndex, std::uint32_t indexCount)
+    {
+        if (primitive.indexType == VK_INDEX_TYPE_UINT16)
+            return IsIndexRangeValid(scene.indices16, firstIndex, indexCount, vertexCount);
+
+        return primitive.indexType == VK_INDEX_TYPE_UINT32 && IsIndexRangeValid(scene.indices32, firstIndex, indexCount, vertexCount);
+    };
+
+    if (!isIndexRangeValid(primitive.firstIndex, primitive.indexCount))
+        return false;
+
+    if (std::uint64_t{primitive.firstMeshlet} + primitive.meshletCount > std::size(scene.meshlets))
+        return false;
+
+    if (std::uint64_t{primitive.firstLevelOfDetail} + primitive.levelOfDetailCount > std::size(scene.levelsOfDetail))
+        return false;
+
+    auto const meshlets = std::next(std::cbegin(scene.meshlets), primitive.firstMeshlet);
+
+    auto valid = std::all_of(meshlets, std::next(meshlets, primitive.meshletCount), [&isIndexRangeValid] (auto &&meshlet)
+    {
+        return isIndexRangeValid(meshlet.firstIndex, meshlet.indexCount);
+    });
+
+    auto const levels = std::next(std::cbegin(scene.levelsOfDetail), primitive.firstLevelOfDetail);
+
+    return valid && std::all_of(levels, std::next(levels, primitive.levelOfDetailCount), [&isIndexRangeValid] (auto &&level)
+    {
+        return isIndexRangeValid(level.firstIndex, level.indexCount);
+    });
+}
+
+bool IsTextureIndexValid(std::int32_t index, std::size_t texturesNumber)
+{
+    return index == -1 || (index >= 0 && static_cast<std::size_t>(index) < texturesNumber);
+}
+
+// The content hash only covers the sources of the cooked scene, so the references between its parts
+// are checked before the scene is handed over to the renderer which uses them as is.
+bool IsCookedSceneValid(scene_data_t const &scene)
+{
+    for (auto &&stream : scene.vertexStreams) {
+        auto &&primitives = stream.primitives;
+
+        // Primitive vertices are laid out one after another, each one ends where the next one begins.
+        for (std::size_t i = 0; i < std::size(primitives); ++i) {
+            auto const vertexOffset = primitives[i].vertexOffset;
+            auto const vertexEnd = i + 1 < std::size(primitives) ? std::int64_t{primitives[i + 1].vertexOffset} : static_cast<std::int64_t>(stream.count);
+
+            if (vertexOffset < 0 || vertexEnd < vertexOffset || vertexEnd > static_cast<std::int64_t>(stream.count))
+                return false;
+
+            if (!IsPrimitiveValid(scene, primitives[i], static_cast<std::uint64_t>(vertexEnd - vertexOffset)))
+                return false;
+        }
+    }
+
+    auto const nodesNumber = std::size(scene.nodes);
+
+    for (auto &&node : scene.nodes)
+        if (node.skin < -1 || node.skin >= static_cast<std::int64_t>(std::size(scene.skins)))
+            return false;
+
+    for (auto &&skin : scene.skins)
+        if (std::any_of(std::cbegin(skin.joints), std::cend(skin.joints), [nodesNumber] (auto joint) { return joint >= nodesNumber; }))
+            return false;
+
+    for (auto &&animation : scene.animations) {
+        for (auto &&sampler : animation.samplers) {
+            if (sampler.components != 3 && sampler.components != 4)
+                return false;
+
+            auto const valuesPerKey = sampler.components * (sampler.interpolation == eINTERPOLATION::nCUBIC_SPLINE ? 3u : 1u);
+
+            if (std::size(sampler.values) < std::size(sampler.times) * valuesPerKey)
+                return false;
+        }
+
+        if (std::any_of(std::cbegin(animation.channels), std::cend(animation.channels), [nodesNumber] (auto &&channel) { return channel.node >= nodesNumber; }))
+            return false;
+    }
+
+    if (std::any_of(std::cbegin(scene.instances), std::cend(scene.instances), [nodesNumber] (auto node) { return node >= nodesNumber; }))
+        return false;
+
+    for (auto &&command : scene.drawCommands) {
+        if (command.streamIndex >= std::size(scene.vertexStreams))
+            return false;
+
+        auto &&primitives = scene.vertexStreams[command.streamIndex].primitives;
+
+        if (command.primitiveIndex >= std::size(primitives))
+            return false;
+
+        // Draw commands replicate the index range of their primitive.
+        auto &&primitive = primitives[command.primitiveIndex];
+
+        if (command.indexType != primitive.indexType || command.firstIndex != primitive.firstIndex ||
+            command.indexCount != primitive.indexCount || command.vertexOffset != primitive.vertexOffset)
+            return false;
+
+        if (command.materialIndex < -1 || command.materialIndex >= static_cast<std::int64_t>(std::size(scene.materials)))
+            return false;
+
+        if (std::uint64_t{command.firstInstance} + command.instanceCount > std::size(scene.instances))
+            return false;
+    }
+
+    for (auto &&texture : scene.textures) {
+        if (texture.image < -1 || texture.image >= static_cast<std::int64_t>(std::size(scene.images)))
+            return false;
+
+        if (texture.sampler >= std::size(scene.samplers))
+            return false;
+    }
+
+    auto const texturesNumber = std::size(scene.textures);
+
+    return std::all_of(std::cbegin(scene.materials), std::cend(scene.materials), [texturesNumber] (auto &&material)
+    {
+        return IsTextureIndexValid(material.baseColorTexture, texturesNumber) && IsTextureIndexValid(material.metallicRoughnessTexture, texturesNumber) &&
+               IsTextureIndexValid(material.normalTexture, texturesNumber) && IsTextureIndexValid(material.occlusionTexture, texturesNumber) &&
+               IsTextureIndexValid(material.emissiveTexture, texturesNumber);
+    });
+}
+}
+
+
+std::uint64_t HashBytes(void const *data, std::size_t size, std::uint64_t seed)
+{
+    auto hash = seed;
+
+    auto const bytes = static_cast<std::uint8_t const *>(data);
+
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= kHASH_PRIME;
+    }
+
+    return hash;
+}
+
+std::optional<std::uint64_t>
+HashBufferFiles(fs::path const &folder, std::vector<std::string> const &bufferURIs, std::uint64_t sourceHash)
+{
+    auto hash = sourceHash;
+
+    for (auto &&uri : bufferURIs) {
+        MappedFile const file{folder / fs::path{uri}};
+
+        if (file.data() == nullptr)
+            return { };
+
+        hash = HashBytes(file.data(), file.size(), hash);
+    }
+
+    return hash;
+}
+
+bool LoadCookedScene(fs::path const &path, fs::path const &folder, std::uint64_t sourceHash, scene_data_t &sceneData)
+{
+    if (!fs::exists(path))
+        return false;
+
+    MappedFile const file{path};
+
+    if (file.data() == nullptr) {
+        std::cerr << "failed to map cooked scene file: "s << path << '\n';
+        return false;
+    }
+
+    CookedSceneReader reader{file.data(), file.size()};
+
+    std::uint32_t magic = 0, version = 0;
+    std::uint64_t contentHash = 0;
+
+    if (!reader.Read(magic) || !reader.Read(version) || magic != kCOOKED_SCENE_MAGIC || version != kCOOKED_SCENE_VERSION)
+        return false;
+
+    std::vector<std::string> bufferURIs;
+
+    if (!reader.Read(contentHash) || !ReadStrings(reader, bufferURIs))
+        return false;
+
+    // The scene has been changed since it was cooked.
+    if (auto hash = HashBufferFiles(folder, bufferURIs, sourceHash); !hash || *hash != contentHash)
+        return false;
+
+    scene_data_t cooked;
+
+    if (!ReadStreams(reader, cooked.vertexStreams) || !reader.Read(cooked.indices16) || !reader.Read(cooked.indices32) ||
+        !reader.Read(cooked.meshlets) || !reader.Read(cooked.levelsOfDetail) || !ReadNodes(reader, cooked.nodes) ||
+        !ReadSkins(reader, cooked.skins) || !ReadAnimations(reader, cooked.animations) ||
+        !reader.Read(cooked.instances) || !reader.Read(cooked.drawCommands) || !ReadStrings(reader, cooked.images) ||
+        !reader.Read(cooked.samplers) || !reader.Read(cooked.textures) || !reader.Read(cooked.materials) || !IsCookedSceneValid(cooked)) {
+        std::cerr << "cooked scene file is corrupted: "s << path << '\n';
+        return false;
+    }
+
+    sceneData = std::move(cooked);
+
+    return true;
+}
+
+bool SaveCookedScene(fs::path const &path, fs::path const &folder, std::uint64_t sourceHash, std::vector<std::string> const &bufferURIs,
+                     scene_data_t const &sceneData)
+{
+    auto const contentHash = HashBufferFiles(folder, bufferURIs, sourceHash);
+
+    if (!contentHash)
+        return false;
+
+    CookedSceneWriter writer;
+
+    writer.Write(kCOOKED_SCENE_MAGIC);
+    writer.Write(kCOOKED_SCENE_VERSION);
+    writer.Write(*contentHash);
+
+    writer.Write(static_cast<std::uint64_t>(std::size(bufferURIs)));
+
+    for (auto &&uri : bufferURIs)
+        writer.Write(uri);
+
+    writer.Write(static_cast<std::uint64_t>(std::size(sceneData.vertexStreams)));
+
+    for (auto &&stream : sceneData.vertexStreams) {
+        writer.Write(static_cast<std::uint64_t>(stream.layout.formatIndex));
+        writer.Write(static_cast<std::uint64_t>(stream.count));
+
+        writer.Write(stream.buffer);
+        writer.Write(stream.primitives);
+    }
+
+    writer.Write(sceneData.indices16);
+    writer.Write(sceneData.indices32);
+
+    writer.Write(sceneData.meshlets);
+    writer.Write(sceneData.levelsOfDetail);
+
+    writer.Write(static_cast<std::uint64_t>(std::size(sceneData.nodes)));
+
+    for (auto &&node : sceneData.nodes) {
+        std::array<float, 16> localMatrix;
+        std::memcpy(std::data(localMatrix), glm::value_ptr(node.localMatrix), sizeof(localMatrix));
+
+        writer.Write(node.name);
+        writer.Write(node.parent);
+        writer.Write(localMatrix);
+        writer.Write(std::array<float, 3>{node.translation.x, node.translation.y, node.translation.z});
+        writer.Write(std::array<float, 4>{node.rotation.x, node.rotation.y, node.rotation.z, node.rotation.w});
+        writer.Write(std::array<float, 3>{node.scale.x, node.scale.y, node.scale.z});
+        writer.Write(static_cast<std::uint8_t>(node.posed ? 1 : 0));
+        writer.Write(node.mesh);
+        writer.Write(node.skin);
+    }
+
+    writer.Write(static_cast<std::uint64_t>(std::size(sceneData.skins)));
+
+    for (auto &&skin : sceneData.skins) {
+        std::vector<std::array<float, 16>> inverseBindMatrices(std::size(skin.inverseBindMatrices));
+
+        for (std::size_t i = 0; i < std::size(inverseBindMatrices); ++i)
+            std::memcpy(std::data(inverseBindMatrices[i]), glm::value_ptr(skin.inverseBindMatrices[i]), sizeof(inverseBindMatrices[i]));
+
+        writer.Write(skin.joints);
+        writer.Write(inverseBindMatrices);
+    }
+
+    writer.Write(static_cast<std::uint64_t>(std::size(sceneData.animations)));
+
+    for (auto &&animation : sceneData.animations) {
+        writer.Write(animation.name);
+        writer.Write(animation.duration);
+
+        writer.Write(static_cast<std::uint64_t>(std::size(animation.samplers)));
+
+        for (auto &&sampler : animation.samplers) {
+            writer.Write(sampler.times);
+            writer.Write(sampler.values);
+            writer.Write(sampler.components);
+            writer.Write(sampler.interpolation);
+        }
+
+        writer.Write(animation.channels);
+    }
+
+    writer.Write(sceneData.instances);
+    writer.Write(sceneData.drawCommands);
+
+    writer.Write(static_cast<std::uint64_t>(std::size(sceneData.images)));
+
+    for (auto &&image : sceneData.images)
+        writer.Write(image);
+
+    writer.Write(sceneData.samplers);
+    writer.Write(sceneData.textures);
+    writer.Write(sceneData.materials);
+
+    std::ofstream file(path.native(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+    if (!file.is_open())
+        return false;
+
+    auto &&buffer = writer.buffer();
+
+    file.write(reinterpret_cast<char const *>(std::data(buffer)), static_cast<std::streamsize>(std::size(buffer)));
+
+    return file.good();
+}
+
+bool LoadSceneTreeSnapshot(fs::path const &path, SceneTree &sceneTree)
+{
+    if (!fs::exists(path))
+        return false;
+
+    MappedFile const file{path};
+
+    if (file.data() == nullptr) {
+        std::cerr << "failed to map scene tree snapshot file: "s << path << '\n';
+        return false;
+    }
+
+    return sceneTree.RestoreSnapshot(file.data(), file.size());
+}
+
+bool SaveSceneTreeSnapshot(fs::path const &path, SceneTree const &sceneTree)
+{
+    auto const snapshot = sceneTree.SaveSnapshot();
+
+    std::ofstream file(path.native(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+    if (!file.is_open())
+        return false;
+
+    file.write(reinterpret_cast<char const *>(std::data(snapshot)), static_cast<std::streamsize>(std::size(snapshot)));
+
+    return file.good();
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "main.hxx"
+#include "glTFLoader.hxx"
+#include "scene_tree.hxx"
+
+
+auto constexpr kHASH_OFFSET_BASIS = 14695981039346656037ull;
+
+// 64-bit FNV-1a hash, 'seed' allows to chain hashes of several data blocks.
+[[nodiscard]] std::uint64_t
+HashBytes(void const *data, std::size_t size, std::uint64_t seed = kHASH_OFFSET_BASIS);
+
+// Cooked scene content hash is the 'sourceHash' chained with the contents of the scene buffer files.
+[[nodiscard]] std::optional<std::uint64_t>
+HashBufferFiles(fs::path const &folder, std::vector<std::string> const &bufferURIs, std::uint64_t sourceHash);
+
+// Memory maps the cooked scene and reads it if it was cooked from the same sources,
+// the buffer files listed in the cooked scene are looked for in the 'folder'.
+[[nodiscard]] bool
+LoadCookedScene(fs::path const &path, fs::path const &folder, std::uint64_t sourceHash, scene_data_t &sceneData);
+
+[[nodiscard]] bool
+SaveCookedScene(fs::path const &path, fs::path const &folder, std::uint64_t sourceHash, std::vector<std::string> const &bufferURIs,
+                scene_data_t const &sceneData);
+
+// Scene tree snapshots allow to reload a level or to hand the scene over to another process without rebuilding the hierarchy.
+[[nodiscard]] bool
+LoadSceneTreeSnapshot(fs::path const &path, SceneTree &sceneTree);
+
+[[nodiscard]] bool
+SaveSceneTreeSnapshot(fs::path const &path, SceneTree const &sceneTree);
@@ -0,0 +1,119 @@
+#include <algorithm>
+
+#include "scene_streamer.hxx"
+
+
+SceneStreamer::SceneStreamer(std::string_view name, glTF::import_options_t const &options, std::size_t workersNumber)
+    : workersNumber_{workersNumber != 0 ? workersNumber : std::max(std::thread::hardware_concurrency(), 1u)}
+{
+    loader_ = std::thread([this, name = std::string{name}, options]
+    {
+        scene_data_t scene;
+
+        if (!glTF::LoadScene(name, scene, options)) {
+            state_ = state::failed;
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+
+            images_ = scene.images;
+
+            imagePriorities_.assign(std::size(images_), 0.f);
+            imagesTaken_.assign(std::size(images_), false);
+        }
+
+        scene_ = std::move(scene);
+        state_ = state::loaded;
+
+        auto const workersNumber = std::min(workersNumber_, std::size(images_));
+
+        for (std::size_t i = 0; i < workersNumber; ++i)
+            workers_.emplace_back(&SceneStreamer::DecodeImages, this);
+    });
+}
+
+SceneStreamer::~SceneStreamer()
+{
+    stop_ = true;
+
+    if (loader_.joinable())
+        loader_.join();
+
+    for (auto &&worker : workers_)
+        worker.join();
+}
+
+std::optional<scene_data_t> SceneStreamer::TakeScene()
+{
+    if (state_ != state::loaded)
+        return { };
+
+    state_ = state::taken;
+
+    return std::move(scene_);
+}
+
+void SceneStreamer::PrioritizeImages(std::vector<float> priorities)
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+
+    if (std::size(priorities) == std::size(imagePriorities_))
+        imagePriorities_ = std::move(priorities);
+}
+
+std::vector<std::pair<std::size_t, std::optional<RawImage>>> SceneStreamer::TakeDecodedImages()
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+
+    imagesReturned_ += std::size(decodedImages_);
+
+    return std::move(decodedImages_);
+}
+
+bool SceneStreamer::finished() const
+{
+    if (state_ == state::failed)
+        return true;
+
+    if (state_ != state::taken)
+        return false;
+
+    std::lock_guard<std::mutex> lock{mutex_};
+
+    return imagesReturned_ == std::size(images_);
+}
+
+void SceneStreamer::DecodeImages()
+{
+    while (!stop_) {
+        std::size_t index = 0;
+
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+
+            auto best = std::numeric_limits<float>::max();
+            auto found = false;
+
+            for (std::size_t i = 0; i < std::size(images_); ++i) {
+                if (!imagesTaken_[i] && (!found || imagePriorities_[i] < best)) {
+                    best = imagePriorities_[i];
+                    index = i;
+                    found = true;
+                }
+            }
+
+            if (!found)
+                return;
+
+            imagesTaken_[index] = true;
+        }
+
+        auto image = LoadTARGA(images_[index]);
+
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        decodedImages_.emplace_back(index, std::move(image));
+    }
+}
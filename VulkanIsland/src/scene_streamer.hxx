@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "main.hxx"
+#include "glTFLoader.hxx"
+#include "TARGA_loader.hxx"
+
+
+// Loads the scene on a background thread and then decodes its images on a pool of worker threads.
+// The images are decoded in the order of their priorities, which may be changed while the decoding goes on.
+class SceneStreamer final {
+public:
+
+    SceneStreamer(std::string_view name, glTF::import_options_t const &options, std::size_t workersNumber = 0);
+    ~SceneStreamer();
+
+    SceneStreamer(SceneStreamer const &) = delete;
+    SceneStreamer &operator= (SceneStreamer const &) = delete;
+
+    // The loaded scene is returned once, the image decoding starts right after the scene has been loaded.
+    [[nodiscard]] std::optional<scene_data_t> TakeScene();
+
+    bool failed() const noexcept { return state_ == state::failed; }
+
+    // Images with lower values are decoded first, the priorities are indexed as the scene images.
+    void PrioritizeImages(std::vector<float> priorities);
+
+    // Images decoded since the previous call along with their scene image indices, images failed to decode are empty.
+    [[nodiscard]] std::vector<std::pair<std::size_t, std::optional<RawImage>>> TakeDecodedImages();
+
+    // All the images have been decoded and taken.
+    bool finished() const;
+
+private:
+
+    enum class state {
+        loading, loaded, taken, failed
+    };
+
+    std::atomic<state> state_{state::loading};
+
+    std::size_t workersNumber_;
+
+    scene_data_t scene_;
+
+    mutable std::mutex mutex_;
+
+    std::vector<std::string> images_;
+    std::vector<float> imagePriorities_;
+    std::vector<bool> imagesTaken_;
+
+    std::size_t imagesReturned_{0};
+    std::vector<std::pair<std::size_t, std::optional<RawImage>>> decodedImages_;
+
+    std::atomic<bool> stop_{false};
+
+    std::thread loader_;
+    std::vector<std::thread> workers_;
+
+    void DecodeImages();
+};
@@ -1,10 +1,104 @@
-#ifdef _MSC_VER
-#define USE_EXECUTION_POLICIES
-#include <execution>
-#endif
+#include <algorithm>
+#include <cstring>
+#include <numeric>
 
 #include "scene_tree.hxx"
 
+namespace {
+// Number of nodes updated by a single job.
+auto constexpr kUPDATE_CHUNK_SIZE = std::size_t{256};
+
+auto constexpr kNAME_HASH_OFFSET_BASIS = 14695981039346656037ull;
+auto constexpr kNAME_HASH_PRIME = 1099511628211ull;
+
+// 64-bit FNV-1a, a path hashed piece by piece chaining the seeds has the same hash as the whole path.
+std::uint64_t HashName(std::string_view name, std::uint64_t seed = kNAME_HASH_OFFSET_BASIS) noexcept
+{
+    auto hash = seed;
+
+    for (auto c : name) {
+        hash ^= static_cast<std::uint8_t>(c);
+        hash *= kNAME_HASH_PRIME;
+    }
+
+    return hash;
+}
+
+auto constexpr kSNAPSHOT_MAGIC = 0x54534956u;   // 'VIST'
+auto constexpr kSNAPSHOT_VERSION = 3u;
+
+struct snapshot_header_t final {
+    std::uint32_t magic{kSNAPSHOT_MAGIC};
+    std::uint32_t version{kSNAPSHOT_VERSION};
+
+    // The nodes are stored as they are, so snapshots are only exchanged between the same builds.
+    std::uint32_t nodeSize{sizeof(Node)};
+    std::uint32_t matrixSize{sizeof(glm::mat4)};
+    std::uint32_t poseSize{sizeof(node_pose_t)};
+    std::uint32_t lookupSize{0};
+
+    std::uint64_t nodesNumber{0};
+    std::uint64_t freeNodesNumber{0};
+    std::uint64_t namesTableSize{0};
+    std::uint64_t layersNumber{0};
+
+    // Slots of the names interning table and of the name and path lookup tables.
+    std::uint64_t internedNamesSlotsNumber{0};
+    std::uint64_t nameIndexSlotsNumber{0};
+    std::uint64_t pathIndexSlotsNumber{0};
+};
+
+void AppendBytes(std::vector<std::byte> &buffer, void const *data, std::size_t size)
+{
+    auto const bytes = static_cast<std::byte const *>(data);
+    buffer.insert(std::end(buffer), bytes, bytes + size);
+}
+
+// Bounds checked reading of the snapshot.
+class SnapshotReader final {
+public:
+
+    SnapshotReader(std::byte const *data, std::size_t size) noexcept : data_{data}, size_{size} { }
+
+    [[nodiscard]] bool ReadBytes(void *dst, std::size_t size) noexcept
+    {
+        if (size > size_ - offset_)
+            return false;
+
+        if (size != 0)
+            std::memcpy(dst, data_ + offset_, size);
+
+        offset_ += size;
+
+        return true;
+    }
+
+    template<class T>
+    [[nodiscard]] bool Read(T &value) noexcept
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "value has to be trivially copyable");
+
+        return ReadBytes(&value, sizeof(T));
+    }
+
+    // Bytes of 'count' elements of 'size' bytes each, these are left in place to be copied element-wise.
+    [[nodiscard]] std::byte const *Skip(std::uint64_t count, std::size_t size) noexcept
+    {
+        if (count > (size_ - offset_) / size)
+            return nullptr;
+
+        auto const data = data_ + offset_;
+        offset_ += static_cast<std::size_t>(count) * size;
+
+        return data;
+    }
+
+private:
+    std::byte const *data_;
+    std::size_t size_;
+    std::size_t offset_{0};
+};
+}
 
 
 
@@ -16,10 +110,7 @@ std::optional<NodeHandle> SceneTree::AttachNode(NodeHandle parentHandle, std::st
     if (!isNodeHandleValid(parentHandle))
         return { };
 
-    auto parentNode = nodes.at(static_cast<std::size_t>(parentHandle));
-
-    if (!isNodeValid(parentNode))
-        return { };
+    auto parentNode = nodes.at(NodeHandleIndex(parentHandle));
 
     auto &&parentInfo = layers.at(parentNode.depth).at(parentNode.offset);
     auto &&parentChildren = parentInfo.children;
@@ -32,23 +123,23 @@ std::optional<NodeHandle> SceneTree::AttachNode(NodeHandle parentHandle, std::st
         return { };
     }
 
-    if (std::size(layers) < childrenDepth + 1)
+    if (std::size(layers) < childrenDepth + 1) {
         layers.resize(childrenDepth + 1);
+        layersMatrices.resize(childrenDepth + 1);
+    }
 
     auto &&childrenLayer = layers.at(childrenDepth);
 
-    if (std::size(layersChunks) < childrenDepth + 1)
-        layersChunks.resize(childrenDepth + 1);
+    auto &&layerChunks = LayerChunks(childrenDepth);
 
-    auto &&layerChunks = layersChunks.at(childrenDepth);
+    auto const nameRange = StoreName(name);
 
     if (std::size(childrenLayer) == parentChildren.end) {
         auto index = parentChildren.end;
 
-        handle.emplace(static_cast<NodeHandle>(std::size(nodes)));
-        nodes.emplace_back(childrenDepth, index);
+        handle.emplace(AllocateNode(childrenDepth, index));
 
-        childrenLayer.emplace_back(parentHandle, *handle, entities->create(), name);
+        childrenLayer.emplace_back(parentHandle, *handle, entities->create(), nameRange);
 
         ++parentChildren.end;
     }
@@ -59,11 +150,9 @@ std::optional<NodeHandle> SceneTree::AttachNode(NodeHandle parentHandle, std::st
         if (it_chunk != std::end(layerChunks)) {
             auto index = *it_chunk;
 
-            handle.emplace(static_cast<NodeHandle>(std::size(nodes)));
-            nodes.emplace_back(childrenDepth, index);
+            handle.emplace(AllocateNode(childrenDepth, index));
 
-            auto it = std::next(std::begin(childrenLayer), index);
-            childrenLayer.emplace(it, parentHandle, *handle, entities->create(), name);
+            childrenLayer.at(index) = NodeInfo{parentHandle, *handle, entities->create(), nameRange};
 
             ++parentChildren.end;
 
@@ -114,14 +203,13 @@ std::optional<NodeHandle> SceneTree::AttachNode(NodeHandle parentHandle, std::st
 
             std::ptrdiff_t const offset = new_begin_index - parentChildren.begin;
 
-            handle.emplace(static_cast<NodeHandle>(std::size(nodes)));
-            nodes.emplace_back(childrenDepth, new_node_index);
+            handle.emplace(AllocateNode(childrenDepth, new_node_index));
 
             auto it_begin = std::next(std::begin(childrenLayer), parentChildren.begin);
             auto it_end = std::next(std::begin(childrenLayer), parentChildren.end);
 
             std::for_each(it_begin, it_end, [&nodes = nodes, offset] (auto &&nodeInfo) {
-                auto &&node = nodes.at(static_cast<std::size_t>(nodeInfo.handle));
+                auto &&node = nodes.at(NodeHandleIndex(nodeInfo.handle));
 
                 node.offset += offset;
             });
@@ -132,12 +220,34 @@ std::optional<NodeHandle> SceneTree::AttachNode(NodeHandle parentHandle, std::st
             std::vector<std::decay_t<decltype(layerChunks)>::value_type> newChunks(childrenCount);
             std::iota(std::begin(newChunks), std::end(newChunks), parentChildren.begin);
 
+            {
+                ResizeLayerMatrices(childrenDepth);
+
+                auto &&matrices = layersMatrices.at(childrenDepth);
+
+                for (auto matricesArray : {&matrices.localMatrices, &matrices.worldMatrices}) {
+                    auto it_matrices_begin = std::next(std::begin(*matricesArray), parentChildren.begin);
+                    auto it_matrices_end = std::next(std::begin(*matricesArray), parentChildren.end);
+
+                    std::copy(it_matrices_begin, it_matrices_end, std::next(std::begin(*matricesArray), new_begin_index));
+                }
+
+                std::copy_n(std::next(std::begin(matrices.localPoses), parentChildren.begin), childrenCount,
+                            std::next(std::begin(matrices.localPoses), new_begin_index));
+
+                std::copy_n(std::next(std::begin(matrices.posesDirty), parentChildren.begin), childrenCount,
+                            std::next(std::begin(matrices.posesDirty), new_begin_index));
+            }
+
             parentChildren.begin = new_begin_index;
             parentChildren.end = parentChildren.begin + requestedSize;
 
             std::move(it_begin, it_end, it_new_begin);
 
-            *std::prev(it_new_end) = NodeInfo{parentHandle, *handle, entities->create(), name};
+            // The vacated slots must not alias the moved nodes.
+            std::fill(it_begin, it_end, NodeInfo{ });
+
+            *std::prev(it_new_end) = NodeInfo{parentHandle, *handle, entities->create(), nameRange};
             //childrenLayer.emplace(it_new_end, parentHandle, *handle, entityX->entities.create(), name);
 
             layerChunks.insert(std::begin(newChunks), std::end(newChunks));
@@ -151,11 +261,9 @@ std::optional<NodeHandle> SceneTree::AttachNode(NodeHandle parentHandle, std::st
         if (it_chunk != std::end(layerChunks)) {
             auto index = *it_chunk;
 
-            handle.emplace(static_cast<NodeHandle>(std::size(nodes)));
-            nodes.emplace_back(childrenDepth, index);
+            handle.emplace(AllocateNode(childrenDepth, index));
 
-            auto it = std::next(std::begin(childrenLayer), index);
-            childrenLayer.emplace(it, parentHandle, *handle, entities->create(), name);
+            childrenLayer.at(index) = NodeInfo{parentHandle, *handle, entities->create(), nameRange};
 
             parentChildren.begin = index;
             parentChildren.end = parentChildren.begin + 1;
@@ -164,160 +272,1250 @@ std::optional<NodeHandle> SceneTree::AttachNode(NodeHandle parentHandle, std::st
         }
 
         else {
-            handle.emplace(static_cast<NodeHandle>(std::size(nodes)));
-            auto &&node = nodes.emplace_back(childrenDepth, std::size(childrenLayer));
-            childrenLayer.emplace_back(parentHandle, *handle, entities->create(), name);
+            auto const index = std::size(childrenLayer);
+
+            handle.emplace(AllocateNode(childrenDepth, index));
+            childrenLayer.emplace_back(parentHandle, *handle, entities->create(), nameRange);
 
-            parentChildren.begin = node.offset;
+            parentChildren.begin = index;
             parentChildren.end = parentChildren.begin + 1;
         }
     }
 
+    if (handle) {
+        auto const offset = nodes.at(NodeHandleIndex(*handle)).offset;
+
+        ResizeLayerMatrices(childrenDepth);
+
+        auto &&matrices = layersMatrices.at(childrenDepth);
+
+        matrices.localMatrices.at(offset) = glm::mat4{1.f};
+        matrices.worldMatrices.at(offset) = glm::mat4{1.f};
+
+        matrices.localPoses.at(offset) = node_pose_t{ };
+        matrices.posesDirty.at(offset) = 0;
+
+        // The node inherits the parent transform until it gets its own one.
+        MarkDirty(*handle);
+
+        IndexNode(*handle, parentHandle, name);
+    }
+
     return handle;
 }
 
-void SceneTree::RemoveNode(NodeHandle handle)
+std::optional<std::vector<NodeHandle>>
+SceneTree::BuildHierarchy(std::vector<std::int32_t> const &parents, std::vector<std::string> const &names, std::vector<glm::mat4> const &localMatrices)
 {
-    if (!isNodeHandleValid(handle))
-        return;
+    auto const count = std::size(parents);
 
-    auto &&node = nodes.at(static_cast<std::size_t>(handle));
+    if (auto &&rootChildren = layers.at(0).at(0).children; rootChildren.end != rootChildren.begin) {
+        std::cerr << "scene tree hierarchy can be built only in an empty tree\n"s;
+        return { };
+    }
 
-    if (!isNodeValid(node))
-        return;
+    if ((!std::empty(names) && std::size(names) != count) || (!std::empty(localMatrices) && std::size(localMatrices) != count)) {
+        std::cerr << "scene tree hierarchy names or matrices number doesn't match the nodes number\n"s;
+        return { };
+    }
 
-    auto &&layer = layers.at(node.depth);
-    auto &&info = layer.at(node.offset);
-    auto &&children = info.children;
+    // Children of each node in the index order sorted by counting, the root children go first.
+    std::vector<std::size_t> childrenOffsets(count + 2, 0);
+
+    for (auto parent : parents) {
+        if (parent < -1 || parent >= static_cast<std::int64_t>(count)) {
+            std::cerr << "scene tree hierarchy parent index is out of range\n"s;
+            return { };
+        }
 
-    auto const childrenCount = children.end - children.begin;
+        ++childrenOffsets[static_cast<std::size_t>(parent + 2)];
+    }
 
-    auto &&parentHandle = info.parent;
+    std::partial_sum(std::begin(childrenOffsets), std::end(childrenOffsets), std::begin(childrenOffsets));
 
-    if (!isNodeHandleValid(parentHandle))
-        return;
+    std::vector<std::size_t> children(count);
 
-    auto parentNode = nodes.at(static_cast<std::size_t>(parentHandle));
+    {
+        auto offsets = childrenOffsets;
 
-    if (!isNodeValid(parentNode))
-        return;
+        for (std::size_t index = 0; index < count; ++index)
+            children[offsets[static_cast<std::size_t>(parents[index] + 1)]++] = index;
+    }
 
-    auto &&parentInfo = layers.at(parentNode.depth).at(parentNode.offset);
-    auto &&parentChildren = parentInfo.children;
+    // Breadth-first order, the children of a layer follow the order of their parents.
+    std::vector<std::size_t> order(std::cbegin(children), std::next(std::cbegin(children), static_cast<std::ptrdiff_t>(childrenOffsets[1])));
+    order.reserve(count);
+
+    std::vector<std::size_t> layersSizes;
 
-    [[maybe_unused]] auto const parentChildrenDepth = parentNode.depth + 1;
-    auto const parentChildrenCount = parentChildren.end - parentChildren.begin;
+    for (std::size_t begin = 0, end = std::size(order); begin < end; begin = end, end = std::size(order)) {
+        layersSizes.push_back(end - begin);
 
-    if (parentChildrenCount > 1) {
-        ;
+        for (auto i = begin; i < end; ++i) {
+            auto const key = order[i] + 1;
+            order.insert(std::end(order), std::next(std::cbegin(children), static_cast<std::ptrdiff_t>(childrenOffsets[key])),
+                         std::next(std::cbegin(children), static_cast<std::ptrdiff_t>(childrenOffsets[key + 1])));
+        }
     }
 
-    else {
-        parentChildren = { };
+    if (std::size(order) != count) {
+        std::cerr << "scene tree hierarchy contains cycles\n"s;
+        return { };
+    }
+
+    nodes.reserve(std::size(nodes) - std::size(freeNodes) + count);
+
+    std::vector<NodeHandle> handles(count);
+
+    for (std::size_t index = 0; index < count; ++index)
+        handles[index] = AllocateNode(kINVALID_INDEX, kINVALID_INDEX);
+
+    // The layers of an empty tree may only hold the released slots.
+    layers.resize(1);
+    layers.resize(std::size(layersSizes) + 1);
+
+    layersMatrices.resize(1);
+    layersMatrices.resize(std::size(layers));
+
+    layersChunks.clear();
+    layersChunks.resize(std::size(layers));
+
+    layersChunksStale.assign(std::size(layers), 0);
+
+    {
+        auto namesSize = std::size_t{0};
+
+        for (auto &&name : names)
+            namesSize += std::size(name);
+
+        namesTable.reserve(std::size(namesTable) + namesSize);
     }
 
-    if (childrenCount > 0)
-        DestroyChildren(handle);
+    nodesByName.reserve(std::size(nodesByName) + count);
+    nodesByPath.reserve(std::size(nodesByPath) + count);
+
+    auto it_order = std::cbegin(order);
+
+    for (std::size_t depth = 1; depth < std::size(layers); ++depth) {
+        auto const layerSize = layersSizes[depth - 1];
+
+        auto &&layer = layers[depth];
+        auto &&matrices = layersMatrices[depth];
+
+        layer.reserve(layerSize);
+        matrices.localMatrices.reserve(layerSize);
+        matrices.worldMatrices.assign(layerSize, glm::mat4{1.f});
+
+        matrices.localPoses.assign(layerSize, node_pose_t{ });
+        matrices.posesDirty.assign(layerSize, 0);
+
+        for (std::size_t offset = 0; offset < layerSize; ++offset, ++it_order) {
+            auto const index = *it_order;
+
+            auto const parentHandle = parents[index] < 0 ? root() : handles[static_cast<std::size_t>(parents[index])];
+            auto const parentNode = nodes[NodeHandleIndex(parentHandle)];
+
+            auto &&node = nodes[NodeHandleIndex(handles[index])];
+
+            node.depth = depth;
+            node.offset = offset;
 
-    info.entity.destroy();
+            auto const name = std::empty(names) ? "noname"sv : std::string_view{names[index]};
 
-    auto &&layerChunks = layersChunks.at(node.depth);
-    layerChunks.emplace(node.offset);
+            layer.emplace_back(parentHandle, handles[index], entities->create(), StoreName(name));
+            matrices.localMatrices.push_back(std::empty(localMatrices) ? glm::mat4{1.f} : localMatrices[index]);
 
-    node = { };
+            IndexNode(handles[index], parentHandle, name);
+
+            // Siblings are laid out consecutively, so the parent range just grows by one.
+            auto &&parentChildren = layers[depth - 1][parentNode.offset].children;
+
+            if (parentChildren.end == parentChildren.begin)
+                parentChildren.begin = offset;
+
+            parentChildren.end = offset + 1;
+        }
+    }
+
+    MarkDirty(root());
+
+    return handles;
 }
 
-void SceneTree::DestroyChildren(NodeHandle handle)
+void SceneTree::RemoveNode(NodeHandle handle)
 {
     if (!isNodeHandleValid(handle))
         return;
 
-    auto &&node = nodes.at(static_cast<std::size_t>(handle));
-
-    if (!isNodeValid(node))
-        return;
+    auto node = nodes.at(NodeHandleIndex(handle));
 
     auto &&layer = layers.at(node.depth);
-    auto &&info = layer.at(node.offset);
-    auto &&children = info.children;
 
-    if (children.end - children.begin < 1)
+    auto const parentHandle = layer.at(node.offset).parent;
+
+    if (!isNodeHandleValid(parentHandle))
         return;
 
-    while (children.end - children.begin > 0) {
-        [[maybe_unused]] auto depth = node.depth + 1;
-        [[maybe_unused]] auto offset = children.end;
-    }
+    auto parentNode = nodes.at(NodeHandleIndex(parentHandle));
+
+    DestroyChildren(handle);
 
-    for (auto depth = node.depth + 1; depth < std::size(layers); ++depth) {
-        ;
+    layer.at(node.offset).entity.destroy();
+
+    auto &&parentChildren = layers.at(parentNode.depth).at(parentNode.offset).children;
+
+    auto freeOffset = node.offset;
+
+    if (parentChildren.end - parentChildren.begin < 2)
+        parentChildren = { };
+
+    else if (node.offset == parentChildren.begin)
+        ++parentChildren.begin;
+
+    else if (node.offset + 1 == parentChildren.end)
+        --parentChildren.end;
+
+    // The following siblings are moved by one slot back to keep the range contiguous.
+    else {
+        auto &&matrices = layersMatrices.at(node.depth);
+
+        for (auto offset = node.offset + 1; offset < parentChildren.end; ++offset) {
+            layer[offset - 1] = std::move(layer[offset]);
+
+            matrices.localMatrices[offset - 1] = matrices.localMatrices[offset];
+            matrices.worldMatrices[offset - 1] = matrices.worldMatrices[offset];
+
+            matrices.localPoses[offset - 1] = matrices.localPoses[offset];
+            matrices.posesDirty[offset - 1] = matrices.posesDirty[offset];
+
+            nodes.at(NodeHandleIndex(layer[offset - 1].handle)).offset = offset - 1;
+        }
+
+        freeOffset = --parentChildren.end;
     }
+
+    FreeSlot(node.depth, freeOffset);
+
+    ReleaseNode(handle);
 }
 
-void SceneTree::SetName(NodeHandle handle, std::string_view name)
+void SceneTree::DestroyChildren(NodeHandle handle)
 {
     if (!isNodeHandleValid(handle))
         return;
 
-    auto node = nodes.at(static_cast<std::size_t>(handle));
+    auto node = nodes.at(NodeHandleIndex(handle));
 
-    if (!isNodeValid(node))
+    auto &&children = layers.at(node.depth).at(node.offset).children;
+
+    if (children.end - children.begin < 1)
         return;
 
-    auto &&info = layers.at(node.depth).at(node.offset);
+    // The subtree is released layer by layer following the children ranges.
+    std::vector<range_t> ranges{{children.begin, children.end}}, nextRanges;
+
+    children = { };
+
+    for (auto depth = node.depth + 1; !std::empty(ranges); ++depth) {
+        auto &&layer = layers.at(depth);
+
+        nextRanges.clear();
+
+        for (auto [begin, end] : ranges) {
+            for (auto offset = begin; offset < end; ++offset) {
+                auto &&info = layer.at(offset);
+
+                if (!isNodeHandleValid(info.handle))
+                    continue;
+
+                if (info.children.end > info.children.begin)
+                    nextRanges.emplace_back(info.children.begin, info.children.end);
+
+                info.entity.destroy();
+
+                ReleaseNode(info.handle);
+
+                FreeSlot(depth, offset);
+            }
+        }
 
-    info.name = name;
+        ranges.swap(nextRanges);
+    }
 }
 
-void SceneTree::Update()
+std::vector<std::byte> SceneTree::SaveSnapshot() const
 {
-    entities->for_each<Transform>([] (auto entity, auto &&transform) {
-        std::cout << entity << "\n" << transform.localMatrix << "\n\n" << transform.worldMatrix << "\n\n";
-    });
+    snapshot_header_t header;
+
+    header.nodesNumber = std::size(nodes);
+    header.freeNodesNumber = std::size(freeNodes);
+    header.namesTableSize = std::size(namesTable);
+    header.layersNumber = std::size(layers);
+
+    header.lookupSize = sizeof(node_lookup_t);
+    header.internedNamesSlotsNumber = std::size(internedNames.slots());
+    header.nameIndexSlotsNumber = std::size(nodesByName.slots());
+    header.pathIndexSlotsNumber = std::size(nodesByPath.slots());
 
-    std::cout << "#############################\n\n";
+    auto size = sizeof(header) + std::size(nodes) * sizeof(Node) + std::size(freeNodes) * sizeof(std::uint32_t) + std::size(namesTable);
+
+    size += std::size(nodesLookup) * sizeof(node_lookup_t) + std::size(internedNames.slots()) * sizeof(decltype(internedNames)::slot_t) +
+            (std::size(nodesByName.slots()) + std::size(nodesByPath.slots())) * sizeof(lookup_index_t::slot_t);
 
     for (auto &&layer : layers) {
-        auto it_begin = std::find_if(std::begin(layer), std::end(layer), [this] (auto &&nodeInfo)
-        {
-            return isNodeHandleValid(nodeInfo.handle) && isNodeHandleValid(nodeInfo.parent);
-        });
+        size += sizeof(std::uint64_t) + std::size(layer) * (sizeof(NodeHandle) * 2 + sizeof(NodeInfo::NameRange) + sizeof(NodeInfo::ChildrenRange));
+        size += std::size(layer) * (sizeof(glm::mat4) * 2 + sizeof(node_pose_t) + sizeof(std::uint8_t));
+    }
 
-        while (it_begin != std::end(layer)) {
-            auto parentTransformHandle = it_begin->entity.component<Transform>();
+    std::vector<std::byte> buffer;
+    buffer.reserve(size);
 
-            auto it = std::adjacent_find(it_begin, std::end(layer), [] (auto &&lhs, auto &&rhs)
-            {
-                return lhs.parent != rhs.parent;
-            });
+    AppendBytes(buffer, &header, sizeof(header));
+    AppendBytes(buffer, std::data(nodes), std::size(nodes) * sizeof(Node));
+    AppendBytes(buffer, std::data(freeNodes), std::size(freeNodes) * sizeof(std::uint32_t));
+    AppendBytes(buffer, std::data(namesTable), std::size(namesTable));
 
-            if (it != std::end(layer))
-                it = std::next(it);
+    // The fields of the layer slots are stored as separate arrays followed by the layer matrices.
+    for (std::size_t depth = 0; depth < std::size(layers); ++depth) {
+        auto &&layer = layers[depth];
+        auto &&matrices = layersMatrices[depth];
 
-#ifdef _MSC_VER
-            std::for_each(std::execution::par_unseq, it_begin, it, [parentTransformHandle] (auto &&nodeInfo)
-            {
-                auto transformHandle = nodeInfo.entity.template component<Transform>();
-                transformHandle->worldMatrix = parentTransformHandle->worldMatrix * transformHandle->localMatrix;
-            });
-#else
-            std::for_each(it_begin, it, [parentTransformHandle] (auto &&nodeInfo)
-            {
-                auto transformHandle = nodeInfo.entity.template component<Transform>();
-                transformHandle->worldMatrix = parentTransformHandle->worldMatrix * transformHandle->localMatrix;
-            });
-#endif
+        auto const slotsNumber = static_cast<std::uint64_t>(std::size(layer));
+        AppendBytes(buffer, &slotsNumber, sizeof(slotsNumber));
 
-            it_begin = std::find_if(it, std::end(layer), [this] (auto &&nodeInfo)
-            {
-                return isNodeHandleValid(nodeInfo.handle) && isNodeHandleValid(nodeInfo.parent);
-            });
+        for (auto &&info : layer)
+            AppendBytes(buffer, &info.parent, sizeof(info.parent));
+
+        for (auto &&info : layer)
+            AppendBytes(buffer, &info.handle, sizeof(info.handle));
+
+        for (auto &&info : layer)
+            AppendBytes(buffer, &info.name, sizeof(info.name));
+
+        for (auto &&info : layer)
+            AppendBytes(buffer, &info.children, sizeof(info.children));
+
+        AppendBytes(buffer, std::data(matrices.localMatrices), std::size(layer) * sizeof(glm::mat4));
+        AppendBytes(buffer, std::data(matrices.worldMatrices), std::size(layer) * sizeof(glm::mat4));
+
+        AppendBytes(buffer, std::data(matrices.localPoses), std::size(layer) * sizeof(node_pose_t));
+        AppendBytes(buffer, std::data(matrices.posesDirty), std::size(layer) * sizeof(std::uint8_t));
+    }
+
+    // The lookup tables are stored as they are, so restoring doesn't rehash the names.
+    AppendBytes(buffer, std::data(nodesLookup), std::size(nodesLookup) * sizeof(node_lookup_t));
+
+    AppendBytes(buffer, std::data(internedNames.slots()), std::size(internedNames.slots()) * sizeof(decltype(internedNames)::slot_t));
+    AppendBytes(buffer, std::data(nodesByName.slots()), std::size(nodesByName.slots()) * sizeof(lookup_index_t::slot_t));
+    AppendBytes(buffer, std::data(nodesByPath.slots()), std::size(nodesByPath.slots()) * sizeof(lookup_index_t::slot_t));
+
+    return buffer;
+}
+
+bool SceneTree::RestoreSnapshot(std::byte const *data, std::size_t size)
+{
+    SnapshotReader reader{data, size};
+
+    snapshot_header_t header;
+
+    if (!reader.Read(header) || header.magic != kSNAPSHOT_MAGIC || header.version != kSNAPSHOT_VERSION ||
+        header.nodeSize != sizeof(Node) || header.matrixSize != sizeof(glm::mat4) || header.poseSize != sizeof(node_pose_t) ||
+        header.lookupSize != sizeof(node_lookup_t)) {
+        std::cerr << "unsupported scene tree snapshot\n"s;
+        return false;
+    }
+
+    auto const malformed = []
+    {
+        std::cerr << "malformed scene tree snapshot\n"s;
+        return false;
+    };
+
+    if (header.nodesNumber == 0 || header.layersNumber == 0 || header.nodesNumber > size / sizeof(Node) ||
+        header.freeNodesNumber > header.nodesNumber || header.namesTableSize > size || header.layersNumber > size ||
+        header.internedNamesSlotsNumber > size / sizeof(decltype(internedNames)::slot_t) ||
+        header.nameIndexSlotsNumber > size / sizeof(lookup_index_t::slot_t) || header.pathIndexSlotsNumber > size / sizeof(lookup_index_t::slot_t))
+        return malformed();
+
+    decltype(nodes) restoredNodes(static_cast<std::size_t>(header.nodesNumber));
+    decltype(freeNodes) restoredFreeNodes(static_cast<std::size_t>(header.freeNodesNumber));
+    decltype(namesTable) restoredNamesTable(static_cast<std::size_t>(header.namesTableSize), '\0');
+
+    if (!reader.ReadBytes(std::data(restoredNodes), std::size(restoredNodes) * sizeof(Node)) ||
+        !reader.ReadBytes(std::data(restoredFreeNodes), std::size(restoredFreeNodes) * sizeof(std::uint32_t)) ||
+        !reader.ReadBytes(std::data(restoredNamesTable), std::size(restoredNamesTable)))
+        return malformed();
+
+    // The live nodes get the entities of a single batch.
+    auto const liveNodesNumber = static_cast<std::size_t>(std::count_if(std::cbegin(restoredNodes), std::cend(restoredNodes), [this] (auto &&node)
+    {
+        return isNodeValid(node);
+    }));
+
+    auto restoredEntities = std::make_unique<EntityManager>();
+    auto liveEntities = restoredEntities->create_many(liveNodesNumber);
+
+    auto it_entity = std::begin(liveEntities);
+
+    decltype(layers) restoredLayers(static_cast<std::size_t>(header.layersNumber));
+    decltype(layersMatrices) restoredLayersMatrices(std::size(restoredLayers));
+
+    auto const slotSize = sizeof(NodeHandle) * 2 + sizeof(NodeInfo::NameRange) + sizeof(NodeInfo::ChildrenRange) + sizeof(glm::mat4) * 2 +
+                          sizeof(node_pose_t) + sizeof(std::uint8_t);
+
+    for (std::size_t depth = 0; depth < std::size(restoredLayers); ++depth) {
+        std::uint64_t slotsNumber = 0;
+
+        if (!reader.Read(slotsNumber) || slotsNumber > size / slotSize)
+            return malformed();
+
+        auto const count = static_cast<std::size_t>(slotsNumber);
+
+        auto const parents = reader.Skip(count, sizeof(NodeHandle));
+        auto const handles = reader.Skip(count, sizeof(NodeHandle));
+        auto const names = reader.Skip(count, sizeof(NodeInfo::NameRange));
+        auto const children = reader.Skip(count, sizeof(NodeInfo::ChildrenRange));
+
+        if (parents == nullptr || handles == nullptr || names == nullptr || children == nullptr)
+            return malformed();
+
+        auto &&layer = restoredLayers[depth];
+        layer.resize(count);
+
+        for (std::size_t offset = 0; offset < count; ++offset) {
+            auto &&info = layer[offset];
+
+            std::memcpy(&info.parent, parents + offset * sizeof(NodeHandle), sizeof(NodeHandle));
+            std::memcpy(&info.handle, handles + offset * sizeof(NodeHandle), sizeof(NodeHandle));
+            std::memcpy(&info.name, names + offset * sizeof(NodeInfo::NameRange), sizeof(NodeInfo::NameRange));
+            std::memcpy(&info.children, children + offset * sizeof(NodeInfo::ChildrenRange), sizeof(NodeInfo::ChildrenRange));
+
+            if (info.handle == NodeHandle::nINVALID_HANDLE)
+                continue;
+
+            // Live slots have to agree with their nodes and refer to the existing names and children.
+            auto const index = NodeHandleIndex(info.handle);
+
+            if (index >= std::size(restoredNodes))
+                return malformed();
+
+            auto &&node = restoredNodes[index];
+
+            if (node.generation != NodeHandleGeneration(info.handle) || node.depth != depth || node.offset != offset)
+                return malformed();
+
+            if (static_cast<std::uint64_t>(info.name.offset) + info.name.length > std::size(restoredNamesTable))
+                return malformed();
+
+            if (info.children.begin > info.children.end || (info.children.end > info.children.begin && depth + 1 >= std::size(restoredLayers)))
+                return malformed();
+
+            if (it_entity == std::end(liveEntities))
+                return malformed();
+
+            info.entity = *it_entity++;
         }
+
+        auto &&matrices = restoredLayersMatrices[depth];
+
+        matrices.localMatrices.resize(count);
+        matrices.worldMatrices.resize(count);
+
+        matrices.localPoses.resize(count);
+        matrices.posesDirty.resize(count);
+
+        if (!reader.ReadBytes(std::data(matrices.localMatrices), count * sizeof(glm::mat4)) ||
+            !reader.ReadBytes(std::data(matrices.worldMatrices), count * sizeof(glm::mat4)) ||
+            !reader.ReadBytes(std::data(matrices.localPoses), count * sizeof(node_pose_t)) ||
+            !reader.ReadBytes(std::data(matrices.posesDirty), count * sizeof(std::uint8_t)))
+            return malformed();
     }
 
-    entities->for_each<Transform>([] (auto entity, auto &&transform) {
-        std::cout << entity << "\n" << transform.localMatrix << "\n\n" << transform.worldMatrix << "\n\n";
-    });
+    // The children ranges are checked once the sizes of all the layers are known.
+    for (std::size_t depth = 0; depth + 1 < std::size(restoredLayers); ++depth) {
+        for (auto &&info : restoredLayers[depth])
+            if (info.children.end > std::size(restoredLayers[depth + 1]))
+                return malformed();
+    }
+
+    auto const &rootNode = restoredNodes.front();
+
+    if (rootNode.depth != 0 || rootNode.offset != 0 || rootNode.generation != 0 || std::size(restoredLayers.front()) != 1 ||
+        restoredLayers.front().front().parent != NodeHandle::nINVALID_HANDLE)
+        return malformed();
+
+    // Every live node has to own its slot and to be a child of a live node of the previous layer.
+    for (auto &&node : restoredNodes) {
+        if (!isNodeValid(node))
+            continue;
+
+        if (node.depth >= std::size(restoredLayers) || node.offset >= std::size(restoredLayers[node.depth]))
+            return malformed();
+
+        auto &&info = restoredLayers[node.depth][node.offset];
+
+        if (info.handle == NodeHandle::nINVALID_HANDLE || &restoredNodes[NodeHandleIndex(info.handle)] != &node)
+            return malformed();
+
+        if (node.depth == 0)
+            continue;
+
+        auto const parentIndex = NodeHandleIndex(info.parent);
+
+        if (info.parent == NodeHandle::nINVALID_HANDLE || parentIndex >= std::size(restoredNodes))
+            return malformed();
+
+        auto &&parentNode = restoredNodes[parentIndex];
+
+        if (parentNode.generation != NodeHandleGeneration(info.parent) || parentNode.depth + 1 != node.depth)
+            return malformed();
+
+        auto &&parentChildren = restoredLayers[parentNode.depth][parentNode.offset].children;
+
+        if (node.offset < parentChildren.begin || node.offset >= parentChildren.end)
+            return malformed();
+    }
+
+    for (auto index : restoredFreeNodes)
+        if (index >= std::size(restoredNodes) || isNodeValid(restoredNodes[index]))
+            return malformed();
+
+    decltype(nodesLookup) restoredNodesLookup(std::size(restoredNodes));
+
+    std::vector<decltype(internedNames)::slot_t> internedNamesSlots(static_cast<std::size_t>(header.internedNamesSlotsNumber));
+    std::vector<lookup_index_t::slot_t> nameIndexSlots(static_cast<std::size_t>(header.nameIndexSlotsNumber));
+    std::vector<lookup_index_t::slot_t> pathIndexSlots(static_cast<std::size_t>(header.pathIndexSlotsNumber));
+
+    if (!reader.ReadBytes(std::data(restoredNodesLookup), std::size(restoredNodesLookup) * sizeof(node_lookup_t)) ||
+        !reader.ReadBytes(std::data(internedNamesSlots), std::size(internedNamesSlots) * sizeof(decltype(internedNames)::slot_t)) ||
+        !reader.ReadBytes(std::data(nameIndexSlots), std::size(nameIndexSlots) * sizeof(lookup_index_t::slot_t)) ||
+        !reader.ReadBytes(std::data(pathIndexSlots), std::size(pathIndexSlots) * sizeof(lookup_index_t::slot_t)))
+        return malformed();
+
+    decltype(internedNames) restoredInternedNames;
+    lookup_index_t restoredNodesByName, restoredNodesByPath;
+
+    if (!restoredInternedNames.Assign(std::move(internedNamesSlots)) || !restoredNodesByName.Assign(std::move(nameIndexSlots)) ||
+        !restoredNodesByPath.Assign(std::move(pathIndexSlots)))
+        return malformed();
+
+    for (auto &&slot : restoredInternedNames.slots()) {
+        if (slot.occupied != 0 && static_cast<std::uint64_t>(slot.value.offset) + slot.value.length > std::size(restoredNamesTable))
+            return malformed();
+    }
+
+    // The chains have to link the live nodes of the same hash both ways starting at the heads of the table,
+    // so the lookups neither leave the nodes nor loop.
+    auto const isIndexValid = [this, &restoredNodes, &restoredNodesLookup] (lookup_index_t const &index, lookup_chain_t chain,
+                                                                          std::uint64_t node_lookup_t::*hash)
+    {
+        auto const nodesNumber = std::size(restoredNodes);
+
+        for (auto &&slot : index.slots()) {
+            if (slot.occupied == 0)
+                continue;
+
+            if (slot.value >= nodesNumber || !isNodeValid(restoredNodes[slot.value]) || restoredNodesLookup[slot.value].*hash != slot.key)
+                return false;
+        }
+
+        for (std::uint32_t i = 0; i < nodesNumber; ++i) {
+            auto &&lookup = restoredNodesLookup[i];
+            auto &&links = lookup.*chain;
+
+            if (!isNodeValid(restoredNodes[i])) {
+                if (links.previous != kNO_NODE || links.next != kNO_NODE)
+                    return false;
+
+                continue;
+            }
+
+            if (links.next != kNO_NODE) {
+                if (links.next >= nodesNumber || (restoredNodesLookup[links.next].*chain).previous != i ||
+                    restoredNodesLookup[links.next].*hash != lookup.*hash)
+                    return false;
+            }
+
+            if (links.previous == kNO_NODE) {
+                if (auto const head = index.find(lookup.*hash); head == nullptr || *head != i)
+                    return false;
+            }
+
+            else if (links.previous >= nodesNumber || (restoredNodesLookup[links.previous].*chain).next != i)
+                return false;
+        }
+
+        return true;
+    };
+
+    if (!isIndexValid(restoredNodesByName, &node_lookup_t::nameChain, &node_lookup_t::nameHash) ||
+        !isIndexValid(restoredNodesByPath, &node_lookup_t::pathChain, &node_lookup_t::pathHash))
+        return malformed();
+
+    entities = std::move(restoredEntities);
+
+    nodes = std::move(restoredNodes);
+    freeNodes = std::move(restoredFreeNodes);
+    namesTable = std::move(restoredNamesTable);
+
+    layers = std::move(restoredLayers);
+    layersMatrices = std::move(restoredLayersMatrices);
+
+    // The free slots are the invalid slots of the layers.
+    layersChunks.clear();
+    layersChunks.resize(std::size(layers));
+
+    layersChunksStale.assign(std::size(layers), 1);
+
+    internedNames = std::move(restoredInternedNames);
+    nodesLookup = std::move(restoredNodesLookup);
+
+    nodesByName = std::move(restoredNodesByName);
+    nodesByPath = std::move(restoredNodesByPath);
+
+    dirtyNodes.clear();
+    changedNodes.clear();
+    layersDirtyRanges.clear();
+
+    for (std::size_t index = 0; index < std::size(nodes); ++index) {
+        if (nodes[index].dirty)
+            dirtyNodes.push_back(MakeNodeHandle(static_cast<std::uint32_t>(index), nodes[index].generation));
+    }
+
+    return true;
+}
+
+void SceneTree::Compact()
+{
+    InternNames();
+
+    // Each layer is rebuilt in the order of the parents in the previous, already compacted, layer.
+    for (std::size_t depth = 0; depth + 1 < std::size(layers); ++depth) {
+        auto &&parentLayer = layers[depth];
+        auto &&layer = layers[depth + 1];
+        auto &&matrices = layersMatrices[depth + 1];
+
+        layer_t compactLayer;
+        layer_matrices_t compactMatrices;
+
+        compactLayer.reserve(std::size(layer));
+        compactMatrices.localMatrices.reserve(std::size(layer));
+        compactMatrices.worldMatrices.reserve(std::size(layer));
+
+        compactMatrices.localPoses.reserve(std::size(layer));
+        compactMatrices.posesDirty.reserve(std::size(layer));
+
+        for (auto &&parentInfo : parentLayer) {
+            if (!isNodeHandleValid(parentInfo.handle))
+                continue;
+
+            auto &&children = parentInfo.children;
+
+            auto const begin = std::size(compactLayer);
+
+            for (auto offset = children.begin; offset < children.end; ++offset) {
+                auto &&info = layer[offset];
+
+                if (!isNodeHandleValid(info.handle))
+                    continue;
+
+                nodes.at(NodeHandleIndex(info.handle)).offset = std::size(compactLayer);
+
+                compactLayer.push_back(std::move(info));
+                compactMatrices.localMatrices.push_back(matrices.localMatrices[offset]);
+                compactMatrices.worldMatrices.push_back(matrices.worldMatrices[offset]);
+
+                compactMatrices.localPoses.push_back(matrices.localPoses[offset]);
+                compactMatrices.posesDirty.push_back(matrices.posesDirty[offset]);
+            }
+
+            children = begin < std::size(compactLayer) ? NodeInfo::ChildrenRange{begin, std::size(compactLayer)} : NodeInfo::ChildrenRange{ };
+        }
+
+        layer = std::move(compactLayer);
+        matrices = std::move(compactMatrices);
+    }
+
+    for (auto &&layerChunks : layersChunks)
+        layerChunks.clear();
+
+    std::fill(std::begin(layersChunksStale), std::end(layersChunksStale), 0);
+
+    while (std::size(layers) > 1 && std::empty(layers.back())) {
+        layers.pop_back();
+        layersMatrices.pop_back();
+
+        if (std::size(layersChunks) > std::size(layers)) {
+            layersChunks.resize(std::size(layers));
+            layersChunksStale.resize(std::size(layers));
+        }
+    }
+}
+
+void SceneTree::SetName(NodeHandle handle, std::string_view name)
+{
+    if (!isNodeHandleValid(handle))
+        return;
+
+    auto node = nodes.at(NodeHandleIndex(handle));
+
+    auto &&info = layers.at(node.depth).at(node.offset);
+
+    info.name = StoreName(name);
+
+    auto const index = NodeHandleIndex(handle);
+    auto &&lookup = nodesLookup.at(index);
+
+    Unlink(nodesByName, &node_lookup_t::nameChain, lookup.nameHash, index);
+
+    lookup.nameHash = HashName(name);
+    Link(nodesByName, &node_lookup_t::nameChain, lookup.nameHash, index);
+
+    ReindexPaths(handle);
+}
+
+std::optional<std::string_view> SceneTree::GetName(NodeHandle handle) const
+{
+    if (!isNodeHandleValid(handle))
+        return { };
+
+    auto node = nodes.at(NodeHandleIndex(handle));
+
+    auto &&info = layers.at(node.depth).at(node.offset);
+
+    return std::string_view{namesTable}.substr(info.name.offset, info.name.length);
+}
+
+std::optional<NodeHandle> SceneTree::FindNode(std::string_view name) const
+{
+    return FindNode(HashName(name), name);
+}
+
+std::optional<NodeHandle> SceneTree::FindNodeByPath(std::string_view path) const
+{
+    return FindNodeByPath(HashName(path), path);
+}
+
+std::vector<NodeHandle> SceneTree::FindNodes(std::vector<std::string_view> const &names) const
+{
+    std::vector<NodeHandle> handles;
+    handles.reserve(std::size(names));
+
+    for (auto name : names)
+        handles.push_back(FindNode(HashName(name), name).value_or(NodeHandle::nINVALID_HANDLE));
+
+    return handles;
+}
+
+std::vector<NodeHandle> SceneTree::FindNodesByPath(std::vector<std::string_view> const &paths) const
+{
+    std::vector<NodeHandle> handles;
+    handles.reserve(std::size(paths));
+
+    for (auto path : paths)
+        handles.push_back(FindNodeByPath(HashName(path), path).value_or(NodeHandle::nINVALID_HANDLE));
+
+    return handles;
+}
+
+std::optional<NodeHandle> SceneTree::FindNode(std::uint64_t hash, std::string_view name) const
+{
+    auto const head = nodesByName.find(hash);
+
+    if (head == nullptr)
+        return { };
+
+    // Different names may share the hash.
+    for (auto index = *head; index != kNO_NODE; index = nodesLookup[index].nameChain.next) {
+        auto const handle = MakeNodeHandle(index, nodes[index].generation);
+
+        if (GetName(handle) == name)
+            return handle;
+    }
+
+    return { };
+}
+
+std::optional<NodeHandle> SceneTree::FindNodeByPath(std::uint64_t hash, std::string_view path) const
+{
+    auto const head = nodesByPath.find(hash);
+
+    if (head == nullptr)
+        return { };
+
+    // The path is matched name by name going from the node up to the root.
+    auto MatchPath = [this] (NodeHandle handle, std::string_view path)
+    {
+        while (true) {
+            auto node = nodes[NodeHandleIndex(handle)];
+            auto &&info = layers[node.depth][node.offset];
+
+            auto const name = std::string_view{namesTable}.substr(info.name.offset, info.name.length);
+
+            if (std::size(path) < std::size(name) || path.substr(std::size(path) - std::size(name)) != name)
+                return false;
+
+            path.remove_suffix(std::size(name));
+
+            if (info.parent == NodeHandle::nINVALID_HANDLE)
+                return std::empty(path);
+
+            if (std::empty(path) || path.back() != '/')
+                return false;
+
+            path.remove_suffix(1);
+
+            handle = info.parent;
+        }
+    };
+
+    for (auto index = *head; index != kNO_NODE; index = nodesLookup[index].pathChain.next) {
+        auto const handle = MakeNodeHandle(index, nodes[index].generation);
+
+        if (MatchPath(handle, path))
+            return handle;
+    }
+
+    return { };
+}
+
+NodeInfo::NameRange SceneTree::StoreName(std::string_view name)
+{
+    auto const hash = HashName(name);
+
+    auto const interned = internedNames.find(hash, [this, name] (auto range)
+    {
+        return std::string_view{namesTable}.substr(range.offset, range.length) == name;
+    });
+
+    if (interned != nullptr)
+        return *interned;
+
+    NodeInfo::NameRange const range{static_cast<std::uint32_t>(std::size(namesTable)), static_cast<std::uint32_t>(std::size(name))};
+
+    namesTable.append(name);
+
+    internedNames.insert(hash, range);
+
+    return range;
+}
+
+void SceneTree::InternNames()
+{
+    // The old table is swapped for an empty one of the same capacity.
+    std::string oldNamesTable;
+    oldNamesTable.reserve(std::size(namesTable));
+
+    oldNamesTable.swap(namesTable);
+    internedNames.clear();
+
+    for (auto &&layer : layers) {
+        for (auto &&info : layer) {
+            if (isNodeHandleValid(info.handle))
+                info.name = StoreName(std::string_view{oldNamesTable}.substr(info.name.offset, info.name.length));
+        }
+    }
+}
+
+void SceneTree::IndexNode(NodeHandle handle, NodeHandle parentHandle, std::string_view name)
+{
+    auto const index = NodeHandleIndex(handle);
+    auto &&lookup = nodesLookup.at(index);
+
+    lookup.nameHash = HashName(name);
+
+    if (parentHandle == NodeHandle::nINVALID_HANDLE)
+        lookup.pathHash = lookup.nameHash;
+
+    else lookup.pathHash = HashName(name, HashName("/"sv, nodesLookup.at(NodeHandleIndex(parentHandle)).pathHash));
+
+    Link(nodesByName, &node_lookup_t::nameChain, lookup.nameHash, index);
+    Link(nodesByPath, &node_lookup_t::pathChain, lookup.pathHash, index);
+}
+
+void SceneTree::ReindexPaths(NodeHandle handle)
+{
+    auto node = nodes.at(NodeHandleIndex(handle));
+
+    // The parents are rehashed before their children going layer by layer.
+    std::vector<range_t> ranges{{node.offset, node.offset + 1}}, nextRanges;
+
+    for (auto depth = node.depth; !std::empty(ranges); ++depth) {
+        auto &&layer = layers.at(depth);
+
+        nextRanges.clear();
+
+        for (auto [begin, end] : ranges) {
+            for (auto offset = begin; offset < end; ++offset) {
+                auto &&info = layer.at(offset);
+
+                if (!isNodeHandleValid(info.handle))
+                    continue;
+
+                if (info.children.end > info.children.begin)
+                    nextRanges.emplace_back(info.children.begin, info.children.end);
+
+                auto const index = NodeHandleIndex(info.handle);
+                auto &&lookup = nodesLookup[index];
+
+                Unlink(nodesByPath, &node_lookup_t::pathChain, lookup.pathHash, index);
+
+                auto const name = std::string_view{namesTable}.substr(info.name.offset, info.name.length);
+
+                if (info.parent == NodeHandle::nINVALID_HANDLE)
+                    lookup.pathHash = HashName(name);
+
+                else lookup.pathHash = HashName(name, HashName("/"sv, nodesLookup[NodeHandleIndex(info.parent)].pathHash));
+
+                Link(nodesByPath, &node_lookup_t::pathChain, lookup.pathHash, index);
+            }
+        }
+
+        ranges.swap(nextRanges);
+    }
+}
+
+void SceneTree::Link(lookup_index_t &index, lookup_chain_t chain, std::uint64_t hash, std::uint32_t nodeIndex)
+{
+    auto &&links = nodesLookup[nodeIndex].*chain;
+
+    links = { };
+
+    auto const head = index.find(hash);
+
+    if (head == nullptr) {
+        index.insert(hash, nodeIndex);
+        return;
+    }
+
+    links.next = *head;
+    (nodesLookup[*head].*chain).previous = nodeIndex;
+
+    *head = nodeIndex;
+}
+
+void SceneTree::Unlink(lookup_index_t &index, lookup_chain_t chain, std::uint64_t hash, std::uint32_t nodeIndex)
+{
+    auto &&links = nodesLookup[nodeIndex].*chain;
+
+    if (links.next != kNO_NODE)
+        (nodesLookup[links.next].*chain).previous = links.previous;
+
+    if (links.previous != kNO_NODE)
+        (nodesLookup[links.previous].*chain).next = links.next;
+
+    else if (links.next != kNO_NODE)
+        *index.find(hash) = links.next;
+
+    else index.erase(hash);
+
+    links = { };
+}
+
+void SceneTree::SetLocalMatrix(NodeHandle handle, glm::mat4 const &localMatrix)
+{
+    if (!isNodeHandleValid(handle))
+        return;
+
+    auto node = nodes.at(NodeHandleIndex(handle));
+
+    auto &&matrices = layersMatrices.at(node.depth);
+
+    matrices.localMatrices.at(node.offset) = localMatrix;
+    matrices.posesDirty.at(node.offset) = 0;
+
+    MarkDirty(handle);
+}
+
+void SceneTree::SetLocalPose(NodeHandle handle, node_pose_t const &pose)
+{
+    if (!isNodeHandleValid(handle))
+        return;
+
+    auto node = nodes.at(NodeHandleIndex(handle));
+
+    auto &&matrices = layersMatrices.at(node.depth);
+
+    matrices.localPoses.at(node.offset) = pose;
+    matrices.posesDirty.at(node.offset) = 1;
+
+    MarkDirty(handle);
+}
+
+std::optional<node_pose_t> SceneTree::GetLocalPose(NodeHandle handle) const
+{
+    if (!isNodeHandleValid(handle))
+        return { };
+
+    auto node = nodes.at(NodeHandleIndex(handle));
+
+    return layersMatrices.at(node.depth).localPoses.at(node.offset);
+}
+
+std::optional<glm::mat4> SceneTree::GetWorldMatrix(NodeHandle handle) const
+{
+    if (!isNodeHandleValid(handle))
+        return { };
+
+    auto node = nodes.at(NodeHandleIndex(handle));
+
+    return layersMatrices.at(node.depth).worldMatrices.at(node.offset);
+}
+
+void SceneTree::CopyWorldMatrices(std::uint32_t nodeIndex, std::size_t count, glm::mat4 *worldMatrices) const
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        auto node = nodes.at(nodeIndex + i);
+
+        worldMatrices[i] = isNodeValid(node) ? layersMatrices[node.depth].worldMatrices[node.offset] : glm::mat4{1.f};
+    }
+}
+
+void SceneTree::FreeSlot(std::size_t depth, node_index_t offset)
+{
+    layers.at(depth).at(offset) = NodeInfo{ };
+
+    LayerChunks(depth).emplace(offset);
+}
+
+SceneTree::chunks_t &SceneTree::LayerChunks(std::size_t depth)
+{
+    if (std::size(layersChunks) < depth + 1) {
+        layersChunks.resize(depth + 1);
+        layersChunksStale.resize(depth + 1, 0);
+    }
+
+    auto &&layerChunks = layersChunks[depth];
+
+    if (layersChunksStale[depth] != 0) {
+        layersChunksStale[depth] = 0;
+
+        auto &&layer = layers.at(depth);
+
+        for (node_index_t offset = 0; offset < std::size(layer); ++offset) {
+            if (layer[offset].handle == NodeHandle::nINVALID_HANDLE)
+                layerChunks.emplace_hint(std::end(layerChunks), offset);
+        }
+    }
+
+    return layerChunks;
+}
+
+void SceneTree::ResizeLayerMatrices(std::size_t depth)
+{
+    auto &&matrices = layersMatrices.at(depth);
+    auto const size = std::size(layers.at(depth));
+
+    matrices.localMatrices.resize(size, glm::mat4{1.f});
+    matrices.worldMatrices.resize(size, glm::mat4{1.f});
+
+    matrices.localPoses.resize(size);
+    matrices.posesDirty.resize(size, 0);
+}
+
+NodeHandle SceneTree::AllocateNode(node_index_t depth, node_index_t offset)
+{
+    if (std::empty(freeNodes)) {
+        auto const index = static_cast<std::uint32_t>(std::size(nodes));
+
+        nodes.emplace_back(depth, offset);
+        nodesLookup.emplace_back();
+
+        return MakeNodeHandle(index, 0);
+    }
+
+    auto const index = freeNodes.back();
+    freeNodes.pop_back();
+
+    auto &&node = nodes[index];
+
+    node.depth = depth;
+    node.offset = offset;
+    node.dirty = false;
+
+    return MakeNodeHandle(index, node.generation);
+}
+
+void SceneTree::ReleaseNode(NodeHandle handle)
+{
+    auto const index = NodeHandleIndex(handle);
+
+    auto &&node = nodes.at(index);
+
+    node.depth = kINVALID_INDEX;
+    node.offset = kINVALID_INDEX;
+    node.dirty = false;
+
+    ++node.generation;
+
+    auto &&lookup = nodesLookup.at(index);
+
+    Unlink(nodesByName, &node_lookup_t::nameChain, lookup.nameHash, index);
+    Unlink(nodesByPath, &node_lookup_t::pathChain, lookup.pathHash, index);
+
+    freeNodes.push_back(index);
+}
+
+void SceneTree::MarkDirty(NodeHandle handle)
+{
+    auto &&node = nodes.at(NodeHandleIndex(handle));
+
+    if (node.dirty)
+        return;
+
+    node.dirty = true;
+    dirtyNodes.push_back(handle);
+}
+
+void SceneTree::UpdateRange(std::size_t depth, range_t range, update_scratch_t &scratch)
+{
+    auto &&layer = layers[depth];
+    auto &&matrices = layersMatrices[depth];
+
+    auto const isValid = [this, &layer] (node_index_t offset)
+    {
+        auto &&info = layer[offset];
+        return isNodeHandleValid(info.handle);
+    };
+
+    glm::mat4 const identity{1.f};
+
+    auto offset = range.first;
+
+    while (offset < range.second) {
+        if (!isValid(offset)) {
+            ++offset;
+            continue;
+        }
+
+        auto const parentHandle = layer[offset].parent;
+
+        // Siblings are adjacent, so the whole run of them is multiplied by the parent matrix at once.
+        auto end = offset + 1;
+
+        while (end < range.second && layer[end].parent == parentHandle && isValid(end))
+            ++end;
+
+        auto parentWorldMatrix = &identity;
+
+        if (isNodeHandleValid(parentHandle)) {
+            auto parentNode = nodes[NodeHandleIndex(parentHandle)];
+            parentWorldMatrix = &layersMatrices[parentNode.depth].worldMatrices[parentNode.offset];
+        }
+
+        // The runs of the dirty poses of the siblings are composed at once.
+        for (auto pose = offset; pose < end;) {
+            if (matrices.posesDirty[pose] == 0) {
+                ++pose;
+                continue;
+            }
+
+            auto poseEnd = pose + 1;
+
+            while (poseEnd < end && matrices.posesDirty[poseEnd] != 0)
+                ++poseEnd;
+
+            ComposeMatrices(&matrices.localPoses[pose], &matrices.localMatrices[pose], poseEnd - pose);
+
+            std::fill(std::next(std::begin(matrices.posesDirty), pose), std::next(std::begin(matrices.posesDirty), poseEnd), 0);
+
+            pose = poseEnd;
+        }
+
+        MultiplyMatrices(*parentWorldMatrix, &matrices.localMatrices[offset], &matrices.worldMatrices[offset], end - offset);
+
+        for (; offset < end; ++offset) {
+            auto &&info = layer[offset];
+
+            scratch.changedNodes.push_back(info.handle);
+
+            if (auto &&children = info.children; children.end > children.begin)
+                scratch.childrenRanges.emplace_back(children.begin, children.end);
+        }
+    }
+}
+
+std::vector<NodeHandle> const &SceneTree::Update(JobSystem *jobSystem)
+{
+    changedNodes.clear();
+
+    if (std::empty(dirtyNodes))
+        return changedNodes;
+
+    layersDirtyRanges.resize(std::size(layers));
+    updateScratches.resize(jobSystem != nullptr ? jobSystem->threadsNumber() : 1);
+
+    // Handles of the nodes released after being marked are stale by now.
+    for (auto handle : dirtyNodes) {
+        if (!isNodeHandleValid(handle))
+            continue;
+
+        auto &&node = nodes[NodeHandleIndex(handle)];
+
+        node.dirty = false;
+
+        layersDirtyRanges.at(node.depth).emplace_back(node.offset, node.offset + 1);
+    }
+
+    dirtyNodes.clear();
+
+    for (std::size_t depth = 0; depth < std::size(layers); ++depth) {
+        auto &&ranges = layersDirtyRanges[depth];
+
+        if (std::empty(ranges))
+            continue;
+
+        // Overlapping and adjacent ranges are merged, so each node is updated once.
+        std::sort(std::begin(ranges), std::end(ranges));
+
+        auto it_merged = std::begin(ranges);
+
+        for (auto it = std::next(it_merged); it != std::end(ranges); ++it) {
+            if (it->first <= it_merged->second)
+                it_merged->second = std::max(it_merged->second, it->second);
+
+            else *++it_merged = *it;
+        }
+
+        ranges.erase(std::next(it_merged), std::end(ranges));
+
+        // Chunks start at multiples of the chunk size, so the chunks of a layer never share a cache line of the layer matrices.
+        updateChunks.clear();
+
+        for (auto [begin, end] : ranges) {
+            while (begin < end) {
+                auto const chunkEnd = std::min(end, (begin / kUPDATE_CHUNK_SIZE + 1) * kUPDATE_CHUNK_SIZE);
+
+                updateChunks.emplace_back(begin, chunkEnd);
+                begin = chunkEnd;
+            }
+        }
+
+        ranges.clear();
+
+        auto const updateChunksRange = [this, depth] (std::size_t begin, std::size_t end, std::size_t thread)
+        {
+            for (auto chunk = begin; chunk < end; ++chunk)
+                UpdateRange(depth, updateChunks[chunk], updateScratches[thread]);
+        };
+
+        if (jobSystem != nullptr && std::size(updateChunks) > 1)
+            jobSystem->ParallelFor(std::size(updateChunks), 1, updateChunksRange);
+
+        else updateChunksRange(0, std::size(updateChunks), 0);
+
+        for (auto &&scratch : updateScratches) {
+            if (!std::empty(scratch.childrenRanges)) {
+                auto &&childrenRanges = layersDirtyRanges.at(depth + 1);
+                childrenRanges.insert(std::end(childrenRanges), std::cbegin(scratch.childrenRanges), std::cend(scratch.childrenRanges));
+            }
+
+            changedNodes.insert(std::end(changedNodes), std::cbegin(scratch.changedNodes), std::cend(scratch.changedNodes));
+
+            scratch.childrenRanges.clear();
+            scratch.changedNodes.clear();
+        }
+    }
 
-    //entities->systems.update_all(0.f);
+    return changedNodes;
 }
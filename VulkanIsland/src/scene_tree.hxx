@@ -1,8 +1,17 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "entityx/entityx.hh"
 namespace ex = entityx;
@@ -11,43 +20,242 @@ namespace ex = entityx;
 #include "helpers.hxx"
 #include "math.hxx"
 #include "transform.hxx"
+#include "mesh.hxx"
+#include "job_system.hxx"
+#include "matrix_kernels.hxx"
 
-using EntityManager = entityx::EntityX<entityx::DefaultStorage, 0, Transform>;
+// Transforms are stored by the scene tree layers rather than by the entities.
+using EntityManager = entityx::EntityX<entityx::DefaultStorage, 0, Mesh>;
 using Entity = EntityManager::Entity;
 
 using node_index_t = std::size_t;
 auto constexpr kINVALID_INDEX{std::numeric_limits<node_index_t>::max()};
 
-enum class NodeHandle : node_index_t {
-    nINVALID_HANDLE = kINVALID_INDEX
+// The low half of a handle is the index of the node slot and the high half is the slot generation, which is incremented
+// each time the slot is released, so stale handles never alias newer nodes. Handles are plain 64-bit values and can be
+// stored in the GPU side instance data as they are.
+enum class NodeHandle : std::uint64_t {
+    nINVALID_HANDLE = std::numeric_limits<std::uint64_t>::max()
 };
 
+static_assert(std::is_trivially_copyable_v<NodeHandle> && sizeof(NodeHandle) == sizeof(std::uint64_t));
+
+constexpr NodeHandle MakeNodeHandle(std::uint32_t index, std::uint32_t generation) noexcept
+{
+    return static_cast<NodeHandle>(static_cast<std::uint64_t>(generation) << 32 | index);
+}
+
+constexpr std::uint32_t NodeHandleIndex(NodeHandle handle) noexcept
+{
+    return static_cast<std::uint32_t>(static_cast<std::uint64_t>(handle));
+}
+
+constexpr std::uint32_t NodeHandleGeneration(NodeHandle handle) noexcept
+{
+    return static_cast<std::uint32_t>(static_cast<std::uint64_t>(handle) >> 32);
+}
+
 struct Node final {
     node_index_t depth{kINVALID_INDEX};
     node_index_t offset{kINVALID_INDEX};
 
+    // Incremented when the slot is released.
+    std::uint32_t generation{0};
+
+    // The local transform has been changed since the last update.
+    bool dirty{false};
+
+    // Explicit padding, so the nodes are stored to the snapshots without indeterminate bytes.
+    std::array<std::uint8_t, 3> padding{ };
+
     constexpr Node(node_index_t depth, node_index_t offset) : depth{depth}, offset{offset} { }
 
     Node() = default;
 };
 
+static_assert(std::has_unique_object_representations_v<Node>, "the scene tree nodes must not have implicit padding");
+
 struct NodeInfo final {
     NodeHandle parent{NodeHandle::nINVALID_HANDLE};
     NodeHandle handle{NodeHandle::nINVALID_HANDLE};
 
     Entity entity;
 
-    std::string name;
+    // Characters of the name in the names table of the tree, the nodes with equal names share them.
+    struct NameRange final {
+        std::uint32_t offset{0}, length{0};
+    } name;
 
     struct ChildrenRange final {
         node_index_t begin{0}, end{0};
     } children;
 
-    NodeInfo(NodeHandle parent, NodeHandle handle, Entity entity, std::string_view name) : parent{parent}, handle{handle}, entity{entity}, name{name} { }
+    NodeInfo(NodeHandle parent, NodeHandle handle, Entity entity, NameRange name) : parent{parent}, handle{handle}, entity{entity}, name{name} { }
 
     NodeInfo() = default;
 };
 
+// Open addressing hash table with linear probing keyed by the hashes themselves. The slots are a flat array of trivially
+// copyable values, so the table is saved and restored by bulk copies. Equal keys may be inserted several times.
+template<class T>
+class FlatHashTable final {
+public:
+
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    struct slot_t final {
+        std::uint64_t key{0};
+        T value{ };
+        std::uint32_t occupied{0};
+    };
+
+    std::size_t size() const noexcept { return size_; }
+
+    std::vector<slot_t> const &slots() const noexcept { return slots_; }
+
+    void clear() noexcept
+    {
+        std::fill(std::begin(slots_), std::end(slots_), slot_t{ });
+        size_ = 0;
+    }
+
+    // The table is at most half full, so the probe sequences stay short and always end at a free slot.
+    void reserve(std::size_t count)
+    {
+        auto capacity = std::max(std::size(slots_), std::size_t{16});
+
+        while (capacity < count * 2)
+            capacity *= 2;
+
+        if (capacity != std::size(slots_))
+            Rehash(capacity);
+    }
+
+    // Value of the first slot with the key satisfying the predicate or nullptr.
+    template<class P>
+    T *find(std::uint64_t key, P &&predicate) noexcept
+    {
+        auto const i = FindSlot(key, std::forward<P>(predicate));
+
+        return i != kNO_SLOT ? &slots_[i].value : nullptr;
+    }
+
+    template<class P>
+    T const *find(std::uint64_t key, P &&predicate) const noexcept
+    {
+        auto const i = FindSlot(key, std::forward<P>(predicate));
+
+        return i != kNO_SLOT ? &slots_[i].value : nullptr;
+    }
+
+    T *find(std::uint64_t key) noexcept { return find(key, [] (auto &&) { return true; }); }
+    T const *find(std::uint64_t key) const noexcept { return find(key, [] (auto &&) { return true; }); }
+
+    void insert(std::uint64_t key, T const &value)
+    {
+        reserve(size_ + 1);
+
+        auto const mask = std::size(slots_) - 1;
+
+        auto i = static_cast<std::size_t>(key) & mask;
+
+        while (slots_[i].occupied != 0)
+            i = (i + 1) & mask;
+
+        slots_[i] = slot_t{key, value, 1};
+        ++size_;
+    }
+
+    // Erases a single slot with the key, the following slots of the probe sequence are shifted back in its place.
+    void erase(std::uint64_t key) noexcept
+    {
+        auto i = FindSlot(key, [] (auto &&) { return true; });
+
+        if (i == kNO_SLOT)
+            return;
+
+        auto const mask = std::size(slots_) - 1;
+
+        for (auto j = (i + 1) & mask; slots_[j].occupied != 0; j = (j + 1) & mask) {
+            auto const home = static_cast<std::size_t>(slots_[j].key) & mask;
+
+            // The slot may only move back if its home isn't cyclically within (i, j].
+            if (((j - home) & mask) >= ((j - i) & mask)) {
+                slots_[i] = slots_[j];
+                i = j;
+            }
+        }
+
+        slots_[i] = slot_t{ };
+        --size_;
+    }
+
+    // Adopts the slots of a saved table, the table is left intact if they can't be a table made by 'insert'.
+    [[nodiscard]] bool Assign(std::vector<slot_t> &&slots)
+    {
+        auto const capacity = std::size(slots);
+
+        if (capacity != 0 && (capacity < 16 || (capacity & (capacity - 1)) != 0))
+            return false;
+
+        auto const size = static_cast<std::size_t>(std::count_if(std::cbegin(slots), std::cend(slots), [] (auto &&slot) { return slot.occupied != 0; }));
+
+        if (size * 2 > capacity)
+            return false;
+
+        slots_ = std::move(slots);
+        size_ = size;
+
+        return true;
+    }
+
+private:
+
+    static std::size_t constexpr kNO_SLOT{std::numeric_limits<std::size_t>::max()};
+
+    std::vector<slot_t> slots_;
+    std::size_t size_{0};
+
+    template<class P>
+    std::size_t FindSlot(std::uint64_t key, P &&predicate) const noexcept
+    {
+        if (std::empty(slots_))
+            return kNO_SLOT;
+
+        auto const mask = std::size(slots_) - 1;
+
+        for (auto i = static_cast<std::size_t>(key) & mask; slots_[i].occupied != 0; i = (i + 1) & mask) {
+            if (slots_[i].key == key && predicate(slots_[i].value))
+                return i;
+        }
+
+        return kNO_SLOT;
+    }
+
+    void Rehash(std::size_t capacity)
+    {
+        auto slots = std::move(slots_);
+
+        slots_.assign(capacity, slot_t{ });
+        size_ = 0;
+
+        auto const mask = capacity - 1;
+
+        for (auto &&slot : slots) {
+            if (slot.occupied == 0)
+                continue;
+
+            auto i = static_cast<std::size_t>(slot.key) & mask;
+
+            while (slots_[i].occupied != 0)
+                i = (i + 1) & mask;
+
+            slots_[i] = slot;
+            ++size_;
+        }
+    }
+};
+
 class SceneTree final {
 public:
 
@@ -56,41 +264,125 @@ public:
         entities = std::make_unique<EntityManager>();
 
         auto rootEntity = entities->create();
-        rootEntity.assign<Transform>(glm::mat4{1.f}, glm::mat4{1.f});
 
         nodes.emplace_back(0, 0);
-        layers.emplace_back(1, NodeInfo{NodeHandle::nINVALID_HANDLE, root(), rootEntity, name});
+        nodesLookup.emplace_back();
+
+        layers.emplace_back(1, NodeInfo{NodeHandle::nINVALID_HANDLE, root(), rootEntity, StoreName(name)});
+
+        IndexNode(root(), NodeHandle::nINVALID_HANDLE, name);
+
+        layersMatrices.emplace_back();
+        ResizeLayerMatrices(0);
     }
 
-    bool isNodeHandleValid(NodeHandle handle) const noexcept { return handle != NodeHandle::nINVALID_HANDLE; }
+    // The handle refers to a live node of the tree.
+    bool isNodeHandleValid(NodeHandle handle) const noexcept
+    {
+        if (handle == NodeHandle::nINVALID_HANDLE)
+            return false;
 
-    constexpr NodeHandle root() const noexcept { return static_cast<NodeHandle>(0); }
+        auto const index = NodeHandleIndex(handle);
+
+        return index < std::size(nodes) && nodes[index].generation == NodeHandleGeneration(handle) && isNodeValid(nodes[index]);
+    }
+
+    constexpr NodeHandle root() const noexcept { return MakeNodeHandle(0, 0); }
 
     std::optional<NodeHandle> AttachNode(NodeHandle parentHandle, std::string_view name = "noname"sv);
 
+    // Builds the whole hierarchy of an empty tree at once: 'parents[i]' is the index of the node 'i' parent or -1 for the root children.
+    // The layers are laid out breadth-first and sized exactly beforehand. Names and local matrices may be empty or as many as the parents.
+    // Returns the node handles in the order of the indices.
+    std::optional<std::vector<NodeHandle>> BuildHierarchy(std::vector<std::int32_t> const &parents, std::vector<std::string> const &names = { },
+                                                          std::vector<glm::mat4> const &localMatrices = { });
+
+    // Removes the node along with its subtree, the following siblings are moved back to keep the children range contiguous.
+    // The root can't be removed.
     void RemoveNode(NodeHandle handle);
+
+    // Removes the whole subtree of the node, the released slots are reused by the next attached nodes.
     void DestroyChildren(NodeHandle handle);
 
+    // Binary image of the hierarchy: the nodes, the layer slots, the names table, the poses, the matrices and the lookup tables.
+    // The entity components aren't included.
+    [[nodiscard]] std::vector<std::byte> SaveSnapshot() const;
+
+    // Replaces the tree by the snapshot made by the same build, e.g. a memory mapped one. The arrays and the lookup tables are restored
+    // by bulk copies without per-node allocations, the free slots of a layer are only gathered once a node is attached to or removed from it.
+    // New entities are created for the live nodes in a single batch, it's the only work linear in the nodes number beside the validation.
+    // The tree is left intact if the snapshot is malformed.
+    [[nodiscard]] bool RestoreSnapshot(std::byte const *data, std::size_t size);
+
+    // Defragments the layers in a single pass over each of them: the free slots are dropped and the children ranges
+    // follow the order of their parents, so the siblings stay contiguous. Handles stay valid.
+    void Compact();
+
     void SetName(NodeHandle handle, std::string_view name);
 
+    // The view is valid until the names are changed or the tree is compacted.
+    std::optional<std::string_view> GetName(NodeHandle handle) const;
+
+    // Hashed lookups of the nodes by the name or by the path of names from the root separated by slashes, e.g. "root/room/lamp".
+    // If several nodes match, any of them may be returned.
+    std::optional<NodeHandle> FindNode(std::string_view name) const;
+    std::optional<NodeHandle> FindNodeByPath(std::string_view path) const;
+
+    // Batch versions of the lookups, the handles of the missing nodes are invalid ones.
+    std::vector<NodeHandle> FindNodes(std::vector<std::string_view> const &names) const;
+    std::vector<NodeHandle> FindNodesByPath(std::vector<std::string_view> const &paths) const;
+
     template<class T, class... Ts>
     void AddComponent(NodeHandle handle, Ts &&...args)
     {
         if (!isNodeHandleValid(handle))
             return;
 
-        auto &&node = nodes.at(static_cast<std::size_t>(handle));
+        auto &&node = nodes.at(NodeHandleIndex(handle));
 
-        if (!isNodeValid(node))
-            return;
+        if constexpr (std::is_same_v<T, Transform>) {
+            Transform const transform{std::forward<Ts>(args)...};
+
+            auto &&matrices = layersMatrices.at(node.depth);
+
+            matrices.localMatrices.at(node.offset) = transform.localMatrix;
+            matrices.worldMatrices.at(node.offset) = transform.worldMatrix;
+
+            matrices.posesDirty.at(node.offset) = 0;
 
-        auto &&layer = layers.at(node.depth);
-        auto &&info = layer.at(node.offset);
+            MarkDirty(handle);
+        }
 
-        info.entity.assign<T>(std::forward<Ts>(args)...);
+        else {
+            auto &&layer = layers.at(node.depth);
+            auto &&info = layer.at(node.offset);
+
+            info.entity.assign<T>(std::forward<Ts>(args)...);
+        }
     }
 
-    void Update();
+    // Marks the node dirty, its world matrix and the whole subtree ones are recomputed by the next update.
+    void SetLocalMatrix(NodeHandle handle, glm::mat4 const &localMatrix);
+
+    // Same as the above but the local matrix is composed from the pose by the next update,
+    // so setting the pose several times per frame costs a single composition.
+    void SetLocalPose(NodeHandle handle, node_pose_t const &pose);
+
+    // The last pose set, the local matrices set directly don't change it.
+    std::optional<node_pose_t> GetLocalPose(NodeHandle handle) const;
+
+    std::optional<glm::mat4> GetWorldMatrix(NodeHandle handle) const;
+
+    // Number of the node slots, the node indices of the handles are below it.
+    std::size_t nodesNumber() const noexcept { return std::size(nodes); }
+
+    // World matrices of 'count' consecutive node slots starting at 'nodeIndex', the released slots get identity matrices.
+    void CopyWorldMatrices(std::uint32_t nodeIndex, std::size_t count, glm::mat4 *worldMatrices) const;
+
+    // Recomputes world matrices of the dirty nodes and their descendants layer by layer touching only the dirty ranges.
+    // The dirty ranges of a layer are split into chunks processed by the job system if one is given, with a barrier between the layers.
+    // Returns the nodes whose world matrices have been changed in no particular order, the list is valid until the next update.
+    std::vector<NodeHandle> const &Update(JobSystem *jobSystem = nullptr);
 
 private:
     std::unique_ptr<EntityManager> entities;
@@ -99,11 +391,103 @@ private:
 
     std::vector<Node> nodes;
 
+    // Node names packed one after another, each distinct name is stored once.
+    std::string namesTable;
+
+    FlatHashTable<NodeInfo::NameRange> internedNames;
+
+    NodeInfo::NameRange StoreName(std::string_view name);
+
+    // Rebuilds the names table from the names of the live nodes.
+    void InternNames();
+
+    static std::uint32_t constexpr kNO_NODE{std::numeric_limits<std::uint32_t>::max()};
+
+    // The nodes whose names or paths have the same hash are chained, the indices hold the first node of each chain.
+    struct node_lookup_t final {
+        std::uint64_t nameHash{0};
+        std::uint64_t pathHash{0};
+
+        struct chain_t final {
+            std::uint32_t previous{kNO_NODE}, next{kNO_NODE};
+        } nameChain, pathChain;
+    };
+
+    // Parallel to the nodes.
+    std::vector<node_lookup_t> nodesLookup;
+
+    using lookup_index_t = FlatHashTable<std::uint32_t>;
+    using lookup_chain_t = node_lookup_t::chain_t node_lookup_t::*;
+
+    lookup_index_t nodesByName;
+    lookup_index_t nodesByPath;
+
+    // Adds the node to the indices, the parent has to be indexed already.
+    void IndexNode(NodeHandle handle, NodeHandle parentHandle, std::string_view name);
+
+    // Rehashes the paths of the node and its subtree after the node has been renamed.
+    void ReindexPaths(NodeHandle handle);
+
+    void Link(lookup_index_t &index, lookup_chain_t chain, std::uint64_t hash, std::uint32_t nodeIndex);
+    void Unlink(lookup_index_t &index, lookup_chain_t chain, std::uint64_t hash, std::uint32_t nodeIndex);
+
+    std::optional<NodeHandle> FindNode(std::uint64_t hash, std::string_view name) const;
+    std::optional<NodeHandle> FindNodeByPath(std::uint64_t hash, std::string_view path) const;
+
     using layer_t = std::vector<NodeInfo>;
     std::vector<layer_t> layers;
 
+    // Local and world matrices of the nodes in the order of their layer, each matrix takes exactly one cache line.
+    // The local matrices of the nodes with dirty poses are composed by the update before being used.
+    struct layer_matrices_t final {
+        using matrices_t = std::vector<glm::mat4, aligned_allocator<glm::mat4, kCACHE_LINE_SIZE>>;
+
+        matrices_t localMatrices;
+        matrices_t worldMatrices;
+
+        std::vector<node_pose_t> localPoses;
+        std::vector<std::uint8_t> posesDirty;
+    };
+
+    std::vector<layer_matrices_t> layersMatrices;
+
+    // Marks the layer slot free for reuse by AttachNode.
+    void FreeSlot(std::size_t depth, node_index_t offset);
+
+    // Keeps the layer matrices as many as the layer nodes, the added ones are identity transforms.
+    void ResizeLayerMatrices(std::size_t depth);
+
     bool isNodeValid(Node node) const noexcept { return node.depth != kINVALID_INDEX && node.offset != kINVALID_INDEX; }
 
+    // Indices of the released node slots reused by the next allocated nodes.
+    std::vector<std::uint32_t> freeNodes;
+
+    NodeHandle AllocateNode(node_index_t depth, node_index_t offset);
+
+    // Invalidates the node and all the handles to it.
+    void ReleaseNode(NodeHandle handle);
+
+    void MarkDirty(NodeHandle handle);
+
+    std::vector<NodeHandle> dirtyNodes;
+    std::vector<NodeHandle> changedNodes;
+
+    // Ranges of nodes to be updated in each layer, kept between updates to reuse the memory.
+    using range_t = std::pair<node_index_t, node_index_t>;
+    std::vector<std::vector<range_t>> layersDirtyRanges;
+
+    std::vector<range_t> updateChunks;
+
+    // Output of the chunks updated by a thread, merged after each layer.
+    struct alignas(kCACHE_LINE_SIZE) update_scratch_t final {
+        std::vector<NodeHandle> changedNodes;
+        std::vector<range_t> childrenRanges;
+    };
+
+    std::vector<update_scratch_t> updateScratches;
+
+    void UpdateRange(std::size_t depth, range_t range, update_scratch_t &scratch);
+
 #if 0
     struct chunk_t final {
         node_index_t begin{0}, end{0};
@@ -142,4 +526,9 @@ private:
 
     using chunks_t = std::set<node_index_t>;
     std::vector<chunks_t> layersChunks;
+
+    // The free slots of the restored layers are gathered on the first use of their chunks.
+    std::vector<std::uint8_t> layersChunksStale;
+
+    chunks_t &LayerChunks(std::size_t depth);
 };
\ No newline at end of file
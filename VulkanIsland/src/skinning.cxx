@@ -0,0 +1,243 @@
+#include <algorithm>
+#include <utility>
+
+#if defined(__AVX__)
+#define USE_AVX_SKINNING
+#include <immintrin.h>
+#endif
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define USE_SSE_SKINNING
+#include <xmmintrin.h>
+#endif
+
+#include "skinning.hxx"
+
+namespace {
+auto constexpr kINFLUENCES_NUMBER = 4u;
+
+#ifdef USE_SSE_SKINNING
+auto constexpr kBATCH_SIZE = 4u;
+
+#ifdef USE_AVX_SKINNING
+// Each vector holds a pair of the blended matrix columns, so a half of the instructions is needed.
+struct blended_matrix_t {
+    __m256 columns01, columns23;
+};
+
+inline __m256 MultiplyAdd(__m256 a, __m256 b, __m256 c)
+{
+#ifdef __FMA__
+    return _mm256_fmadd_ps(a, b, c);
+#else
+    return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+
+inline blended_matrix_t BlendMatrix(skinned_mesh_t const &mesh, float const *palette, std::size_t vertex)
+{
+    auto columns01 = _mm256_setzero_ps();
+    auto columns23 = _mm256_setzero_ps();
+
+    for (auto influence = 0u; influence < kINFLUENCES_NUMBER; ++influence) {
+        auto const weight = _mm256_set1_ps(mesh.weights[vertex * kINFLUENCES_NUMBER + influence]);
+        auto const matrix = palette + mesh.joints[vertex * kINFLUENCES_NUMBER + influence] * 16;
+
+        columns01 = MultiplyAdd(weight, _mm256_loadu_ps(matrix + 0), columns01);
+        columns23 = MultiplyAdd(weight, _mm256_loadu_ps(matrix + 8), columns23);
+    }
+
+    return {columns01, columns23};
+}
+
+// Components are broadcasted to all the lanes, 'w' is one for positions and zero for normals.
+inline __m128 TransformVector(blended_matrix_t const &matrix, __m128 x, __m128 y, __m128 z, __m128 w)
+{
+    auto const xy = _mm256_insertf128_ps(_mm256_castps128_ps256(x), y, 1);
+    auto const zw = _mm256_insertf128_ps(_mm256_castps128_ps256(z), w, 1);
+
+    auto const vector = MultiplyAdd(matrix.columns01, xy, _mm256_mul_ps(matrix.columns23, zw));
+
+    return _mm_add_ps(_mm256_castps256_ps128(vector), _mm256_extractf128_ps(vector, 1));
+}
+#else
+struct blended_matrix_t {
+    __m128 columns[4];
+};
+
+inline blended_matrix_t BlendMatrix(skinned_mesh_t const &mesh, float const *palette, std::size_t vertex)
+{
+    blended_matrix_t blended;
+    std::fill(std::begin(blended.columns), std::end(blended.columns), _mm_setzero_ps());
+
+    for (auto influence = 0u; influence < kINFLUENCES_NUMBER; ++influence) {
+        auto const weight = _mm_set1_ps(mesh.weights[vertex * kINFLUENCES_NUMBER + influence]);
+        auto const matrix = palette + mesh.joints[vertex * kINFLUENCES_NUMBER + influence] * 16;
+
+        for (auto column = 0u; column < 4u; ++column)
+            blended.columns[column] = _mm_add_ps(blended.columns[column], _mm_mul_ps(weight, _mm_loadu_ps(matrix + column * 4)));
+    }
+
+    return blended;
+}
+
+inline __m128 TransformVector(blended_matrix_t const &matrix, __m128 x, __m128 y, __m128 z, __m128 w)
+{
+    auto const xy = _mm_add_ps(_mm_mul_ps(matrix.columns[0], x), _mm_mul_ps(matrix.columns[1], y));
+    auto const zw = _mm_add_ps(_mm_mul_ps(matrix.columns[2], z), _mm_mul_ps(matrix.columns[3], w));
+
+    return _mm_add_ps(xy, zw);
+}
+#endif
+
+// Tightly packed vectors of four vertices taking exactly three SIMD loads or stores.
+struct vector_batch_t {
+    __m128 vectors[3];
+};
+
+inline vector_batch_t LoadBatch(float const *src)
+{
+    return {{_mm_loadu_ps(src + 0), _mm_loadu_ps(src + 4), _mm_loadu_ps(src + 8)}};
+}
+
+// The vectors are (x, y, z, *), the components are shuffled into the packed layout in registers.
+inline void StoreBatch(float *dst, __m128 const (&vectors)[kBATCH_SIZE])
+{
+    auto const z0x1 = _mm_shuffle_ps(vectors[0], vectors[1], _MM_SHUFFLE(0, 0, 2, 2));
+    auto const z2x3 = _mm_shuffle_ps(vectors[2], vectors[3], _MM_SHUFFLE(0, 0, 2, 2));
+
+    _mm_storeu_ps(dst + 0, _mm_shuffle_ps(vectors[0], z0x1, _MM_SHUFFLE(2, 0, 1, 0)));
+    _mm_storeu_ps(dst + 4, _mm_shuffle_ps(vectors[1], vectors[2], _MM_SHUFFLE(1, 0, 2, 1)));
+    _mm_storeu_ps(dst + 8, _mm_shuffle_ps(z2x3, vectors[3], _MM_SHUFFLE(2, 1, 2, 0)));
+}
+
+// Component 'C' of the vertex 'V' of the batch broadcasted to all the lanes.
+template<std::size_t V, std::size_t C>
+inline __m128 Broadcast(vector_batch_t const &batch)
+{
+    auto constexpr element = V * 3 + C;
+    auto constexpr lane = element % 4;
+
+    auto const vector = batch.vectors[element / 4];
+
+    return _mm_shuffle_ps(vector, vector, _MM_SHUFFLE(lane, lane, lane, lane));
+}
+
+template<std::size_t V>
+inline __m128 TransformBatchVector(blended_matrix_t const &matrix, vector_batch_t const &batch, __m128 w)
+{
+    return TransformVector(matrix, Broadcast<V, 0>(batch), Broadcast<V, 1>(batch), Broadcast<V, 2>(batch), w);
+}
+
+// Each vertex matrix is consumed right after blending to keep the batch in registers.
+template<std::size_t... V>
+void SkinBatch(skinned_mesh_t const &mesh, float const *palette, std::size_t vertex, bool normals, std::index_sequence<V...>)
+{
+    auto const positionsBatch = LoadBatch(mesh.positions + vertex * 3);
+    auto const normalsBatch = normals ? LoadBatch(mesh.normals + vertex * 3) : vector_batch_t{ };
+
+    __m128 skinnedPositions[kBATCH_SIZE], skinnedNormals[kBATCH_SIZE]{ };
+
+    ([&]
+    {
+        auto const matrix = BlendMatrix(mesh, palette, vertex + V);
+
+        skinnedPositions[V] = TransformBatchVector<V>(matrix, positionsBatch, _mm_set1_ps(1.f));
+
+        if (normals)
+            skinnedNormals[V] = TransformBatchVector<V>(matrix, normalsBatch, _mm_setzero_ps());
+    }(), ...);
+
+    StoreBatch(mesh.skinnedPositions + vertex * 3, skinnedPositions);
+
+    if (normals)
+        StoreBatch(mesh.skinnedNormals + vertex * 3, skinnedNormals);
+}
+
+void TransformVertex(blended_matrix_t const &matrix, float const *src, float *dst, float w)
+{
+    auto const vector = TransformVector(matrix, _mm_set1_ps(src[0]), _mm_set1_ps(src[1]), _mm_set1_ps(src[2]), _mm_set1_ps(w));
+
+    alignas(16) std::array<float, 4> result;
+    _mm_store_ps(std::data(result), vector);
+
+    std::copy_n(std::cbegin(result), 3, dst);
+}
+
+// Skins four vertices per iteration, the rest ones are skinned one by one.
+void SkinVerticesSIMD(skinned_mesh_t const &mesh)
+{
+    auto const palette = glm::value_ptr(*mesh.palette);
+    auto const normals = mesh.normals != nullptr && mesh.skinnedNormals != nullptr;
+
+    std::size_t vertex = 0;
+
+    for (; vertex + kBATCH_SIZE <= mesh.vertexCount; vertex += kBATCH_SIZE)
+        SkinBatch(mesh, palette, vertex, normals, std::make_index_sequence<kBATCH_SIZE>{});
+
+    for (; vertex < mesh.vertexCount; ++vertex) {
+        auto const matrix = BlendMatrix(mesh, palette, vertex);
+
+        TransformVertex(matrix, mesh.positions + vertex * 3, mesh.skinnedPositions + vertex * 3, 1.f);
+
+        if (normals)
+            TransformVertex(matrix, mesh.normals + vertex * 3, mesh.skinnedNormals + vertex * 3, 0.f);
+    }
+}
+#else
+void SkinVerticesScalar(skinned_mesh_t const &mesh)
+{
+    auto const palette = glm::value_ptr(*mesh.palette);
+
+    for (std::size_t vertex = 0; vertex < mesh.vertexCount; ++vertex) {
+        // Column-major elements of the blended matrix: 'column * 3 + row'.
+        std::array<float, 12> blended{};
+
+        for (auto influence = 0u; influence < kINFLUENCES_NUMBER; ++influence) {
+            auto const weight = mesh.weights[vertex * kINFLUENCES_NUMBER + influence];
+            auto const matrix = palette + mesh.joints[vertex * kINFLUENCES_NUMBER + influence] * 16;
+
+            for (auto column = 0u; column < 4u; ++column)
+                for (auto row = 0u; row < 3u; ++row)
+                    blended[column * 3 + row] += weight * matrix[column * 4 + row];
+        }
+
+        auto const transform = [&blended, vertex] (float const *src, float *dst, bool translate)
+        {
+            auto const vector = src + vertex * 3;
+
+            for (auto row = 0u; row < 3u; ++row) {
+                dst[vertex * 3 + row] = blended[0 + row] * vector[0] + blended[3 + row] * vector[1] + blended[6 + row] * vector[2] +
+                                        (translate ? blended[9 + row] : 0.f);
+            }
+        };
+
+        transform(mesh.positions, mesh.skinnedPositions, true);
+
+        if (mesh.normals != nullptr && mesh.skinnedNormals != nullptr)
+            transform(mesh.normals, mesh.skinnedNormals, false);
+    }
+}
+#endif
+}
+
+void SkinVertices(skinned_mesh_t const &mesh)
+{
+    if (mesh.vertexCount == 0 || mesh.palette == nullptr)
+        return;
+
+#ifdef USE_SSE_SKINNING
+    SkinVerticesSIMD(mesh);
+#else
+    SkinVerticesScalar(mesh);
+#endif
+}
+
+void SkinMeshes(JobSystem &jobSystem, std::vector<skinned_mesh_t> const &meshes)
+{
+    jobSystem.ParallelFor(std::size(meshes), 1, [&meshes] (std::size_t begin, std::size_t end, std::size_t)
+    {
+        for (auto index = begin; index < end; ++index)
+            SkinVertices(meshes[index]);
+    });
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "main.hxx"
+#include "math.hxx"
+#include "job_system.hxx"
+
+
+// Vertices of a skinned mesh: tightly packed positions and optional normals, four joint indices and weights per vertex.
+// The weights of each vertex are expected to sum up to one.
+struct skinned_mesh_t {
+    std::size_t vertexCount{0};
+
+    float const *positions{nullptr};
+    float const *normals{nullptr};
+
+    std::uint16_t const *joints{nullptr};
+    float const *weights{nullptr};
+
+    // Skinning matrices indexed by the joint indices.
+    glm::mat4 const *palette{nullptr};
+
+    float *skinnedPositions{nullptr};
+    float *skinnedNormals{nullptr};
+};
+
+// Linear blend skinning of the mesh vertices, four vertices are skinned per iteration with three SIMD loads and stores
+// of their tightly packed vectors. AVX builds blend a pair of the matrix columns per instruction.
+// Normals are transformed by the blended matrix as is, so they have to be renormalized if the palette has a non-uniform scale.
+void SkinVertices(skinned_mesh_t const &mesh);
+
+// Skins the meshes on the job system threads, each mesh is a job taken by a single thread.
+void SkinMeshes(JobSystem &jobSystem, std::vector<skinned_mesh_t> const &meshes);
@@ -9,6 +9,13 @@ namespace ex = entityx;
 #include "helpers.hxx"
 #include "math.hxx"
 
+// Local transform as translation, rotation and scale.
+struct node_pose_t {
+    glm::vec3 translation{0.f};
+    glm::quat rotation{1.f, 0.f, 0.f, 0.f};
+    glm::vec3 scale{1.f};
+};
+
 struct Transform final {
     glm::mat4 localMatrix;
     glm::mat4 worldMatrix;
@@ -0,0 +1,145 @@
+#include <algorithm>
+
+#include "world_matrices_buffer.hxx"
+
+
+void CoalesceNodeRuns(std::vector<std::uint32_t> &nodeIndices, std::uint32_t maxGap, std::vector<std::pair<std::uint32_t, std::uint32_t>> &runs)
+{
+    runs.clear();
+
+    std::sort(std::begin(nodeIndices), std::end(nodeIndices));
+
+    for (auto index : nodeIndices) {
+        if (!std::empty(runs) && index <= runs.back().second + maxGap)
+            runs.back().second = std::max(runs.back().second, index + 1);
+
+        else runs.emplace_back(index, index + 1);
+    }
+}
+
+bool WorldMatricesBuffer::Sync(SceneTree const &tree, std::vector<NodeHandle> const &changedNodes, VkCommandBuffer commandBuffer,
+                               std::vector<std::shared_ptr<VulkanBuffer>> &inFlightBuffers)
+{
+    auto constexpr kMATRIX_SIZE = static_cast<VkDeviceSize>(sizeof(glm::mat4));
+
+    uploadedSize_ = 0;
+
+    auto const nodesNumber = tree.nodesNumber();
+
+    // The new buffer has no matrices at all, so all of them are uploaded.
+    if (nodesNumber > capacity_) {
+        auto const capacity = std::max(nodesNumber, capacity_ * 2);
+
+        auto const usageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+        auto constexpr propertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+        // The frames submitted earlier may still read the replaced buffer.
+        if (buffer_)
+            inFlightBuffers.push_back(std::move(buffer_));
+
+        buffer_ = device_.resourceManager().CreateBuffer(capacity * kMATRIX_SIZE, usageFlags, propertyFlags);
+
+        if (!buffer_) {
+            capacity_ = 0;
+
+            std::cerr << "failed to create world matrices buffer\n"s;
+            return false;
+        }
+
+        capacity_ = capacity;
+        uploadAll_ = true;
+    }
+
+    if (uploadAll_) {
+        runs_.assign(1, {0u, static_cast<std::uint32_t>(nodesNumber)});
+        uploadAll_ = false;
+    }
+
+    else {
+        nodeIndices_.clear();
+
+        for (auto handle : changedNodes)
+            if (tree.isNodeHandleValid(handle))
+                nodeIndices_.push_back(NodeHandleIndex(handle));
+
+        CoalesceNodeRuns(nodeIndices_, kMAX_COPY_GAP, runs_);
+    }
+
+    if (std::empty(runs_))
+        return true;
+
+    std::size_t stagedNumber = 0;
+
+    for (auto [begin, end] : runs_)
+        stagedNumber += end - begin;
+
+    // A staging buffer per sync, the previous ones may still be read by the copies in flight.
+    auto constexpr usageFlags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    auto constexpr propertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    auto stagingBuffer = device_.resourceManager().CreateBuffer(stagedNumber * kMATRIX_SIZE, usageFlags, propertyFlags);
+
+    if (!stagingBuffer) {
+        std::cerr << "failed to create world matrices staging buffer\n"s;
+        return false;
+    }
+
+    void *data;
+
+    if (auto result = vkMapMemory(device_.handle(), stagingBuffer->memory()->handle(), stagingBuffer->memory()->offset(), stagingBuffer->memory()->size(), 0, &data); result != VK_SUCCESS) {
+        std::cerr << "failed to map world matrices staging buffer memory: "s << result << '\n';
+        return false;
+    }
+
+    // The runs are staged back to back, each one is copied by a region of its own.
+    auto stagedMatrices = reinterpret_cast<glm::mat4 *>(data);
+
+    copyRegions_.clear();
+
+    VkDeviceSize srcOffset = 0;
+
+    for (auto [begin, end] : runs_) {
+        tree.CopyWorldMatrices(begin, end - begin, stagedMatrices);
+
+        stagedMatrices += end - begin;
+
+        auto const size = (end - begin) * kMATRIX_SIZE;
+
+        copyRegions_.push_back(VkBufferCopy{srcOffset, begin * kMATRIX_SIZE, size});
+
+        srcOffset += size;
+    }
+
+    vkUnmapMemory(device_.handle(), stagingBuffer->memory()->handle());
+
+    // The vertex shaders of the frames submitted earlier may still read the matrices being overwritten.
+    VkBufferMemoryBarrier const readBarrier{
+        VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        nullptr,
+        0, VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+        buffer_->handle(),
+        0, VK_WHOLE_SIZE
+    };
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 1, &readBarrier, 0, nullptr);
+
+    vkCmdCopyBuffer(commandBuffer, stagingBuffer->handle(), buffer_->handle(), static_cast<std::uint32_t>(std::size(copyRegions_)), std::data(copyRegions_));
+
+    VkBufferMemoryBarrier const writeBarrier{
+        VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        nullptr,
+        VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+        buffer_->handle(),
+        0, VK_WHOLE_SIZE
+    };
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, 0, 0, nullptr, 1, &writeBarrier, 0, nullptr);
+
+    inFlightBuffers.push_back(std::move(stagingBuffer));
+
+    uploadedSize_ = srcOffset;
+
+    return true;
+}
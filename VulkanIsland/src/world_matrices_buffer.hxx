@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "main.hxx"
+#include "device.hxx"
+#include "buffer.hxx"
+#include "resource.hxx"
+#include "scene_tree.hxx"
+
+
+// Runs of consecutive nodes closer than this are copied as a single region along with the unchanged matrices in between.
+auto constexpr kMAX_COPY_GAP = 4u;
+
+// Sorts the node indices and merges them into [begin, end) runs, the runs separated by at most 'maxGap' nodes are merged as well.
+void CoalesceNodeRuns(std::vector<std::uint32_t> &nodeIndices, std::uint32_t maxGap, std::vector<std::pair<std::uint32_t, std::uint32_t>> &runs);
+
+// Device local storage buffer of the scene tree world matrices indexed by the node indices of the handles.
+// Only the matrices changed by the last tree update are uploaded, so the upload size follows the motion rather than the scene size.
+class WorldMatricesBuffer final {
+public:
+
+    WorldMatricesBuffer(VulkanDevice &device) noexcept : device_{device} { }
+
+    // Stages the world matrices of the changed nodes and records their copies between the barriers against the vertex shaders reads.
+    // The staging buffer and the buffer replaced by a grown one are appended to 'inFlightBuffers',
+    // the caller keeps them alive until the recorded commands and the frames submitted before them have completed.
+    // The buffer is recreated and uploaded as a whole when the tree outgrows it, the descriptors have to be updated then.
+    [[nodiscard]] bool Sync(SceneTree const &tree, std::vector<NodeHandle> const &changedNodes, VkCommandBuffer commandBuffer,
+                            std::vector<std::shared_ptr<VulkanBuffer>> &inFlightBuffers);
+
+    // The next sync uploads all the matrices, e.g. after the tree has been restored from a snapshot.
+    void Invalidate() noexcept { uploadAll_ = true; }
+
+    std::shared_ptr<VulkanBuffer> buffer() const noexcept { return buffer_; }
+
+    // Bytes uploaded by the last sync.
+    VkDeviceSize uploadedSize() const noexcept { return uploadedSize_; }
+
+private:
+    VulkanDevice &device_;
+
+    std::shared_ptr<VulkanBuffer> buffer_;
+
+    // Capacity of the buffer in matrices.
+    std::size_t capacity_{0};
+
+    VkDeviceSize uploadedSize_{0};
+
+    bool uploadAll_{true};
+
+    std::vector<std::uint32_t> nodeIndices_;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> runs_;
+    std::vector<VkBufferCopy> copyRegions_;
+};
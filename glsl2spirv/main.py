@@ -13,16 +13,22 @@ glslangValidatorPath = 'glslangValidator'
 shadersDirectory = "{}/../{}".format(os.path.dirname(os.path.realpath(__file__)), "shaders/")
 
 vertPath = "{}shader.vert".format(shadersDirectory)
+quantizedVertPath = "{}shader_quantized.vert".format(shadersDirectory)
 fragPath = "{}shader.frag".format(shadersDirectory)
 
 vertSpvPath = "{}vert.spv".format(shadersDirectory)
+quantizedVertSpvPath = "{}vert_quantized.spv".format(shadersDirectory)
 fragSpvPath = "{}frag.spv".format(shadersDirectory)
 
 if not os.path.exists(vertSpvPath):
     open(vertSpvPath, 'x').close()
 
+if not os.path.exists(quantizedVertSpvPath):
+    open(quantizedVertSpvPath, 'x').close()
+
 if not os.path.exists(fragSpvPath):
     open(fragSpvPath, 'x').close()
 
 call([glslangValidatorPath, "-V", vertPath, "-o", vertSpvPath])
+call([glslangValidatorPath, "-V", quantizedVertPath, "-o", quantizedVertSpvPath])
 call([glslangValidatorPath, "-V", fragPath, "-o", fragSpvPath])
@@ -4,17 +4,25 @@
 layout(early_fragment_tests) in;
 
 layout(set = 0, binding = 0) uniform TRANSFORMS {
-    mat4 model;
     mat4 view;
     mat4 proj;
-    mat4 modelView;
 } transforms;
 
-layout(set = 0, binding = 1) uniform sampler2D textureSampler;
+struct Material {
+    vec4 baseColorFactor;
+};
+
+layout(set = 0, binding = 1, std430) readonly buffer MATERIALS {
+    Material materials[];
+};
+
+// Per material descriptor set.
+layout(set = 1, binding = 0) uniform sampler2D baseColorTexture;
 
 layout(location = 0) in vec3 viewSpaceNormal;
 layout(location = 1) in vec2 texCoord1;
 layout(location = 2) in vec3 viewSpacePosition;
+layout(location = 3) flat in int materialIndex;
 
 layout(location = 0) out vec4 fragColor;
 
@@ -37,7 +45,7 @@ void main()
     //fragColor = vec4(vec3(viewSpaceNormal * 0.5 + 0.5), 1.0);
     //fragColor = vec4(texCoord, texCoord.y / texCoord.x, 1.0);
     vec2 texCoord = texCoord1 * vec2(1, -1);
-    fragColor = texture(textureSampler, texCoord);
+    fragColor = texture(baseColorTexture, texCoord) * materials[materialIndex].baseColorFactor;
 
     //fragColor.rgb = viewSpacePosition / 100.0;
     //fragColor.a = 1.0;
@@ -6,15 +6,39 @@ layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec2 inUV;
 
 layout(set = 0, binding = 0) uniform TRANSFORMS {
-    mat4 model;
     mat4 view;
     mat4 proj;
-    mat4 modelView;
 } transforms;
 
+struct Draw {
+    vec4 positionScale;
+    vec4 positionOffset;
+    ivec4 material;
+};
+
+layout(set = 0, binding = 2, std430) readonly buffer DRAWS {
+    Draw draws[];
+};
+
+// Instances of all draws, the instance index includes the first instance of the indirect draw command.
+// The draw index is followed by the node index of the instance world matrix.
+struct Instance {
+    uvec4 draw;
+};
+
+layout(set = 0, binding = 3, std430) readonly buffer INSTANCES {
+    Instance instances[];
+};
+
+// World matrices of the scene tree nodes.
+layout(set = 0, binding = 4, std430) readonly buffer WORLD_MATRICES {
+    mat4 worldMatrices[];
+};
+
 layout(location = 0) out vec3 viewSpaceNormal;
 layout(location = 1) out vec2 texCoord;
 layout(location = 2) out vec3 viewSpacePosition;
+layout(location = 3) flat out int materialIndex;
 
 out gl_PerVertex {
     vec4 gl_Position;
@@ -22,12 +46,18 @@ out gl_PerVertex {
 
 void main()
 {
-    gl_Position = transforms.view * transforms.model * vec4(inVertex, 1.0);
+    Instance instance = instances[gl_InstanceIndex];
+
+    mat4 modelView = transforms.view * worldMatrices[instance.draw.y];
+
+    gl_Position = modelView * vec4(inVertex, 1.0);
 
     viewSpacePosition = gl_Position.xyz;
 
     gl_Position = transforms.proj * gl_Position;
 
-    viewSpaceNormal = normalize((transpose(inverse(transforms.modelView)) * vec4(inNormal, 0.0)).xyz);
+    viewSpaceNormal = normalize((transpose(inverse(modelView)) * vec4(inNormal, 0.0)).xyz);
     texCoord = vec2(inUV.x, inUV.y);
+
+    materialIndex = draws[instance.draw.x].material.x;
 }
\ No newline at end of file
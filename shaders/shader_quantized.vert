@@ -0,0 +1,77 @@
+#version 460
+#extension GL_ARB_separate_shader_objects : enable
+
+// Normalized positions, octahedral encoded normals and half float texture coordinates.
+layout(location = 0) in vec3 inVertex;
+layout(location = 1) in vec2 inNormal;
+layout(location = 2) in vec2 inUV;
+
+layout(set = 0, binding = 0) uniform TRANSFORMS {
+    mat4 view;
+    mat4 proj;
+} transforms;
+
+struct Draw {
+    vec4 positionScale;
+    vec4 positionOffset;
+    ivec4 material;
+};
+
+layout(set = 0, binding = 2, std430) readonly buffer DRAWS {
+    Draw draws[];
+};
+
+// Instances of all draws, the instance index includes the first instance of the indirect draw command.
+// The draw index is followed by the node index of the instance world matrix.
+struct Instance {
+    uvec4 draw;
+};
+
+layout(set = 0, binding = 3, std430) readonly buffer INSTANCES {
+    Instance instances[];
+};
+
+// World matrices of the scene tree nodes.
+layout(set = 0, binding = 4, std430) readonly buffer WORLD_MATRICES {
+    mat4 worldMatrices[];
+};
+
+layout(location = 0) out vec3 viewSpaceNormal;
+layout(location = 1) out vec2 texCoord;
+layout(location = 2) out vec3 viewSpacePosition;
+layout(location = 3) flat out int materialIndex;
+
+out gl_PerVertex {
+    vec4 gl_Position;
+};
+
+vec3 decodeOctahedral(vec2 encoded)
+{
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+
+    float t = max(-normal.z, 0.0);
+    normal.xy += mix(vec2(t), vec2(-t), greaterThanEqual(normal.xy, vec2(0.0)));
+
+    return normalize(normal);
+}
+
+void main()
+{
+    Instance instance = instances[gl_InstanceIndex];
+    Draw draw = draws[instance.draw.x];
+
+    vec3 position = inVertex * draw.positionScale.xyz + draw.positionOffset.xyz;
+
+    mat4 modelView = transforms.view * worldMatrices[instance.draw.y];
+
+    gl_Position = modelView * vec4(position, 1.0);
+
+    viewSpacePosition = gl_Position.xyz;
+
+    gl_Position = transforms.proj * gl_Position;
+
+    viewSpaceNormal = normalize((transpose(inverse(modelView)) * vec4(decodeOctahedral(inNormal), 0.0)).xyz);
+    texCoord = vec2(inUV.x, inUV.y);
+
+    materialIndex = draw.material.x;
+}